@@ -0,0 +1,117 @@
+#include "bitmap_convert.hpp"
+#include <android/bitmap.h>
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ncnn/mat.h"
+
+#define LOG_TAG "bitmap_convert"
+
+size_t tensor_bytes(const TensorSpec& spec) {
+    const size_t elem = spec.type == TensorType::Float32 ? 4 : 1;
+    return elem * 3 * (size_t)std::max(spec.w, 0) * (size_t)std::max(spec.h, 0);
+}
+
+bool bitmap_to_rgba(JNIEnv* env, jobject bitmap, uint8_t* out, size_t capacity) {
+    AndroidBitmapInfo info;
+    if (!out || AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return false;
+    const size_t row = (size_t)info.width * 4;
+    if (capacity < row * info.height) return false;
+
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        ncnn::Mat m = ncnn::Mat::from_android_bitmap(env, bitmap, ncnn::Mat::PIXEL_RGBA);
+        if (m.empty()) return false;
+        m.to_pixels(out, ncnn::Mat::PIXEL_RGBA);
+        return true;
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) return false;
+    const uint8_t* src = (const uint8_t*)pixels;
+    if (info.stride == row) {
+        std::memcpy(out, src, row * info.height);
+    } else {
+        for (uint32_t y = 0; y < info.height; ++y) {
+            std::memcpy(out + y * row, src + (size_t)y * info.stride, row);
+        }
+    }
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return true;
+}
+
+// TFLite input quantization: q = round(px / 255 / scale + zeroPoint), clamped to the type
+static int quantize(int px, float scale, int zeroPoint, int lo, int hi) {
+    const float v = px / 255.f;
+    const float q = scale > 0.f ? v / scale + zeroPoint : v * 255.f + zeroPoint;
+    return std::min(hi, std::max(lo, (int)std::floor(q + 0.5f)));
+}
+
+template <class T>
+static void write_tensor(const ncnn::Mat& rgb, int left, int top, const TensorSpec& spec,
+                         const T (&lut)[256], T* out) {
+    const int W = spec.w, H = spec.h;
+    const size_t plane = (size_t)W * H;
+    const T pad = lut[114];
+
+    for (int c = 0; c < 3; ++c) {
+        const float* ch = rgb.channel(c);
+        for (int y = 0; y < H; ++y) {
+            const int ry = y - top;
+            const bool rowIn = ry >= 0 && ry < rgb.h;
+            for (int x = 0; x < W; ++x) {
+                const int rx = x - left;
+                T v = pad;
+                if (rowIn && rx >= 0 && rx < rgb.w) {
+                    const int px = (int)ch[ry * rgb.w + rx];
+                    v = lut[std::min(255, std::max(0, px))];
+                }
+                const size_t idx = (size_t)y * W + x;
+                if (spec.nchw) out[c * plane + idx] = v;
+                else out[idx * 3 + c] = v;
+            }
+        }
+    }
+}
+
+bool bitmap_to_tensor(JNIEnv* env, jobject bitmap, const TensorSpec& spec, void* out, size_t capacity) {
+    AndroidBitmapInfo info;
+    if (!out || spec.w <= 0 || spec.h <= 0 || capacity < tensor_bytes(spec)) return false;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return false;
+    if (info.width == 0 || info.height == 0) return false;
+
+    const float r = std::min(spec.w / (float)info.width, spec.h / (float)info.height);
+    const int new_w = std::max(1, (int)std::round(info.width * r));
+    const int new_h = std::max(1, (int)std::round(info.height * r));
+
+    // uint8 bilinear resize inside ncnn, values stay integral 0..255
+    ncnn::Mat rgb = ncnn::Mat::from_android_bitmap_resize(env, bitmap, ncnn::Mat::PIXEL_RGB, new_w, new_h);
+    if (rgb.empty()) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "from_android_bitmap_resize failed");
+        return false;
+    }
+    const int left = (spec.w - new_w) / 2;
+    const int top = (spec.h - new_h) / 2;
+
+    switch (spec.type) {
+        case TensorType::Float32: {
+            float lut[256];
+            for (int i = 0; i < 256; ++i) lut[i] = i / 255.f;
+            write_tensor(rgb, left, top, spec, lut, (float*)out);
+            return true;
+        }
+        case TensorType::UInt8: {
+            uint8_t lut[256];
+            for (int i = 0; i < 256; ++i) lut[i] = (uint8_t)quantize(i, spec.scale, spec.zeroPoint, 0, 255);
+            write_tensor(rgb, left, top, spec, lut, (uint8_t*)out);
+            return true;
+        }
+        case TensorType::Int8: {
+            int8_t lut[256];
+            for (int i = 0; i < 256; ++i) lut[i] = (int8_t)quantize(i, spec.scale, spec.zeroPoint, -128, 127);
+            write_tensor(rgb, left, top, spec, lut, (int8_t*)out);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+
+// Element type of a backend input tensor (values match ImageBridge.TYPE_*)
+enum class TensorType {
+    Float32 = 0,  // px / 255
+    UInt8 = 1,    // quantized with scale / zeroPoint, as TFLite uint8 inputs
+    Int8 = 2      // quantized with scale / zeroPoint, as TFLite int8 inputs
+};
+
+// Letterboxed 3-channel RGB input of an ORT / TFLite model
+struct TensorSpec {
+    int w = 0, h = 0;
+    TensorType type = TensorType::Float32;
+    bool nchw = true;       // planar CHW, otherwise interleaved HWC
+    float scale = 0.f;      // quantization scale, <= 0 means px + zeroPoint
+    int zeroPoint = 0;
+};
+
+size_t tensor_bytes(const TensorSpec& spec);
+
+// Copies an android.graphics.Bitmap into tightly packed RGBA (w*h*4 bytes).
+// RGBA_8888 bitmaps are copied row by row; other configs go through ncnn.
+bool bitmap_to_rgba(JNIEnv* env, jobject bitmap, uint8_t* out, size_t capacity);
+
+// Bilinear resize to fit spec.w x spec.h, pad with 114 (centered, as the
+// Kotlin canvas letterbox did), then normalize / quantize into out.
+// out must hold tensor_bytes(spec) bytes.
+bool bitmap_to_tensor(JNIEnv* env, jobject bitmap, const TensorSpec& spec, void* out, size_t capacity);
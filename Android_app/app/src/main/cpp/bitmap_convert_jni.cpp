@@ -0,0 +1,32 @@
+#include <jni.h>
+#include "bitmap_convert.hpp"
+
+// ===== ImageBridge (benchmark image loading, all backends) =====
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_ImageBridge_bitmapToRgba(
+        JNIEnv* env, jobject /*thiz*/, jobject bitmap, jobject outBuffer) {
+    uint8_t* out = (uint8_t*)env->GetDirectBufferAddress(outBuffer);
+    jlong capacity = env->GetDirectBufferCapacity(outBuffer);
+    if (!out || capacity <= 0) return false;
+    return bitmap_to_rgba(env, bitmap, out, (size_t)capacity);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_ImageBridge_bitmapToTensor(
+        JNIEnv* env, jobject /*thiz*/, jobject bitmap,
+        jint width, jint height, jint type, jboolean nchw,
+        jfloat scale, jint zeroPoint, jobject outBuffer) {
+    if (type < (jint)TensorType::Float32 || type > (jint)TensorType::Int8) return false;
+    void* out = env->GetDirectBufferAddress(outBuffer);
+    jlong capacity = env->GetDirectBufferCapacity(outBuffer);
+    if (!out || capacity <= 0) return false;
+
+    TensorSpec spec;
+    spec.w = width;
+    spec.h = height;
+    spec.type = (TensorType)type;
+    spec.nchw = nchw;
+    spec.scale = scale;
+    spec.zeroPoint = zeroPoint;
+    return bitmap_to_tensor(env, bitmap, spec, out, (size_t)capacity);
+}
@@ -0,0 +1,27 @@
+#include "blob_index.hpp"
+
+int find_blob_index(const ncnn::Net& net, const char* name) {
+    const std::vector<ncnn::Blob>& blobs = net.blobs();
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        if (blobs[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+static int resolve_blob(const ncnn::Net& net, std::initializer_list<const char*> names,
+                        const std::vector<int>& graphIndexes, int fallbackPos) {
+    for (const char* nm : names) {
+        int idx = find_blob_index(net, nm);
+        if (idx >= 0) return idx;
+    }
+    if (fallbackPos >= 0 && fallbackPos < (int)graphIndexes.size()) return graphIndexes[fallbackPos];
+    return -1;
+}
+
+int resolve_input_blob(const ncnn::Net& net, std::initializer_list<const char*> names, int fallbackPos) {
+    return resolve_blob(net, names, net.input_indexes(), fallbackPos);
+}
+
+int resolve_output_blob(const ncnn::Net& net, std::initializer_list<const char*> names, int fallbackPos) {
+    return resolve_blob(net, names, net.output_indexes(), fallbackPos);
+}
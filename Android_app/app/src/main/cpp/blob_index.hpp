@@ -0,0 +1,21 @@
+#pragma once
+#include <initializer_list>
+#include "ncnn/net.h"
+
+// Input/output blob indices of a loaded graph. Resolved once after
+// load_param(), so hot paths call Extractor::input/extract by index
+// instead of trying names every frame.
+struct BlobIO {
+    int input = -1;
+    int output = -1;
+    bool ok() const { return input >= 0 && output >= 0; }
+};
+
+// Blob index by exact name, -1 if absent
+int find_blob_index(const ncnn::Net& net, const char* name);
+
+// First candidate present in the graph; otherwise the graph's own
+// input/output blob at position fallbackPos (net.input_indexes() /
+// net.output_indexes()); -1 if there is none.
+int resolve_input_blob(const ncnn::Net& net, std::initializer_list<const char*> names, int fallbackPos = 0);
+int resolve_output_blob(const ncnn::Net& net, std::initializer_list<const char*> names, int fallbackPos = 0);
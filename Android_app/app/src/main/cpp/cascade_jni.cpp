@@ -0,0 +1,104 @@
+#include <jni.h>
+#include <android/asset_manager_jni.h>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+#include <classifier.cpp>
+#include "yolov8.hpp"
+
+// Detector -> classifier cascade (MainActivity.CascadeBridge): YOLO boxes on an
+// RGBA frame, then the top maxCrops boxes classified by ResNet-50 in one
+// classify_crops pass. Own instances, so the YOLO / ResNet bridges stay untouched.
+static YoloV8* g_cascadeDet = nullptr;
+static ResNet50 g_cascadeCls;
+
+// Context around a box for the classifier, share of the box side per edge
+static constexpr float kCropPad = 0.1f;
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_MainActivity_00024CascadeBridge_init(
+        JNIEnv* env, jobject /*thiz*/, jobject assetMgr) {
+    AAssetManager* mgr = AAssetManager_fromJava(env, assetMgr);
+    if (g_cascadeDet) {
+        g_cascadeDet->clear();
+        delete g_cascadeDet;
+    }
+    g_cascadeDet = new YoloV8();
+    g_cascadeCls.clear();
+    return g_cascadeDet->load(mgr, "yolov8n.param", "yolov8n.bin") &&
+           g_cascadeCls.load(mgr, "resnet50.param", "resnet50.bin");
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024CascadeBridge_release(
+        JNIEnv*, jobject) {
+    if (g_cascadeDet) {
+        g_cascadeDet->clear();
+        delete g_cascadeDet;
+        g_cascadeDet = nullptr;
+    }
+    g_cascadeCls.clear();
+}
+
+// Packed result: [n, topK, detectMs, classifyMs], then n rows of
+// [x1,y1,x2,y2,score,cls, fineCls0,fineProb0, .. fineCls{topK-1},fineProb{topK-1}].
+// Boxes past maxCrops (by score) keep fineCls = -1.
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_MainActivity_00024CascadeBridge_detectClassifyRgba(
+        JNIEnv* env, jobject /*thiz*/, jobject buf,
+        jint w, jint h, jint rowStride, jint rotDeg,
+        jfloat conf, jfloat iou, jint topK, jint maxCrops, jint numWorkers) {
+    const uint8_t* rgba = (const uint8_t*)env->GetDirectBufferAddress(buf);
+    if (!g_cascadeDet || !rgba || w <= 0 || h <= 0 || topK <= 0) return env->NewFloatArray(0);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Det> dets = g_cascadeDet->detect_rgba(rgba, w, h, rowStride, rotDeg, conf, iou);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<int> order(dets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return dets[a].score > dets[b].score; });
+    order.resize(std::min(order.size(), (size_t)std::max(0, (int)maxCrops)));
+
+    const bool swap = rotDeg == 90 || rotDeg == 270;
+    const float fw = (float)(swap ? h : w), fh = (float)(swap ? w : h);
+    std::vector<RoiBox> crops;
+    crops.reserve(order.size());
+    for (int i : order) {
+        const Det& d = dets[i];
+        const float px = (d.x2 - d.x1) * kCropPad, py = (d.y2 - d.y1) * kCropPad;
+        crops.push_back({std::max(0.f, d.x1 - px), std::max(0.f, d.y1 - py),
+                         std::min(fw, d.x2 + px), std::min(fh, d.y2 + py)});
+    }
+    auto labels = g_cascadeCls.classify_crops(rgba, w, h, rowStride, rotDeg, crops, topK, numWorkers);
+    auto t2 = std::chrono::steady_clock::now();
+
+    const int stride = 6 + 2 * topK;
+    std::vector<float> packed(4 + dets.size() * stride, 0.f);
+    packed[0] = (float)dets.size();
+    packed[1] = (float)topK;
+    packed[2] = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    packed[3] = std::chrono::duration<float, std::milli>(t2 - t1).count();
+    for (size_t i = 0; i < dets.size(); ++i) {
+        float* row = packed.data() + 4 + i * stride;
+        row[0] = dets[i].x1; row[1] = dets[i].y1; row[2] = dets[i].x2; row[3] = dets[i].y2;
+        row[4] = dets[i].score; row[5] = (float)dets[i].cls;
+        for (int k = 0; k < topK; ++k) row[6 + 2 * k] = -1.f;
+    }
+    for (size_t j = 0; j < order.size(); ++j) {
+        float* row = packed.data() + 4 + order[j] * stride;
+        for (size_t k = 0; k < labels[j].size(); ++k) {
+            row[6 + 2 * k] = (float)labels[j][k].first;
+            row[7 + 2 * k] = labels[j][k].second;
+        }
+    }
+
+    jfloatArray out = env->NewFloatArray((jsize)packed.size());
+    env->SetFloatArrayRegion(out, 0, (jsize)packed.size(), packed.data());
+    return out;
+}
+
+} // extern "C"
@@ -6,6 +6,8 @@
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
 #include "ncnn/net.h"
+#include "blob_index.hpp"
+#include "yolov8.hpp"
 
 #include <vector>
 #include <string>
@@ -13,6 +15,8 @@
 #include <numeric>
 #include <cmath>
 #include <cstdint>
+#include <atomic>
+#include <thread>
 
 #ifndef LOG_TAG
 #define LOG_TAG "ncnn-resnet50"
@@ -32,7 +36,22 @@ public:
             __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "load_model(%s) failed", bin);
             return false;
         }
-        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "ResNet50 loaded (param=%s, bin=%s)", param, bin);
+
+        // Имена входа/выхода ищем один раз здесь, в classify_rgba работаем по индексам.
+        // Главные имена для твоего графа: "in0" / "out0", дальше популярные fallback-варианты.
+        inBlob = resolve_input_blob(net, {
+                "in0", "0", "input", "data", "images", "pnnx_input_0", "input.1", "x", "image"
+        });
+        outBlob = resolve_output_blob(net, {
+                "out0", "prob", "softmax", "logits", "output", "output0", "out", "pnnx_output_0"
+        });
+        if (inBlob < 0 || outBlob < 0) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "no input/output blob (in=%d out=%d)", inBlob, outBlob);
+            return false;
+        }
+
+        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "ResNet50 loaded (param=%s, bin=%s, in=%d out=%d)",
+                            param, bin, inBlob, outBlob);
         return true;
     }
 
@@ -44,56 +63,124 @@ public:
                                                     int topK = 5)
     {
         // Preprocess: resize к 224x224, нормализация как в ImageNet
-        const int iw = 224, ih = 224;
         ncnn::Mat in = ncnn::Mat::from_pixels_resize(
-                rgba, ncnn::Mat::PIXEL_RGBA2RGB, w, h, iw, ih);
-
-        // mean/std заданы в диапазоне 0..255 (эквивалент 0.485/0.456/0.406 и 0.229/0.224/0.225)
-        const float mean_vals[3] = {123.675f, 116.28f, 103.53f};
-        const float norm_vals[3] = {1.f/58.395f, 1.f/57.12f, 1.f/57.375f};
-        in.substract_mean_normalize(mean_vals, norm_vals);
+                rgba, ncnn::Mat::PIXEL_RGBA2RGB, w, h, kSide, kSide);
+        in.substract_mean_normalize(kMean, kNorm);
+        return classify_input(in, topK);
+    }
 
+    // Уже готовый вход 224x224 (нормализован как в ImageNet, например из FrameContext)
+    std::vector<std::pair<int,float>> classify_input(const ncnn::Mat& in, int topK = 5)
+    {
         ncnn::Extractor ex = net.create_extractor();
         ex.set_light_mode(true);
 
-        // ------- Подаём вход -------
-        // Главные имена для твоего графа: "in0"
-        // Добавлены популярные fallback-варианты для других экспортов.
-        static const char* INPUT_CANDIDATES[] = {
-                "in0", "0", "input", "data", "images", "pnnx_input_0", "input.1", "x", "image"
-        };
-        bool fed = false;
-        for (const char* nm : INPUT_CANDIDATES) {
-            if (ex.input(nm, in) == 0) {
-                fed = true;
-                // __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "fed input via '%s'", nm);
-                break;
-            }
+        // ------- Подаём вход / достаём выход (индексы найдены в load) -------
+        if (inBlob < 0 || ex.input(inBlob, in) != 0) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "failed to feed input (blob %d)", inBlob);
+            return {};
         }
-        if (!fed) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "failed to feed input (none of candidates matched)");
+
+        ncnn::Mat out;
+        if (ex.extract(outBlob, out) != 0) {
+            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "failed to extract output (blob %d)", outBlob);
             return {};
         }
 
-        // ------- Достаём выход -------
-        // Для твоего графа главный выход: "out0"
-        static const char* OUTPUT_CANDIDATES[] = {
-                "out0", "prob", "softmax", "logits", "output", "output0", "out", "pnnx_output_0"
+        return top_k(out, topK);
+    }
+
+    // Каскад: классификация боксов детектора (upright-координаты, как Det) на одном
+    // RGBA-кадре. Кропы режутся from_pixels_roi_resize прямо из кадра (без копии
+    // всего кадра), поворачиваются в upright и идут через numWorkers параллельных
+    // экстракторов одной сети — batch-измерения в ncnn нет. Результаты в порядке boxes.
+    std::vector<std::vector<std::pair<int,float>>> classify_crops(const uint8_t* rgba,
+                                                                  int w, int h, int rowStride,
+                                                                  int rotation_deg,
+                                                                  const std::vector<RoiBox>& boxes,
+                                                                  int topK, int numWorkers)
+    {
+        const int n = (int)boxes.size();
+        std::vector<std::vector<std::pair<int,float>>> results(n);
+        if (!rgba || n == 0 || inBlob < 0 || outBlob < 0) return results;
+
+        const int workers = std::max(1, std::min(numWorkers, n));
+
+        // Потоки сети делятся между воркерами (иначе workers x num_threads на
+        // тех же ядрах). Extractor копирует net.opt при создании, а
+        // set_num_threads в этой версии ncnn нет: создаём прототип здесь.
+        const int savedThreads = net.opt.num_threads;
+        net.opt.num_threads = std::max(1, savedThreads / workers);
+        ncnn::Extractor proto = net.create_extractor();
+        net.opt.num_threads = savedThreads;
+        proto.set_light_mode(true);
+
+        std::atomic<int> next{0};
+        auto worker = [&]() {
+            for (int i = next++; i < n; i = next++) {
+                const RoiBox r = YoloV8::upright_to_sensor(boxes[i], w, h, rotation_deg);
+                const int rx = (int)r.x1, ry = (int)r.y1;
+                const int rw = (int)r.x2 - rx, rh = (int)r.y2 - ry;
+                if (rw < 2 || rh < 2) continue;
+
+                ncnn::Mat crop = ncnn::Mat::from_pixels_roi_resize(
+                        rgba, ncnn::Mat::PIXEL_RGBA2RGB, w, h, rowStride, rx, ry, rw, rh, kSide, kSide);
+                ncnn::Mat in = rotate_upright(crop, rotation_deg);
+                in.substract_mean_normalize(kMean, kNorm);
+
+                ncnn::Extractor ex = proto;
+                ncnn::Mat out;
+                if (ex.input(inBlob, in) != 0 || ex.extract(outBlob, out) != 0) {
+                    __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "crop %d: extract failed", i);
+                    continue;
+                }
+                results[i] = top_k(out, topK);
+            }
         };
-        ncnn::Mat out;
-        bool got = false;
-        for (const char* nm : OUTPUT_CANDIDATES) {
-            if (ex.extract(nm, out) == 0) {
-                got = true;
-                // __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "extracted output via '%s' (w=%d h=%d c=%d)", nm, out.w, out.h, out.c);
-                break;
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (int t = 1; t < workers; ++t) pool.emplace_back(worker);
+        worker();
+        for (std::thread& t : pool) t.join();
+        return results;
+    }
+
+    void clear() { net.clear(); inBlob = outBlob = -1; }
+
+    // Число потоков сети (например, её доля при параллельной работе с другими моделями)
+    void setNumThreads(int n) { net.opt.num_threads = n > 0 ? n : 1; }
+
+    static constexpr int kSide = 224;
+    // mean/std заданы в диапазоне 0..255 (эквивалент 0.485/0.456/0.406 и 0.229/0.224/0.225)
+    static constexpr float kMean[3] = {123.675f, 116.28f, 103.53f};
+    static constexpr float kNorm[3] = {1.f/58.395f, 1.f/57.12f, 1.f/57.375f};
+
+private:
+
+    // Квадратный кроп в ориентации сенсора -> upright (тот же маппинг, что у детектора)
+    static ncnn::Mat rotate_upright(const ncnn::Mat& src, int rot) {
+        if (rot != 90 && rot != 180 && rot != 270) return src;
+        const int s = src.w;
+        ncnn::Mat dst(s, s, src.c);
+        for (int c = 0; c < src.c; ++c) {
+            const float* in = src.channel(c);
+            float* out = dst.channel(c);
+            for (int y = 0; y < s; ++y) {
+                for (int x = 0; x < s; ++x) {
+                    int sx = x, sy = y;
+                    if (rot == 90)       { sx = y;         sy = s - 1 - x; }
+                    else if (rot == 180) { sx = s - 1 - x; sy = s - 1 - y; }
+                    else                 { sx = s - 1 - y; sy = x; }
+                    out[y * s + x] = in[sy * s + sx];
+                }
             }
         }
-        if (!got) {
-            __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "failed to extract output");
-            return {};
-        }
+        return dst;
+    }
 
+    // softmax + topK пар (class_id, prob)
+    static std::vector<std::pair<int,float>> top_k(const ncnn::Mat& out, int topK) {
         // Копируем в вектор и делаем softmax
         std::vector<float> logits;
         logits.reserve((size_t)out.total());
@@ -121,10 +208,10 @@ public:
         }
         return top;
     }
-    void clear() { net.clear(); }
 
-private:
     ncnn::Net net;
+    int inBlob = -1;
+    int outBlob = -1;
 };
 
 // Глобальный экземпляр — если твой JNI-блок к нему обращается
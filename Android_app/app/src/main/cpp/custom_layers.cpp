@@ -0,0 +1,20 @@
+#include "custom_layers.hpp"
+#include "fast_swish.hpp"
+#include "ncnn/layer_type.h"
+#include "lowrank_conv.hpp"
+#include "sparse_conv1x1.hpp"
+#include "yolo_detection_output.hpp"
+
+void register_yolo_layers(ncnn::Net& net) {
+    net.register_custom_layer("YoloV8DetectionOutput", YoloV8DetectionOutput_layer_creator);
+    net.register_custom_layer("SparseConvolution1x1", SparseConvolution1x1_layer_creator);
+    net.register_custom_layer("LowRankConvolution", LowRankConvolution_layer_creator);
+}
+
+static ncnn::Layer* builtin_swish_creator(void* /*userdata*/) {
+    return ncnn::create_layer_cpu(ncnn::LayerType::Swish);
+}
+
+void set_fast_swish(ncnn::Net& net, bool enabled) {
+    net.register_custom_layer("Swish", enabled ? FastSwish_layer_creator : builtin_swish_creator);
+}
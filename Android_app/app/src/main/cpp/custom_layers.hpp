@@ -0,0 +1,15 @@
+#pragma once
+#include "ncnn/net.h"
+
+// Custom layers that xtrim may write into a .param (see NCNN_Compression/xtrim):
+//   YoloV8DetectionOutput   in-graph decode + NMS        (yolo_detection_output.hpp)
+//   SparseConvolution1x1    CSR pointwise convolution    (sparse_conv1x1.hpp)
+//   LowRankConvolution      fused KxK->1x1 factor pair   (lowrank_conv.hpp)
+//
+// Registers them on net; must run before load_param().
+void register_yolo_layers(ncnn::Net& net);
+
+// Routes the graph's Swish layers to FastSwish (fast_swish.hpp) or back to
+// ncnn's built-in Swish. ncnn has no unregister, so switching back is an
+// explicit override as well. Must run before load_param().
+void set_fast_swish(ncnn::Net& net, bool enabled);
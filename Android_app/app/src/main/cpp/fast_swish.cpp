@@ -0,0 +1,119 @@
+#include "fast_swish.hpp"
+#include <cmath>
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#elif __SSE2__
+#include <emmintrin.h>
+#endif
+
+// 2^f on [0, 1): 1 + f*(C1 + f*(C2 + f*(C3 + f*C4))), rel. error 6e-6
+#define FS_C1 0.69304348f
+#define FS_C2 0.24124981f
+#define FS_C3 0.05235283f
+#define FS_C4 0.01334154f
+#define FS_LOG2E 1.44269504f
+
+FastSwish::FastSwish() {
+    one_blob_only = true;
+    support_inplace = true;
+    support_packing = true;
+#if __ARM_NEON && __aarch64__
+    support_fp16_storage = true;
+#endif
+}
+
+namespace {
+#if __ARM_NEON
+inline float32x4_t swish_ps(float32x4_t x) {
+    float32x4_t t = vmulq_n_f32(x, -FS_LOG2E);
+    t = vmaxq_f32(vminq_f32(t, vdupq_n_f32(126.f)), vdupq_n_f32(-126.f));
+
+    // floor(t): truncate, then step down where truncation rounded up
+    int32x4_t i = vcvtq_s32_f32(t);
+    uint32x4_t up = vcgtq_f32(vcvtq_f32_s32(i), t);
+    i = vsubq_s32(i, vreinterpretq_s32_u32(vandq_u32(up, vdupq_n_u32(1))));
+    float32x4_t f = vsubq_f32(t, vcvtq_f32_s32(i));
+
+    float32x4_t p = vmlaq_f32(vdupq_n_f32(FS_C3), vdupq_n_f32(FS_C4), f);
+    p = vmlaq_f32(vdupq_n_f32(FS_C2), p, f);
+    p = vmlaq_f32(vdupq_n_f32(FS_C1), p, f);
+    p = vmlaq_f32(vdupq_n_f32(1.f), p, f);
+    // p * 2^i by adding i to the exponent bits
+    float32x4_t e = vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(p), vshlq_n_s32(i, 23)));
+
+    float32x4_t d = vaddq_f32(vdupq_n_f32(1.f), e);
+    float32x4_t r = vrecpeq_f32(d);
+    r = vmulq_f32(vrecpsq_f32(d, r), r);
+    r = vmulq_f32(vrecpsq_f32(d, r), r);
+    return vmulq_f32(x, r);
+}
+#elif __SSE2__
+inline __m128 swish_ps(__m128 x) {
+    __m128 t = _mm_mul_ps(x, _mm_set1_ps(-FS_LOG2E));
+    t = _mm_max_ps(_mm_min_ps(t, _mm_set1_ps(126.f)), _mm_set1_ps(-126.f));
+
+    __m128i i = _mm_cvttps_epi32(t);
+    __m128 up = _mm_cmpgt_ps(_mm_cvtepi32_ps(i), t);
+    i = _mm_sub_epi32(i, _mm_and_si128(_mm_castps_si128(up), _mm_set1_epi32(1)));
+    __m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(i));
+
+    __m128 p = _mm_add_ps(_mm_set1_ps(FS_C3), _mm_mul_ps(_mm_set1_ps(FS_C4), f));
+    p = _mm_add_ps(_mm_set1_ps(FS_C2), _mm_mul_ps(p, f));
+    p = _mm_add_ps(_mm_set1_ps(FS_C1), _mm_mul_ps(p, f));
+    p = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(p, f));
+    __m128 e = _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(i, 23)));
+
+    __m128 d = _mm_add_ps(_mm_set1_ps(1.f), e);
+    __m128 r = _mm_rcp_ps(d);
+    r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.f), _mm_mul_ps(d, r)));
+    return _mm_mul_ps(x, r);
+}
+#endif
+
+inline float swish_ss(float x) {
+    return x / (1.f + std::exp(-x));
+}
+
+void swish_fp32(float* ptr, int size) {
+    int i = 0;
+#if __ARM_NEON
+    for (; i + 3 < size; i += 4) vst1q_f32(ptr + i, swish_ps(vld1q_f32(ptr + i)));
+#elif __SSE2__
+    for (; i + 3 < size; i += 4) _mm_storeu_ps(ptr + i, swish_ps(_mm_loadu_ps(ptr + i)));
+#endif
+    for (; i < size; i++) ptr[i] = swish_ss(ptr[i]);
+}
+
+#if __ARM_NEON && __aarch64__
+void swish_fp16(unsigned short* ptr, int size) {
+    int i = 0;
+    for (; i + 3 < size; i += 4) {
+        float32x4_t x = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(ptr + i)));
+        vst1_u16(ptr + i, vreinterpret_u16_f16(vcvt_f16_f32(swish_ps(x))));
+    }
+    for (; i < size; i++) ptr[i] = ncnn::float32_to_float16(swish_ss(ncnn::float16_to_float32(ptr[i])));
+}
+#endif
+}  // namespace
+
+int FastSwish::forward_inplace(ncnn::Mat& bottom_top_blob, const ncnn::Option& opt) const {
+    // opt only feeds the omp pragmas
+    (void)opt;
+    const int channels = bottom_top_blob.c;
+    const int size = bottom_top_blob.w * bottom_top_blob.h * bottom_top_blob.d * bottom_top_blob.elempack;
+
+#if __ARM_NEON && __aarch64__
+    if (bottom_top_blob.elembits() == 16) {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < channels; q++) swish_fp16(bottom_top_blob.channel(q), size);
+        return 0;
+    }
+#endif
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++) swish_fp32(bottom_top_blob.channel(q), size);
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(FastSwish)
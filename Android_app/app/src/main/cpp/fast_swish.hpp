@@ -0,0 +1,21 @@
+#pragma once
+#include "ncnn/layer.h"
+
+// Drop-in replacement for ncnn's Swish (x * sigmoid(x)), registered over the
+// built-in type when an engine has fast swish enabled (set_fast_swish()).
+//
+// exp(-x) is 2^i * p(f) with a degree-4 polynomial for 2^f and the division
+// is a reciprocal estimate + Newton steps, so there is no libm call per
+// element. Max abs error vs. exact SiLU stays below 1e-5 over [-40, 40]
+// (xtrim_layer_check in NCNN_Compression/android_native checks it), unlike
+// the HardSwish/ReLU rewrite in scripts/optimize_yolo_ncnn.py which changes
+// the model.
+// Elementwise, so any packing; fp16 storage on arm64.
+class FastSwish : public ncnn::Layer {
+public:
+    FastSwish();
+
+    virtual int forward_inplace(ncnn::Mat& bottom_top_blob, const ncnn::Option& opt) const;
+};
+
+ncnn::Layer* FastSwish_layer_creator(void* userdata);
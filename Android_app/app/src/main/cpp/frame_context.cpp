@@ -0,0 +1,91 @@
+#include "frame_context.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+static float ms_between(std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1) {
+    return std::chrono::duration<float, std::milli>(t1 - t0).count();
+}
+
+bool FrameContext::build(const uint8_t* rgba, int srcW, int srcH, int rowStride, int rotationDeg) {
+    auto t0 = std::chrono::steady_clock::now();
+    w = srcW;
+    h = srcH;
+    rot = rotationDeg;
+    cls.release();
+    if (!rgba || srcW <= 0 || srcH <= 0 || rowStride <= 0 || cfg.sizes.empty()) {
+        levels.clear();
+        return false;
+    }
+
+    std::vector<int> sizes = cfg.sizes;
+    std::sort(sizes.begin(), sizes.end(), [](int a, int b) { return a > b; });
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    levels.resize(sizes.size());
+
+    // The only pass over the full-resolution frame
+    Level& base = levels[0];
+    base.size = sizes[0];
+    base.rgb.resize((size_t)base.size * base.size * 3);
+    YoloV8::letterbox_rgba_u8(rgba, srcW, srcH, rowStride, rotationDeg, base.size, base.rgb.data(), base.lb);
+
+    const float norm255[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
+    for (size_t i = 0; i < levels.size(); ++i) {
+        Level& L = levels[i];
+        if (i > 0) {
+            L.size = sizes[i];
+            L.rgb.resize((size_t)L.size * L.size * 3);
+            ncnn::resize_bilinear_c3(base.rgb.data(), base.size, base.size, L.rgb.data(), L.size, L.size);
+            // Same letterbox scaled by k (pads within a pixel of a direct letterbox)
+            const float k = (float)L.size / base.size;
+            L.lb.scale = base.lb.scale * k;
+            L.lb.pad_w = (int)std::lround(base.lb.pad_w * k);
+            L.lb.pad_h = (int)std::lround(base.lb.pad_h * k);
+        }
+        L.planar = ncnn::Mat::from_pixels(L.rgb.data(), ncnn::Mat::PIXEL_RGB, L.size, L.size);
+        L.planar.substract_mean_normalize(0, norm255);
+    }
+
+    if (cfg.classifierSize > 0) {
+        const int cw = base.size - base.lb.pad_w, ch = base.size - base.lb.pad_h;
+        cls = ncnn::Mat::from_pixels_roi_resize(base.rgb.data(), ncnn::Mat::PIXEL_RGB, base.size, base.size,
+                                                base.lb.pad_w / 2, base.lb.pad_h / 2, std::max(1, cw), std::max(1, ch),
+                                                cfg.classifierSize, cfg.classifierSize);
+        cls.substract_mean_normalize(cfg.clsMean, cfg.clsNorm);
+    }
+
+    ms = ms_between(t0, std::chrono::steady_clock::now());
+    return true;
+}
+
+const ncnn::Mat& FrameContext::input(int size, Letterbox& lb) const {
+    for (const Level& L : levels) {
+        if (L.size == size) {
+            lb = L.lb;
+            return L.planar;
+        }
+    }
+    return none;
+}
+
+void FrameFanout::add(const std::string& name, Engine run) {
+    engines.push_back(std::move(run));
+    names.push_back(name);
+    ms.push_back(0.f);
+}
+
+void FrameFanout::run(const FrameContext& ctx) {
+    auto timed = [&](size_t i) {
+        auto t0 = std::chrono::steady_clock::now();
+        engines[i](ctx);
+        ms[i] = ms_between(t0, std::chrono::steady_clock::now());
+    };
+
+    // Engine 0 runs on the calling thread
+    std::vector<std::thread> pool;
+    pool.reserve(engines.size());
+    for (size_t i = 1; i < engines.size(); ++i) pool.emplace_back(timed, i);
+    if (!engines.empty()) timed(0);
+    for (std::thread& t : pool) t.join();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "ncnn/mat.h"
+#include "yolov8.hpp"
+
+// Letterbox / classifier levels a FrameContext builds
+struct FrameContextConfig {
+    std::vector<int> sizes{640, 480, 320};   // letterboxed YOLO inputs (RGB / 255)
+    int classifierSize = 224;                 // upright frame squashed to a square, 0 = none
+    float clsMean[3] = {0.f, 0.f, 0.f};       // classifier normalization, (v - mean) * norm
+    float clsNorm[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
+};
+
+// One RGBA frame preprocessed once for several engines.
+//
+// The frame is rotated and letterboxed a single time, into the largest
+// configured size (packed RGB). Smaller levels are bilinear resizes of that
+// level, and the classifier level is its content area, so the full-resolution
+// buffer is read once per frame whatever the number of engines. Every level
+// also keeps its normalized planar ncnn::Mat. All of it is built in build();
+// afterwards the context is read-only and can be shared by concurrent engines.
+class FrameContext {
+public:
+    void configure(const FrameContextConfig& c) { cfg = c; }
+
+    bool build(const uint8_t* rgba, int srcW, int srcH, int rowStride, int rotationDeg);
+
+    // Planar YOLO input of a configured size (empty Mat otherwise) and its letterbox
+    const ncnn::Mat& input(int size, Letterbox& lb) const;
+
+    // Planar, classifier-normalized classifierSize input
+    const ncnn::Mat& classifierInput() const { return cls; }
+
+    int srcW() const { return w; }
+    int srcH() const { return h; }
+    int rotation() const { return rot; }
+    float buildMs() const { return ms; }
+
+private:
+    struct Level {
+        int size = 0;
+        Letterbox lb;
+        std::vector<uint8_t> rgb;   // packed size x size x 3
+        ncnn::Mat planar;
+    };
+
+    FrameContextConfig cfg;
+    std::vector<Level> levels;      // largest first
+    ncnn::Mat cls;
+    ncnn::Mat none;
+    int w = 0, h = 0, rot = 0;
+    float ms = 0.f;
+};
+
+// Engines registered on a FrameFanout run concurrently on one FrameContext,
+// one thread each. An engine keeps its own results; the caller collects them
+// after run(). Engines must not share mutable state (one model object each),
+// and their nets should split the cores between them (setNumThreads shares).
+class FrameFanout {
+public:
+    using Engine = std::function<void(const FrameContext&)>;
+
+    void add(const std::string& name, Engine run);
+    void clear() { engines.clear(); names.clear(); ms.clear(); }
+
+    // Runs every engine and waits for all of them
+    void run(const FrameContext& ctx);
+
+    size_t size() const { return engines.size(); }
+    const std::string& name(size_t i) const { return names[i]; }
+    // Wall time of engine i in the last run(), ms
+    float engineMs(size_t i) const { return ms[i]; }
+
+private:
+    std::vector<Engine> engines;
+    std::vector<std::string> names;
+    std::vector<float> ms;
+};
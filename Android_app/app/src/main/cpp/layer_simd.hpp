@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "ncnn/mat.h"
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#elif __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Small vector kernels shared by the custom layers (sparse_conv1x1,
+// lowrank_conv). NEON on device, SSE2 on x86 hosts, scalar tail/fallback.
+
+// out[i] += a[i] * va + b[i] * vb
+static inline void axpy2(float* out, const float* a, float va, const float* b, float vb, int n) {
+    int i = 0;
+#if __ARM_NEON
+    const float32x4_t _va = vdupq_n_f32(va);
+    const float32x4_t _vb = vdupq_n_f32(vb);
+    for (; i + 3 < n; i += 4) {
+        float32x4_t _o = vld1q_f32(out + i);
+        _o = vmlaq_f32(_o, vld1q_f32(a + i), _va);
+        _o = vmlaq_f32(_o, vld1q_f32(b + i), _vb);
+        vst1q_f32(out + i, _o);
+    }
+#elif __SSE2__
+    const __m128 _va = _mm_set1_ps(va);
+    const __m128 _vb = _mm_set1_ps(vb);
+    for (; i + 3 < n; i += 4) {
+        __m128 _o = _mm_loadu_ps(out + i);
+        _o = _mm_add_ps(_o, _mm_mul_ps(_mm_loadu_ps(a + i), _va));
+        _o = _mm_add_ps(_o, _mm_mul_ps(_mm_loadu_ps(b + i), _vb));
+        _mm_storeu_ps(out + i, _o);
+    }
+#endif
+    for (; i < n; i++) out[i] += a[i] * va + b[i] * vb;
+}
+
+static inline void axpy1(float* out, const float* a, float va, int n) {
+    int i = 0;
+#if __ARM_NEON
+    const float32x4_t _va = vdupq_n_f32(va);
+    for (; i + 3 < n; i += 4) vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(a + i), _va));
+#elif __SSE2__
+    const __m128 _va = _mm_set1_ps(va);
+    for (; i + 3 < n; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(a + i), _va)));
+#endif
+    for (; i < n; i++) out[i] += a[i] * va;
+}
+
+// Same activation_type numbering as ncnn Convolution
+static inline void activate(float* x, int n, int type, const ncnn::Mat& params) {
+    switch (type) {
+    case 1:
+        for (int i = 0; i < n; i++) x[i] = std::max(x[i], 0.f);
+        break;
+    case 2: {
+        const float slope = params.w > 0 ? params[0] : 0.f;
+        for (int i = 0; i < n; i++) x[i] = x[i] > 0.f ? x[i] : x[i] * slope;
+        break;
+    }
+    case 3: {
+        const float lo = params.w > 1 ? params[0] : 0.f;
+        const float hi = params.w > 1 ? params[1] : 6.f;
+        for (int i = 0; i < n; i++) x[i] = std::min(std::max(x[i], lo), hi);
+        break;
+    }
+    case 4:
+        for (int i = 0; i < n; i++) x[i] = 1.f / (1.f + std::exp(-x[i]));
+        break;
+    case 5:
+        for (int i = 0; i < n; i++) x[i] = x[i] * std::tanh(std::log1p(std::exp(x[i])));
+        break;
+    case 6: {
+        const float alpha = params.w > 1 ? params[0] : 1.f / 6.f;
+        const float beta = params.w > 1 ? params[1] : 0.5f;
+        for (int i = 0; i < n; i++) x[i] = x[i] * std::min(std::max(x[i] * alpha + beta, 0.f), 1.f);
+        break;
+    }
+    default:
+        break;
+    }
+}
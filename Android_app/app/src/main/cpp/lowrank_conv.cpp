@@ -0,0 +1,137 @@
+#include "lowrank_conv.hpp"
+#include <algorithm>
+#include <vector>
+#include "layer_simd.hpp"
+#include "ncnn/modelbin.h"
+#include "ncnn/paramdict.h"
+
+LowRankConvolution::LowRankConvolution() {
+    one_blob_only = true;
+    support_inplace = false;
+    support_packing = false;
+    support_fp16_storage = false;
+
+    num_output = 0;
+    num_input = 0;
+    rank = 0;
+    kernel_w = kernel_h = 1;
+    dilation_w = dilation_h = 1;
+    stride_w = stride_h = 1;
+    pad_left = pad_right = pad_top = pad_bottom = 0;
+    pad_value = 0.f;
+    bias_term = 0;
+    activation_type = 0;
+}
+
+int LowRankConvolution::load_param(const ncnn::ParamDict& pd) {
+    num_output = pd.get(0, 0);
+    kernel_w = pd.get(1, 1);
+    kernel_h = pd.get(11, kernel_w);
+    dilation_w = pd.get(2, 1);
+    dilation_h = pd.get(12, dilation_w);
+    stride_w = pd.get(3, 1);
+    stride_h = pd.get(13, stride_w);
+    pad_left = pd.get(4, 0);
+    pad_right = pd.get(15, pad_left);
+    pad_top = pd.get(14, pad_left);
+    pad_bottom = pd.get(16, pad_top);
+    pad_value = pd.get(18, 0.f);
+    bias_term = pd.get(5, 0);
+    activation_type = pd.get(9, 0);
+    activation_params = pd.get(10, ncnn::Mat());
+    rank = pd.get(20, 0);
+    num_input = pd.get(21, 0);
+
+    // SAME-style negative pads are not produced by the converter pass
+    if (pad_left < 0 || pad_right < 0 || pad_top < 0 || pad_bottom < 0) return -1;
+    return (num_output > 0 && num_input > 0 && rank > 0) ? 0 : -1;
+}
+
+int LowRankConvolution::load_model(const ncnn::ModelBin& mb) {
+    weight_u = mb.load(rank * num_input * kernel_h * kernel_w, 1);
+    weight_v = mb.load(num_output * rank, 1);
+    if (weight_u.empty() || weight_v.empty()) return -100;
+
+    if (bias_term) {
+        bias_data = mb.load(num_output, 1);
+        if (bias_data.empty()) return -100;
+    }
+    return 0;
+}
+
+int LowRankConvolution::forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const {
+    if (bottom_blob.c != num_input || bottom_blob.elempack != 1) return -1;
+
+    ncnn::Mat bordered = bottom_blob;
+    if (pad_left || pad_right || pad_top || pad_bottom) {
+        ncnn::Option opt_b = opt;
+        opt_b.blob_allocator = opt.workspace_allocator;
+        ncnn::copy_make_border(bottom_blob, bordered, pad_top, pad_bottom, pad_left, pad_right,
+                               ncnn::BORDER_CONSTANT, pad_value, opt_b);
+        if (bordered.empty()) return -100;
+    }
+
+    const int kext_w = dilation_w * (kernel_w - 1) + 1;
+    const int kext_h = dilation_h * (kernel_h - 1) + 1;
+    const int outw = (bordered.w - kext_w) / stride_w + 1;
+    const int outh = (bordered.h - kext_h) / stride_h + 1;
+    if (outw <= 0 || outh <= 0) return -1;
+
+    top_blob.create(outw, outh, num_output, 4u, opt.blob_allocator);
+    if (top_blob.empty()) return -100;
+
+    // Strip height so that rank x strip floats stay around 64 KB (L2-resident)
+    const int rows = std::max(1, 16384 / std::max(1, rank * outw));
+    const int strips = (outh + rows - 1) / rows;
+    const int ksize = kernel_h * kernel_w;
+    const float* U = weight_u;
+    const float* V = weight_v;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int s = 0; s < strips; s++) {
+        const int y0 = s * rows;
+        const int y1 = std::min(outh, y0 + rows);
+        const int n = (y1 - y0) * outw;
+        std::vector<float> mid((size_t)rank * n, 0.f);
+
+        // mid = U * input for this strip; each input row is read once and
+        // scattered into all rank accumulators while it is hot in L1
+        for (int q = 0; q < num_input; q++) {
+            const ncnn::Mat ch = bordered.channel(q);
+            for (int ky = 0; ky < kernel_h; ky++) {
+                for (int kx = 0; kx < kernel_w; kx++) {
+                    const float* uk = U + (size_t)q * ksize + ky * kernel_w + kx;
+                    for (int y = y0; y < y1; y++) {
+                        const float* in = ch.row(y * stride_h + ky * dilation_h) + kx * dilation_w;
+                        for (int r = 0; r < rank; r++) {
+                            const float wv = uk[(size_t)r * num_input * ksize];
+                            if (wv == 0.f) continue;
+                            float* mrow = mid.data() + (size_t)r * n + (size_t)(y - y0) * outw;
+                            if (stride_w == 1) {
+                                axpy1(mrow, in, wv, outw);
+                            } else {
+                                for (int x = 0; x < outw; x++) mrow[x] += in[x * stride_w] * wv;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // out = V * mid + bias
+        for (int p = 0; p < num_output; p++) {
+            float* out = top_blob.channel(p).row(y0);
+            std::fill(out, out + n, bias_term ? bias_data[p] : 0.f);
+            const float* vp = V + (size_t)p * rank;
+            int r = 0;
+            for (; r + 1 < rank; r += 2)
+                axpy2(out, mid.data() + (size_t)r * n, vp[r], mid.data() + (size_t)(r + 1) * n, vp[r + 1], n);
+            if (r < rank) axpy1(out, mid.data() + (size_t)r * n, vp[r], n);
+
+            activate(out, n, activation_type, activation_params);
+        }
+    }
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(LowRankConvolution)
@@ -0,0 +1,42 @@
+#pragma once
+#include "ncnn/layer.h"
+
+// Fused pair for xtrim LowRankConv2d exports: a KxK conv to `rank` channels
+// (U) followed by a 1x1 conv to num_output (V), written by
+// NcnnConverter.fuse_lowrank in place of the two Convolution layers:
+//   LowRankConvolution conv_7 1 1 in out 0=128 1=3 11=3 4=1 5=1 20=16 21=64
+// Params: same ids as Convolution for num_output/kernel/dilation/stride/pad/
+//         bias_term/activation, plus 20=rank 21=num_input
+// Model:  U[rank][num_input][kh][kw], V[num_output][rank], bias[num_output],
+//         all raw fp32 (no ncnn tag)
+//
+// The output is produced in horizontal strips; the rank x strip intermediate
+// stays in cache between the two factors instead of round-tripping through a
+// full-size blob.
+class LowRankConvolution : public ncnn::Layer {
+public:
+    LowRankConvolution();
+
+    virtual int load_param(const ncnn::ParamDict& pd);
+    virtual int load_model(const ncnn::ModelBin& mb);
+    virtual int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const;
+
+public:
+    int num_output;
+    int num_input;
+    int rank;
+    int kernel_w, kernel_h;
+    int dilation_w, dilation_h;
+    int stride_w, stride_h;
+    int pad_left, pad_right, pad_top, pad_bottom;
+    float pad_value;
+    int bias_term;
+    int activation_type;
+    ncnn::Mat activation_params;
+
+    ncnn::Mat weight_u;
+    ncnn::Mat weight_v;
+    ncnn::Mat bias_data;
+};
+
+ncnn::Layer* LowRankConvolution_layer_creator(void* userdata);
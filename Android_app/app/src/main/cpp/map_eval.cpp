@@ -0,0 +1,162 @@
+#include "map_eval.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static float box_iou(const Det& a, const GtBox& b) {
+    float iw = std::max(0.f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+    float ih = std::max(0.f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+    float inter = iw * ih;
+    float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+    float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+    return inter / (area_a + area_b - inter + 1e-6f);
+}
+
+MapEvaluator::MapEvaluator(int numClasses, int maxDet) : maxDet(maxDet) {
+    reset(numClasses);
+}
+
+void MapEvaluator::reset(int numClasses) {
+    nc = numClasses > 0 ? numClasses : 80;
+    numImages = 0;
+    dets.assign(nc, {});
+    numGt.assign(nc, 0);
+}
+
+void MapEvaluator::add(std::vector<Det> ds, const std::vector<GtBox>& gts) {
+    numImages++;
+
+    std::sort(ds.begin(), ds.end(), [](const Det& a, const Det& b) { return a.score > b.score; });
+    if ((int)ds.size() > maxDet) ds.resize(maxDet);
+
+    for (const GtBox& g : gts)
+        if (g.cls >= 0 && g.cls < nc) numGt[g.cls]++;
+
+    // used[t * G + j]: GT j already matched at threshold t
+    const size_t G = gts.size();
+    std::vector<uint8_t> used(kNumThr * G, 0);
+
+    for (const Det& d : ds) {
+        if (d.cls < 0 || d.cls >= nc) continue;
+
+        uint16_t mask = 0;
+        for (int t = 0; t < kNumThr; ++t) {
+            const float thr = 0.5f + 0.05f * t;
+            float best = thr;
+            int bestJ = -1;
+            for (size_t j = 0; j < G; ++j) {
+                if (gts[j].cls != d.cls || used[t * G + j]) continue;
+                float iou = box_iou(d, gts[j]);
+                if (iou >= best) { best = iou; bestJ = (int)j; }
+            }
+            if (bestJ >= 0) {
+                used[t * G + bestJ] = 1;
+                mask |= (uint16_t)(1u << t);
+            }
+        }
+        dets[d.cls].push_back({d.score, mask});
+    }
+}
+
+// 101-point interpolated AP over a score-sorted TP/FP sequence
+static float ap101(const std::vector<uint8_t>& tp, int nGt) {
+    const size_t n = tp.size();
+    std::vector<float> rec(n), prec(n);
+    int ctp = 0;
+    for (size_t i = 0; i < n; ++i) {
+        ctp += tp[i];
+        rec[i] = (float)ctp / (float)nGt;
+        prec[i] = (float)ctp / (float)(i + 1);
+    }
+    // precision envelope
+    for (size_t i = n; i-- > 1;) prec[i - 1] = std::max(prec[i - 1], prec[i]);
+
+    float sum = 0.f;
+    size_t k = 0;
+    for (int r = 0; r <= 100; ++r) {
+        const float rt = r / 100.f;
+        while (k < n && rec[k] < rt) k++;
+        if (k < n) sum += prec[k];
+    }
+    return sum / 101.f;
+}
+
+MapResult MapEvaluator::compute() const {
+    MapResult res;
+    res.images = numImages;
+    res.ap.assign(nc, -1.f);
+
+    double sum50 = 0.0, sum50_95 = 0.0;
+    std::vector<uint8_t> tp;
+    for (int c = 0; c < nc; ++c) {
+        if (numGt[c] == 0) continue;  // COCO skips classes absent from GT
+
+        std::vector<Scored> sorted = dets[c];
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const Scored& a, const Scored& b) { return a.score > b.score; });
+
+        float apSum = 0.f, ap50 = 0.f;
+        tp.resize(sorted.size());
+        for (int t = 0; t < kNumThr; ++t) {
+            for (size_t i = 0; i < sorted.size(); ++i) tp[i] = (sorted[i].tpMask >> t) & 1u;
+            float ap = ap101(tp, numGt[c]);
+            if (t == 0) ap50 = ap;
+            apSum += ap;
+        }
+
+        res.ap[c] = apSum / kNumThr;
+        sum50 += ap50;
+        sum50_95 += res.ap[c];
+        res.classes++;
+    }
+
+    if (res.classes > 0) {
+        res.map50 = (float)(sum50 / res.classes);
+        res.map50_95 = (float)(sum50_95 / res.classes);
+    }
+    return res;
+}
+
+bool load_yolo_labels(const char* path, int imgW, int imgH, std::vector<GtBox>& gts) {
+    gts.clear();
+    if (!path || !path[0]) return true;
+
+    std::ifstream f(path);
+    if (!f.is_open()) return true;
+
+    std::string line;
+    std::vector<float> v;
+    while (std::getline(f, line)) {
+        std::istringstream ss(line);
+        int cls;
+        if (!(ss >> cls)) continue;
+        v.clear();
+        float x;
+        while (ss >> x) v.push_back(x);
+
+        float cx, cy, w, h;
+        if (v.size() == 4) {
+            cx = v[0]; cy = v[1]; w = v[2]; h = v[3];
+        } else if (v.size() >= 6 && v.size() % 2 == 0) {
+            // segment polygon: x1 y1 x2 y2 ...
+            float minx = 1.f, miny = 1.f, maxx = 0.f, maxy = 0.f;
+            for (size_t i = 0; i < v.size(); i += 2) {
+                minx = std::min(minx, v[i]);     maxx = std::max(maxx, v[i]);
+                miny = std::min(miny, v[i + 1]); maxy = std::max(maxy, v[i + 1]);
+            }
+            cx = (minx + maxx) / 2.f; cy = (miny + maxy) / 2.f;
+            w = maxx - minx; h = maxy - miny;
+        } else {
+            continue;
+        }
+
+        GtBox g;
+        g.x1 = (cx - w / 2.f) * imgW;
+        g.y1 = (cy - h / 2.f) * imgH;
+        g.x2 = (cx + w / 2.f) * imgW;
+        g.y2 = (cy + h / 2.f) * imgH;
+        g.cls = cls;
+        gts.push_back(g);
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "yolov8.hpp"
+
+// Ground-truth box in source image pixels
+struct GtBox { float x1, y1, x2, y2; int cls; };
+
+struct MapResult {
+    float map50 = 0.f;        // AP@0.5 averaged over classes with GT
+    float map50_95 = 0.f;     // AP@[0.5:0.05:0.95] averaged over classes with GT
+    int images = 0;
+    int classes = 0;          // classes that had at least one GT box
+    std::vector<float> ap;    // per-class AP@[0.5:0.95], -1 for classes without GT
+};
+
+// COCO-style bbox mAP accumulated image by image.
+// Matching follows pycocotools: detections of an image are taken in score
+// order and each one claims the best still-free GT of its class with
+// IoU >= t, independently for every threshold t. Only the match flags are
+// kept, so memory does not depend on image size or box count per image.
+class MapEvaluator {
+public:
+    explicit MapEvaluator(int numClasses = 80, int maxDet = 300);
+
+    void reset(int numClasses);
+    void add(std::vector<Det> dets, const std::vector<GtBox>& gts);
+    MapResult compute() const;
+
+    int images() const { return numImages; }
+
+    static constexpr int kNumThr = 10;   // 0.50, 0.55 .. 0.95
+
+private:
+    struct Scored { float score; uint16_t tpMask; };  // bit t = TP at threshold t
+
+    int nc;
+    int maxDet;
+    int numImages = 0;
+    std::vector<std::vector<Scored>> dets;  // per class
+    std::vector<int> numGt;                 // per class
+};
+
+// Reads a YOLO label file (`cls cx cy w h`, normalized; polygon rows are
+// reduced to their bbox) into pixel boxes for an imgW x imgH image.
+// Missing file = image without objects, returns true with empty gts.
+bool load_yolo_labels(const char* path, int imgW, int imgH, std::vector<GtBox>& gts);
@@ -0,0 +1,117 @@
+#include "motion_gate.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#elif __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Sum of n bytes. NEON pairwise widening adds, SSE2 SAD against zero.
+static inline uint32_t sum_u8(const uint8_t* p, int n) {
+    uint32_t s = 0;
+    int i = 0;
+#if __ARM_NEON
+    uint32x4_t _acc = vdupq_n_u32(0);
+    for (; i + 15 < n; i += 16) {
+        _acc = vpadalq_u16(_acc, vpaddlq_u8(vld1q_u8(p + i)));
+    }
+    uint32_t lanes[4];
+    vst1q_u32(lanes, _acc);
+    s = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif __SSE2__
+    __m128i _acc = _mm_setzero_si128();
+    const __m128i _zero = _mm_setzero_si128();
+    for (; i + 15 < n; i += 16) {
+        _acc = _mm_add_epi64(_acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(p + i)), _zero));
+    }
+    s = (uint32_t)_mm_cvtsi128_si32(_acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(_acc, 8));
+#endif
+    for (; i < n; i++) s += p[i];
+    return s;
+}
+
+void MotionGate::configure(const MotionGateConfig& c) {
+    cfg = c;
+    cfg.gridW = std::max(1, cfg.gridW);
+    cfg.gridH = std::max(1, cfg.gridH);
+    cfg.rowStep = std::max(1, cfg.rowStep);
+    cfg.maxStale = std::max(0, cfg.maxStale);
+    reset();
+}
+
+void MotionGate::reset() {
+    ref.clear();
+    refW = refH = 0;
+    stale = 0;
+    changed = 0.f;
+    emaRunMs = 0.f;
+    st = MotionGateStats();
+}
+
+void MotionGate::blockMeans(const uint8_t* y, int w, int h, int rowStride, std::vector<float>& out) const {
+    const int gw = std::min(cfg.gridW, w), gh = std::min(cfg.gridH, h);
+    out.assign((size_t)gw * gh, 0.f);
+    for (int by = 0; by < gh; ++by) {
+        const int y0 = by * h / gh, y1 = (by + 1) * h / gh;
+        int rows = 0;
+        for (int yy = y0; yy < y1; yy += cfg.rowStep, ++rows) {
+            const uint8_t* row = y + (size_t)yy * rowStride;
+            for (int bx = 0; bx < gw; ++bx) {
+                const int x0 = bx * w / gw, x1 = (bx + 1) * w / gw;
+                out[by * gw + bx] += (float)sum_u8(row + x0, x1 - x0);
+            }
+        }
+        for (int bx = 0; bx < gw; ++bx) {
+            const int bw = (bx + 1) * w / gw - bx * w / gw;
+            out[by * gw + bx] /= (float)std::max(1, rows * bw);
+        }
+    }
+}
+
+bool MotionGate::shouldRun(const uint8_t* y, int w, int h, int rowStride) {
+    if (!cfg.enabled || !y || w <= 0 || h <= 0) return true;
+    auto t0 = std::chrono::steady_clock::now();
+    st.frames++;
+
+    blockMeans(y, w, h, rowStride, cur);
+
+    bool run = true;
+    changed = 0.f;
+    if (refW == w && refH == h && ref.size() == cur.size()) {
+        float shift = 0.f;
+        for (size_t i = 0; i < cur.size(); ++i) shift += cur[i] - ref[i];
+        shift /= (float)cur.size();
+
+        int moved = 0;
+        for (size_t i = 0; i < cur.size(); ++i) {
+            if (std::fabs(cur[i] - ref[i] - shift) > cfg.blockDiff) moved++;
+        }
+        changed = (float)moved / (float)cur.size();
+
+        run = changed >= cfg.minChanged;
+        if (!run && stale >= cfg.maxStale) {
+            run = true;
+            st.forced++;
+        }
+    }
+
+    if (run) {
+        ref.swap(cur);
+        refW = w;
+        refH = h;
+        stale = 0;
+    } else {
+        stale++;
+        st.reused++;
+        st.savedMs += emaRunMs;
+    }
+    st.gateMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return run;
+}
+
+void MotionGate::reportRunMs(float ms) {
+    emaRunMs = emaRunMs > 0.f ? 0.8f * emaRunMs + 0.2f * ms : ms;
+}
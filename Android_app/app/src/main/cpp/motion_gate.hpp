@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Cheap change detector for the camera path: decides from the luma plane
+// whether a frame has to go through the detector / tracker again or whether
+// the last result can be shown as is.
+//
+// The Y plane is reduced to a gridW x gridH grid of block means (sampling every
+// rowStep-th row, SIMD row sums) and compared with the grid of the last frame
+// that ran. The global mean shift is removed first, so auto-exposure steps do
+// not count as motion. A frame runs when at least minChanged of the blocks moved
+// by more than blockDiff luma levels, or after maxStale reused frames.
+struct MotionGateConfig {
+    bool enabled = true;
+    int gridW = 32, gridH = 24;
+    int rowStep = 2;
+    float blockDiff = 6.f;       // sensitivity: block mean change in luma levels
+    float minChanged = 0.004f;   // share of changed blocks (~3 of 768) that triggers a run
+    int maxStale = 30;           // frames a result may be reused before a forced run
+};
+
+struct MotionGateStats {
+    int frames = 0;        // gate decisions
+    int reused = 0;        // static frames served from the last result
+    int forced = 0;        // runs forced by maxStale
+    float gateMs = 0.f;    // total time spent in shouldRun()
+    float savedMs = 0.f;   // reused frames x EMA of the work a run costs
+};
+
+class MotionGate {
+public:
+    void configure(const MotionGateConfig& c);
+    void reset();
+
+    // true = run the pipeline on this frame, false = reuse the last result
+    bool shouldRun(const uint8_t* y, int w, int h, int rowStride);
+
+    // Time the pipeline took on a frame that ran, for savedMs
+    void reportRunMs(float ms);
+
+    // Share of changed blocks in the last decision (0 for the first frame)
+    float lastChange() const { return changed; }
+    const MotionGateStats& stats() const { return st; }
+
+private:
+    void blockMeans(const uint8_t* y, int w, int h, int rowStride, std::vector<float>& out) const;
+
+    MotionGateConfig cfg;
+    std::vector<float> ref, cur;   // block means of the last run frame / this frame
+    int refW = 0, refH = 0;
+    int stale = 0;
+    float changed = 0.f;
+    float emaRunMs = 0.f;
+    MotionGateStats st;
+};
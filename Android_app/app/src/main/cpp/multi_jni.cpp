@@ -0,0 +1,139 @@
+#include <jni.h>
+#include <android/asset_manager_jni.h>
+
+#include <classifier.cpp>
+#include "frame_context.hpp"
+#include "yolov11seg.hpp"
+
+// All three engines on one shared frame (MainActivity.MultiBridge): the frame is
+// rotated / letterboxed once by FrameContext, then the detector (640 level),
+// the seg model (320 level, boxes only) and ResNet-50 (224 level) run
+// concurrently through FrameFanout. Own model instances, as the cascade.
+// The engines share one kMultiThreads budget instead of running their nets'
+// full thread counts side by side; the detector takes the remainder.
+static YoloV8* g_multiDet = nullptr;
+static YoloV11Seg* g_multiSeg = nullptr;
+static ResNet50 g_multiCls;
+
+static FrameContext g_frame;
+static FrameFanout g_fanout;
+
+static constexpr int kDetSize = 640;
+static constexpr int kSegSize = 320;
+static constexpr int kMultiThreads = 4;   // the nets' own single-engine default
+
+// Results of the last runRgba, one slot per engine
+static std::vector<Det> g_multiDets;
+static std::vector<SegDet> g_multiSegs;
+static std::vector<std::pair<int,float>> g_multiTop;
+
+static void multi_release() {
+    g_fanout.clear();
+    if (g_multiDet) { g_multiDet->clear(); delete g_multiDet; g_multiDet = nullptr; }
+    if (g_multiSeg) { g_multiSeg->clear(); delete g_multiSeg; g_multiSeg = nullptr; }
+    g_multiCls.clear();
+}
+
+extern "C" {
+
+// Loads and registers the enabled engines; the pyramid only holds their levels
+JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_MainActivity_00024MultiBridge_init(
+        JNIEnv* env, jobject /*thiz*/, jobject assetMgr,
+        jboolean det, jboolean seg, jboolean cls) {
+    AAssetManager* mgr = AAssetManager_fromJava(env, assetMgr);
+    multi_release();
+
+    FrameContextConfig cfg;
+    cfg.sizes.clear();
+    cfg.classifierSize = 0;
+    bool ok = true;
+
+    if (det == JNI_TRUE) {
+        g_multiDet = new YoloV8();
+        ok = ok && g_multiDet->load(mgr, "yolov8n.param", "yolov8n.bin");
+        cfg.sizes.push_back(kDetSize);
+        g_fanout.add("det", [](const FrameContext& ctx) {
+            Letterbox lb;
+            const ncnn::Mat& in = ctx.input(kDetSize, lb);
+            g_multiDets = in.empty() ? std::vector<Det>() : g_multiDet->infer(in, lb, 0.25f, 0.45f);
+        });
+    }
+    if (seg == JNI_TRUE) {
+        g_multiSeg = new YoloV11Seg();
+        ok = ok && g_multiSeg->loadForSize(mgr, kSegSize);
+        cfg.sizes.push_back(kSegSize);
+        g_fanout.add("seg", [](const FrameContext& ctx) {
+            Letterbox lb;
+            const ncnn::Mat& in = ctx.input(kSegSize, lb);
+            g_multiSegs = g_multiSeg->detect_letterboxed(in, lb, ctx.srcW(), ctx.srcH(), ctx.rotation(),
+                                                         0.25f, 0.45f, kSegSize, SegOutput::Boxes);
+        });
+    }
+    if (cls == JNI_TRUE) {
+        ok = ok && g_multiCls.load(mgr, "resnet50.param", "resnet50.bin");
+        cfg.classifierSize = ResNet50::kSide;
+        std::copy(ResNet50::kMean, ResNet50::kMean + 3, cfg.clsMean);
+        std::copy(ResNet50::kNorm, ResNet50::kNorm + 3, cfg.clsNorm);
+        g_fanout.add("cls", [](const FrameContext& ctx) {
+            g_multiTop = g_multiCls.classify_input(ctx.classifierInput(), 5);
+        });
+    }
+    if (cfg.sizes.empty()) cfg.sizes.push_back(kDetSize);  // classifier level is cut from it
+
+    const int engines = std::max(1, (int)g_fanout.size());
+    const int share = std::max(1, kMultiThreads / engines);
+    if (g_multiDet) g_multiDet->setNumThreads(share + kMultiThreads % engines);
+    if (g_multiSeg) g_multiSeg->setNumThreads(share);
+    if (cls == JNI_TRUE) g_multiCls.setNumThreads(share);
+    g_frame.configure(cfg);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024MultiBridge_release(
+        JNIEnv*, jobject) {
+    multi_release();
+}
+
+// Packed result: [buildMs, detMs, segMs, clsMs, nDet, nSeg, nTop], then nDet rows
+// of [x1,y1,x2,y2,score,cls] (upright frame), nSeg rows of the same (source
+// frame, as detectRgbaBoxesOnly) and nTop [cls, prob] pairs. Engine times are
+// 0 for engines that are not registered.
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_MainActivity_00024MultiBridge_runRgba(
+        JNIEnv* env, jobject /*thiz*/, jobject buf,
+        jint w, jint h, jint rowStride, jint rotDeg) {
+    const uint8_t* rgba = (const uint8_t*)env->GetDirectBufferAddress(buf);
+    if (g_fanout.size() == 0 || !g_frame.build(rgba, w, h, rowStride, rotDeg)) return env->NewFloatArray(0);
+
+    g_multiDets.clear();
+    g_multiSegs.clear();
+    g_multiTop.clear();
+    g_fanout.run(g_frame);
+
+    std::vector<float> packed(7, 0.f);
+    packed[0] = g_frame.buildMs();
+    for (size_t i = 0; i < g_fanout.size(); ++i) {
+        const std::string& n = g_fanout.name(i);
+        packed[n == "det" ? 1 : n == "seg" ? 2 : 3] = g_fanout.engineMs(i);
+    }
+    packed[4] = (float)g_multiDets.size();
+    packed[5] = (float)g_multiSegs.size();
+    packed[6] = (float)g_multiTop.size();
+    for (const Det& d : g_multiDets) {
+        packed.insert(packed.end(), {d.x1, d.y1, d.x2, d.y2, d.score, (float)d.cls});
+    }
+    for (const SegDet& d : g_multiSegs) {
+        packed.insert(packed.end(), {d.x1, d.y1, d.x2, d.y2, d.score, (float)d.cls});
+    }
+    for (const auto& t : g_multiTop) {
+        packed.insert(packed.end(), {(float)t.first, t.second});
+    }
+
+    jfloatArray out = env->NewFloatArray((jsize)packed.size());
+    env->SetFloatArrayRegion(out, 0, (jsize)packed.size(), packed.data());
+    return out;
+}
+
+} // extern "C"
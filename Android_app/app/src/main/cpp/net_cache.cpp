@@ -0,0 +1,98 @@
+#include "net_cache.hpp"
+#include <android/log.h>
+#include <cstdio>
+
+#define LOG_TAG "netcache"
+
+std::string NetKey::str() const {
+    char buf[160];
+    snprintf(buf, sizeof(buf), "%s|%d|%d", model.c_str(), inputSize, profile);
+    return buf;
+}
+
+ncnn::Net* NetCache::acquire(const NetKey& key, size_t costBytes, const Loader& loader) {
+    const std::string k = key.str();
+
+    auto it = index.find(k);
+    if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        hits++;
+        return lru.front().net.get();
+    }
+
+    Entry e;
+    e.key = k;
+    e.cost = costBytes;
+    e.net.reset(new ncnn::Net());
+    if (!loader(*e.net)) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "load failed for %s", k.c_str());
+        return nullptr;
+    }
+
+    // Evict only once the new net is usable: a failed load must not cost the
+    // caller the net it is currently running (the budget is exceeded briefly).
+    evictFor(costBytes);
+
+    lru.push_front(std::move(e));
+    index[k] = lru.begin();
+    usedBytes += costBytes;
+    loads++;
+
+    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "loaded %s (%zu KB, cache %zu/%zu KB, %zu entries)",
+                        k.c_str(), costBytes / 1024, usedBytes / 1024, budgetBytes / 1024, lru.size());
+    return lru.front().net.get();
+}
+
+void NetCache::evictFor(size_t incoming) {
+    while (!lru.empty() && usedBytes + incoming > budgetBytes) {
+        Entry& victim = lru.back();
+        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "evict %s (%zu KB)",
+                            victim.key.c_str(), victim.cost / 1024);
+        usedBytes -= victim.cost;
+        victim.net->clear();
+        index.erase(victim.key);
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+void NetCache::setBudget(size_t bytes) {
+    budgetBytes = bytes;
+    // Keep the most recent entry even if it alone exceeds the budget:
+    // it is the net currently in use.
+    while (lru.size() > 1 && usedBytes > budgetBytes) {
+        Entry& victim = lru.back();
+        usedBytes -= victim.cost;
+        victim.net->clear();
+        index.erase(victim.key);
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+NetCacheStats NetCache::stats() const {
+    NetCacheStats s;
+    s.loads = loads;
+    s.hits = hits;
+    s.evictions = evictions;
+    s.entries = (int)lru.size();
+    s.bytes = usedBytes;
+    s.budget = budgetBytes;
+    return s;
+}
+
+void NetCache::clear() {
+    for (Entry& e : lru) e.net->clear();
+    lru.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+size_t asset_size(AAssetManager* mgr, const char* name) {
+    if (!mgr || !name) return 0;
+    AAsset* a = AAssetManager_open(mgr, name, AASSET_MODE_UNKNOWN);
+    if (!a) return 0;
+    size_t n = (size_t)AAsset_getLength(a);
+    AAsset_close(a);
+    return n;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <android/asset_manager.h>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "ncnn/net.h"
+
+// Identifies one loaded variant: model name + input size + profile bits
+// (bit 0 = optimized Option set, see YoloV8::setOptimized;
+//  bit 1 = FastSwish override, see YoloV8::setFastSwish).
+struct NetKey {
+    std::string model;
+    int inputSize = 0;
+    int profile = 0;
+
+    std::string str() const;
+};
+
+struct NetCacheStats {
+    int loads = 0;
+    int hits = 0;
+    int evictions = 0;
+    int entries = 0;
+    size_t bytes = 0;
+    size_t budget = 0;
+};
+
+// LRU cache of loaded ncnn::Net instances with a memory budget.
+// Switching to a cached variant is a hash lookup + list splice, no reload.
+class NetCache {
+public:
+    using Loader = std::function<bool(ncnn::Net& net)>;
+
+    explicit NetCache(size_t budgetBytes = 64u * 1024u * 1024u) : budgetBytes(budgetBytes) {}
+
+    // Returns the cached net for key, or creates one and runs loader on it.
+    // costBytes is the estimated resident size (usually the .bin size).
+    // Returns nullptr if loader fails; cached entries are then left untouched,
+    // eviction only happens after a successful load. The returned pointer stays valid until
+    // the entry is evicted by a later acquire() or clear().
+    ncnn::Net* acquire(const NetKey& key, size_t costBytes, const Loader& loader);
+
+    void setBudget(size_t bytes);
+    size_t budget() const { return budgetBytes; }
+
+    NetCacheStats stats() const;
+    void resetStats() { loads = hits = evictions = 0; }
+
+    void clear();
+
+private:
+    struct Entry {
+        std::string key;
+        size_t cost = 0;
+        std::unique_ptr<ncnn::Net> net;
+    };
+
+    // Drops least recently used entries until `incoming` more bytes fit.
+    void evictFor(size_t incoming);
+
+    std::list<Entry> lru;  // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+    int loads = 0;
+    int hits = 0;
+    int evictions = 0;
+};
+
+// Size of an asset in bytes, 0 if it cannot be opened.
+size_t asset_size(AAssetManager* mgr, const char* name);
@@ -0,0 +1,293 @@
+#include "object_tracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ByteTrack's noise model: std proportional to the box height
+static constexpr float kStdPos = 1.f / 20.f;
+static constexpr float kStdVel = 1.f / 160.f;
+
+void ByteTracker::Kalman::initiate(const float z[4]) {
+    const float h = z[3];
+    const float sp[4] = {2 * kStdPos * h, 2 * kStdPos * h, 1e-2f, 2 * kStdPos * h};
+    const float sv[4] = {10 * kStdVel * h, 10 * kStdVel * h, 1e-5f, 10 * kStdVel * h};
+    for (int i = 0; i < 4; ++i) {
+        x[i] = z[i];
+        v[i] = 0.f;
+        P[i][0] = sp[i] * sp[i];
+        P[i][1] = 0.f;
+        P[i][2] = sv[i] * sv[i];
+    }
+}
+
+void ByteTracker::Kalman::predict() {
+    const float h = x[3];
+    const float sp[4] = {kStdPos * h, kStdPos * h, 1e-2f, kStdPos * h};
+    const float sv[4] = {kStdVel * h, kStdVel * h, 1e-5f, kStdVel * h};
+    for (int i = 0; i < 4; ++i) {
+        x[i] += v[i];
+        // P = F P F^T + Q with F = [[1, 1], [0, 1]]
+        const float p00 = P[i][0], p01 = P[i][1], p11 = P[i][2];
+        P[i][0] = p00 + 2 * p01 + p11 + sp[i] * sp[i];
+        P[i][1] = p01 + p11;
+        P[i][2] = p11 + sv[i] * sv[i];
+    }
+}
+
+void ByteTracker::Kalman::update(const float z[4]) {
+    const float h = x[3];
+    const float r[4] = {kStdPos * h, kStdPos * h, 1e-1f, kStdPos * h};
+    for (int i = 0; i < 4; ++i) {
+        const float p00 = P[i][0], p01 = P[i][1], p11 = P[i][2];
+        const float s = p00 + r[i] * r[i];
+        const float k0 = p00 / s, k1 = p01 / s;
+        const float y = z[i] - x[i];
+        x[i] += k0 * y;
+        v[i] += k1 * y;
+        P[i][0] = p00 - k0 * p00;
+        P[i][1] = p01 - k0 * p01;
+        P[i][2] = p11 - k1 * p01;
+    }
+}
+
+void ByteTracker::toXyah(const Det& d, float z[4]) {
+    const float w = std::max(1e-3f, d.x2 - d.x1);
+    const float h = std::max(1e-3f, d.y2 - d.y1);
+    z[0] = d.x1 + w * 0.5f;
+    z[1] = d.y1 + h * 0.5f;
+    z[2] = w / h;
+    z[3] = h;
+}
+
+void ByteTracker::toBox(const Kalman& kf, float& x1, float& y1, float& x2, float& y2) {
+    const float h = kf.x[3];
+    const float w = kf.x[2] * h;
+    x1 = kf.x[0] - w * 0.5f;
+    y1 = kf.x[1] - h * 0.5f;
+    x2 = x1 + w;
+    y2 = y1 + h;
+}
+
+static float iou(float ax1, float ay1, float ax2, float ay2, const Det& b) {
+    const float iw = std::max(0.f, std::min(ax2, b.x2) - std::max(ax1, b.x1));
+    const float ih = std::max(0.f, std::min(ay2, b.y2) - std::max(ay1, b.y1));
+    const float inter = iw * ih;
+    const float uni = (ax2 - ax1) * (ay2 - ay1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
+    return uni > 0.f ? inter / uni : 0.f;
+}
+
+// Shortest augmenting path Hungarian with potentials, O(n^2 m) for n <= m.
+// Costs above maxCost are clamped to maxCost + eps before solving: every
+// full assignment then pays the same for each rejected pair, which is
+// lapjv's cost_limit objective, so an infeasible pair (e.g. class mismatch)
+// cannot push another row off its good match.
+std::vector<int> hungarian_assign(const std::vector<float>& cost, int rows, int cols, float maxCost) {
+    std::vector<int> match(rows, -1);
+    if (rows == 0 || cols == 0) return match;
+
+    const bool transposed = rows > cols;
+    const int n = transposed ? cols : rows;
+    const int m = transposed ? rows : cols;
+    auto raw = [&](int i, int j) {  // 0-based, in the n <= m orientation
+        return transposed ? cost[(size_t)j * cols + i] : cost[(size_t)i * cols + j];
+    };
+    const float limit = maxCost + 1e-4f;
+    auto at = [&](int i, int j) { return std::min(raw(i, j), limit); };
+
+    const float INF = std::numeric_limits<float>::infinity();
+    std::vector<float> u(n + 1, 0.f), v(m + 1, 0.f);
+    std::vector<int> p(m + 1, 0), way(m + 1, 0);
+    for (int i = 1; i <= n; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        std::vector<float> minv(m + 1, INF);
+        std::vector<char> used(m + 1, 0);
+        do {
+            used[j0] = 1;
+            const int i0 = p[j0];
+            float delta = INF;
+            int j1 = 0;
+            for (int j = 1; j <= m; ++j) {
+                if (used[j]) continue;
+                const float cur = at(i0 - 1, j - 1) - u[i0] - v[j];
+                if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
+                if (minv[j] < delta) { delta = minv[j]; j1 = j; }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) { u[p[j]] += delta; v[j] -= delta; }
+                else minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            const int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    for (int j = 1; j <= m; ++j) {
+        if (p[j] == 0) continue;
+        const int i = p[j] - 1, jj = j - 1;
+        if (raw(i, jj) > maxCost) continue;
+        if (transposed) match[jj] = i;
+        else match[i] = jj;
+    }
+    return match;
+}
+
+void ByteTracker::configure(const TrackerConfig& c) {
+    cfg = c;
+    cfg.detectEvery = std::max(1, cfg.detectEvery);
+    reset();
+}
+
+void ByteTracker::reset() {
+    tracks.clear();
+    out.clear();
+    frameId = 0;
+    lastDetectFrame = -1;
+    nextId = 1;
+}
+
+bool ByteTracker::needsDetection() const {
+    if (lastDetectFrame < 0 || frameId + 1 - lastDetectFrame >= cfg.detectEvery) return true;
+    // Relative to the score each track was last matched at: tracks refreshed by
+    // a low-score box (second pass) would otherwise force the detector at once
+    for (const Track& t : tracks) {
+        if (t.state != State::Tracked || !t.activated) continue;
+        if (std::pow(cfg.confDecay, (float)(frameId - t.lastFrame)) < cfg.minTrackConf) return true;
+    }
+    return false;
+}
+
+void ByteTracker::stepFilters() {
+    for (Track& t : tracks) {
+        // A lost track's box stops moving, as in ByteTrack (zero height velocity)
+        if (t.state != State::Tracked) t.kf.v[3] = 0.f;
+        t.kf.predict();
+    }
+}
+
+const std::vector<TrackedObject>& ByteTracker::predict() {
+    frameId++;
+    stepFilters();
+    publish();
+    return out;
+}
+
+const std::vector<TrackedObject>& ByteTracker::update(const std::vector<Det>& dets) {
+    frameId++;
+    lastDetectFrame = frameId;
+    stepFilters();
+
+    std::vector<int> high, low;
+    for (int i = 0; i < (int)dets.size(); ++i) {
+        if (dets[i].score >= cfg.trackThresh) high.push_back(i);
+        else if (dets[i].score >= cfg.lowThresh) low.push_back(i);
+    }
+
+    // Associates tracks[ti] with dets[di] (class-aware 1 - IoU, scaled by the
+    // detection score as ByteTrack's fuse_score) and applies the matches.
+    // Matched entries are erased from ti / di.
+    auto associate = [&](std::vector<int>& ti, std::vector<int>& di, float maxCost, bool fuseScore) {
+        const int R = (int)ti.size(), C = (int)di.size();
+        if (R == 0 || C == 0) return;
+        std::vector<float> cost((size_t)R * C, 1e6f);
+        for (int r = 0; r < R; ++r) {
+            const Track& t = tracks[ti[r]];
+            float x1, y1, x2, y2;
+            toBox(t.kf, x1, y1, x2, y2);
+            for (int c = 0; c < C; ++c) {
+                const Det& d = dets[di[c]];
+                if (d.cls != t.cls) continue;
+                float sim = iou(x1, y1, x2, y2, d);
+                if (fuseScore) sim *= d.score;
+                cost[(size_t)r * C + c] = 1.f - sim;
+            }
+        }
+        std::vector<int> match = hungarian_assign(cost, R, C, maxCost);
+
+        std::vector<char> detUsed(C, 0);
+        std::vector<int> restT;
+        for (int r = 0; r < R; ++r) {
+            if (match[r] < 0) { restT.push_back(ti[r]); continue; }
+            Track& t = tracks[ti[r]];
+            const Det& d = dets[di[match[r]]];
+            float z[4];
+            toXyah(d, z);
+            t.kf.update(z);
+            t.score = d.score;
+            t.lastFrame = frameId;
+            t.state = State::Tracked;
+            t.activated = true;
+            detUsed[match[r]] = 1;
+        }
+        std::vector<int> restD;
+        for (int c = 0; c < C; ++c) if (!detUsed[c]) restD.push_back(di[c]);
+        ti.swap(restT);
+        di.swap(restD);
+    };
+
+    // 1) high-score boxes vs activated tracks (tracked and lost)
+    std::vector<int> pool, unconfirmed;
+    for (int i = 0; i < (int)tracks.size(); ++i) {
+        if (tracks[i].activated) pool.push_back(i);
+        else unconfirmed.push_back(i);
+    }
+    associate(pool, high, cfg.matchThresh, true);
+
+    // 2) low-score boxes vs tracks that were tracked last frame and are still unmatched
+    std::vector<int> tracked, lostPool;
+    for (int i : pool) {
+        if (tracks[i].state == State::Tracked) tracked.push_back(i);
+        else lostPool.push_back(i);
+    }
+    associate(tracked, low, 0.5f, false);
+    for (int i : tracked) tracks[i].state = State::Lost;
+
+    // 3) one-frame-old tracks get a second chance with the remaining high boxes
+    associate(unconfirmed, high, 0.7f, true);
+    for (int i : unconfirmed) tracks[i].state = State::Removed;
+
+    // 4) new tracks; the very first frame activates them right away
+    for (int di : high) {
+        const Det& d = dets[di];
+        if (d.score < cfg.newTrackThresh) continue;
+        Track t;
+        float z[4];
+        toXyah(d, z);
+        t.kf.initiate(z);
+        t.state = State::Tracked;
+        t.activated = frameId == 1;
+        t.id = nextId++;
+        t.cls = d.cls;
+        t.score = d.score;
+        t.startFrame = t.lastFrame = frameId;
+        tracks.push_back(t);
+    }
+
+    // 5) forget tracks lost for longer than the buffer
+    for (Track& t : tracks) {
+        if (t.state == State::Lost && frameId - t.lastFrame > cfg.trackBuffer) t.state = State::Removed;
+    }
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
+                                [](const Track& t) { return t.state == State::Removed; }),
+                 tracks.end());
+
+    publish();
+    return out;
+}
+
+void ByteTracker::publish() {
+    out.clear();
+    for (const Track& t : tracks) {
+        if (t.state != State::Tracked || !t.activated) continue;
+        TrackedObject o;
+        toBox(t.kf, o.x1, o.y1, o.x2, o.y2);
+        o.score = t.score * std::pow(cfg.confDecay, (float)(frameId - t.lastFrame));
+        o.cls = t.cls;
+        o.id = t.id;
+        out.push_back(o);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include "yolov8.hpp"
+
+// ByteTrack-style multi-object tracker for the camera path.
+//
+// Each track carries a constant-velocity Kalman filter on (cx, cy, aspect, h).
+// Detector frames associate in two passes: high-score boxes against all
+// tracks, then low-score boxes against the tracks still unmatched, so briefly
+// occluded objects keep their id. Matching is class-aware Hungarian on 1 - IoU.
+// On skipped frames tracks are only propagated by the filter (microseconds).
+//
+// needsDetection() tells the caller when to run the detector again: every
+// `detectEvery` frames, or earlier when a tracked object's confidence has
+// decayed below `minTrackConf` times the score it was last matched at.
+struct TrackerConfig {
+    float trackThresh = 0.5f;     // high / low score split of the detections
+    float lowThresh = 0.1f;       // detections below this are ignored
+    float newTrackThresh = 0.6f;  // unmatched high-score box starts a track
+    float matchThresh = 0.8f;     // max 1 - IoU for the first pass
+    int trackBuffer = 30;         // frames a lost track is kept for re-identification
+    int detectEvery = 3;          // detector period in frames (1 = every frame)
+    float minTrackConf = 0.3f;    // re-detect once confDecay^age drops below this
+    float confDecay = 0.9f;       // per propagated frame
+};
+
+struct TrackedObject {
+    float x1, y1, x2, y2;
+    float score;   // last detector score, decayed on propagated frames
+    int cls;
+    int id;        // stable across frames, starts at 1
+};
+
+class ByteTracker {
+public:
+    void configure(const TrackerConfig& c);
+    void reset();
+
+    // True if the next frame should run the detector.
+    bool needsDetection() const;
+
+    // Detector frame: predict, associate, update. Returns the tracked objects.
+    const std::vector<TrackedObject>& update(const std::vector<Det>& dets);
+
+    // Skipped frame: Kalman prediction only.
+    const std::vector<TrackedObject>& predict();
+
+    const std::vector<TrackedObject>& objects() const { return out; }
+    int frame() const { return frameId; }
+
+private:
+    // Per coordinate the filter is a 2x2 (position, velocity) block; the 8x8
+    // covariance of the xyah model stays block-diagonal, so this is exact.
+    struct Kalman {
+        float x[4] = {0, 0, 0, 0};   // cx, cy, a, h
+        float v[4] = {0, 0, 0, 0};
+        float P[4][3] = {};          // per coord: var(pos), cov(pos,vel), var(vel)
+
+        void initiate(const float z[4]);
+        void predict();
+        void update(const float z[4]);
+    };
+
+    enum class State { Tracked, Lost, Removed };
+
+    struct Track {
+        Kalman kf;
+        State state = State::Tracked;
+        bool activated = false;  // confirmed by a second detection (or frame 1)
+        int id = 0;
+        int cls = 0;
+        float score = 0.f;
+        int startFrame = 0;
+        int lastFrame = 0;   // last frame with a matched detection
+    };
+
+    void stepFilters();
+    void publish();
+    static void toXyah(const Det& d, float z[4]);
+    static void toBox(const Kalman& kf, float& x1, float& y1, float& x2, float& y2);
+
+    TrackerConfig cfg;
+    std::vector<Track> tracks;   // Tracked and Lost; Removed ones are erased
+    std::vector<TrackedObject> out;
+    int frameId = 0;
+    int lastDetectFrame = -1;
+    int nextId = 1;
+};
+
+// Min-cost assignment of a rows x cols cost matrix (row-major). Pairs whose
+// cost exceeds maxCost are left unmatched and do not influence the other
+// pairs (lapjv cost_limit). Returns the matched column per row, -1 if none.
+std::vector<int> hungarian_assign(const std::vector<float>& cost, int rows, int cols, float maxCost);
@@ -0,0 +1,81 @@
+#include "resolution_scheduler.hpp"
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "ressched"
+
+void ResolutionScheduler::configure(float targetMs, const std::vector<int>& s) {
+    target = targetMs > 0.f ? targetMs : 33.f;
+    sizes = s.empty() ? std::vector<int>{320, 480, 640} : s;
+    std::sort(sizes.begin(), sizes.end());
+    reset();
+}
+
+void ResolutionScheduler::reset() {
+    // Start at the largest size and let latency pull it down.
+    level = (int)sizes.size() - 1;
+    ema = 0.f;
+    overCount = 0;
+    underCount = 0;
+    numSwitches = 0;
+}
+
+void ResolutionScheduler::switchTo(int newLevel) {
+    const float ratio = (float)sizes[newLevel] / (float)sizes[level];
+    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "switch %d -> %d (ema=%.1f ms, target=%.1f ms)",
+                        sizes[level], sizes[newLevel], ema, target);
+    // Latency scales roughly with pixel count; seed EMA so the next decision
+    // does not wait for the average to converge from the old size.
+    ema *= ratio * ratio;
+    level = newLevel;
+    overCount = 0;
+    underCount = 0;
+    numSwitches++;
+}
+
+void ResolutionScheduler::exclude(int size, int fallback) {
+    auto it = std::find(sizes.begin(), sizes.end(), size);
+    if (it == sizes.end() || sizes.size() <= 1) return;
+    sizes.erase(it);
+
+    auto fb = std::find(sizes.begin(), sizes.end(), fallback);
+    if (fb != sizes.end()) {
+        level = (int)(fb - sizes.begin());
+    } else {
+        level = 0;
+        for (int i = 0; i < (int)sizes.size(); ++i) {
+            if (sizes[i] < size) level = i;
+        }
+    }
+    __android_log_print(ANDROID_LOG_WARN, LOG_TAG, "size %d unavailable, continuing at %d", size, sizes[level]);
+    // The EMA was measured at another size
+    ema = 0.f;
+    overCount = 0;
+    underCount = 0;
+}
+
+int ResolutionScheduler::update(float frameMs) {
+    if (sizes.empty()) return 640;
+
+    ema = (ema <= 0.f) ? frameMs : ema + alpha * (frameMs - ema);
+
+    if (ema > target) {
+        overCount++;
+        underCount = 0;
+        if (overCount >= downFrames && level > 0) switchTo(level - 1);
+        return current();
+    }
+    overCount = 0;
+
+    if (level + 1 < (int)sizes.size()) {
+        const float ratio = (float)sizes[level + 1] / (float)sizes[level];
+        const float predicted = ema * ratio * ratio;
+        if (predicted < target * upMargin) {
+            underCount++;
+            if (underCount >= upFrames) switchTo(level + 1);
+        } else {
+            underCount = 0;
+        }
+    }
+    return current();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+
+// Picks the input resolution for the next camera frame from measured
+// per-frame latency, so the detector holds a target frame time under load
+// or thermal throttling.
+//
+// Downshift: EMA latency above target for `downFrames` consecutive frames.
+// Upshift:   EMA latency scaled by the pixel ratio of the next size would
+//            still fit in `upMargin * target` for `upFrames` consecutive frames.
+// After every switch the counters restart, so the two rules cannot flap.
+class ResolutionScheduler {
+public:
+    void configure(float targetMs, const std::vector<int>& sizes = {320, 480, 640});
+    void reset();
+
+    // Size to use for the next frame.
+    int current() const { return sizes.empty() ? 640 : sizes[level]; }
+
+    // Feed latency of the frame just processed at current(); returns next size.
+    int update(float frameMs);
+
+    // Drops a size whose model failed to load and continues at `fallback` (the
+    // size still loaded), or the nearest smaller remaining size. The last
+    // remaining size is never dropped.
+    void exclude(int size, int fallback);
+
+    float emaMs() const { return ema; }
+    float targetMs() const { return target; }
+    int switches() const { return numSwitches; }
+
+private:
+    void switchTo(int newLevel);
+
+    std::vector<int> sizes = {320, 480, 640};
+    int level = 2;
+    float target = 33.f;
+    float ema = 0.f;
+    int overCount = 0;
+    int underCount = 0;
+    int numSwitches = 0;
+
+    float alpha = 0.2f;      // EMA smoothing
+    float upMargin = 0.85f;  // headroom required before going up
+    int downFrames = 5;
+    int upFrames = 30;
+};
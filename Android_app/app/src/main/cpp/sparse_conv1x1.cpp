@@ -0,0 +1,101 @@
+#include "sparse_conv1x1.hpp"
+#include <algorithm>
+#include <cstdint>
+#include "layer_simd.hpp"
+#include "ncnn/modelbin.h"
+#include "ncnn/paramdict.h"
+
+SparseConvolution1x1::SparseConvolution1x1() {
+    one_blob_only = true;
+    support_inplace = false;
+    // Kernel walks whole input channels: take unpacked fp32 blobs
+    support_packing = false;
+    support_fp16_storage = false;
+
+    num_output = 0;
+    num_input = 0;
+    nnz = 0;
+    bias_term = 0;
+    activation_type = 0;
+}
+
+int SparseConvolution1x1::load_param(const ncnn::ParamDict& pd) {
+    num_output = pd.get(0, 0);
+    num_input = pd.get(1, 0);
+    nnz = pd.get(2, 0);
+    bias_term = pd.get(5, 0);
+    activation_type = pd.get(9, 0);
+    activation_params = pd.get(10, ncnn::Mat());
+    return (num_output > 0 && num_input > 0 && nnz >= 0) ? 0 : -1;
+}
+
+int SparseConvolution1x1::load_model(const ncnn::ModelBin& mb) {
+    row_ptr = mb.load(num_output + 1, 1);
+    if (row_ptr.empty()) return -100;
+
+    if (nnz > 0) {
+        col_idx = mb.load(nnz, 1);
+        values = mb.load(nnz, 1);
+        if (col_idx.empty() || values.empty()) return -100;
+    }
+
+    if (bias_term) {
+        bias_data = mb.load(num_output, 1);
+        if (bias_data.empty()) return -100;
+    }
+
+    // Reject a CSR table that would index out of range at forward time
+    const int32_t* rp = row_ptr;
+    const int32_t* ci = col_idx;
+    if (rp[0] != 0 || rp[num_output] != nnz) return -1;
+    for (int p = 0; p < num_output; p++)
+        if (rp[p + 1] < rp[p]) return -1;
+    for (int k = 0; k < nnz; k++)
+        if (ci[k] < 0 || ci[k] >= num_input) return -1;
+    return 0;
+}
+
+int SparseConvolution1x1::forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const {
+    if (bottom_blob.c != num_input || bottom_blob.elempack != 1) return -1;
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int size = w * h;
+
+    top_blob.create(w, h, num_output, 4u, opt.blob_allocator);
+    if (top_blob.empty()) return -100;
+
+    const int32_t* rp = row_ptr;
+    const int32_t* ci = col_idx;
+    const float* val = values;
+
+    // Output tile stays in L1 while all nonzeros of the row are accumulated
+    const int tile = 1024;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < num_output; p++) {
+        float* out = top_blob.channel(p);
+        const float b = bias_term ? bias_data[p] : 0.f;
+        const int k0 = rp[p];
+        const int k1 = rp[p + 1];
+
+        for (int t = 0; t < size; t += tile) {
+            const int n = std::min(tile, size - t);
+            float* o = out + t;
+            std::fill(o, o + n, b);
+
+            int k = k0;
+            for (; k + 1 < k1; k += 2) {
+                const float* a = (const float*)bottom_blob.channel(ci[k]) + t;
+                const float* c = (const float*)bottom_blob.channel(ci[k + 1]) + t;
+                axpy2(o, a, val[k], c, val[k + 1], n);
+            }
+            if (k < k1) axpy1(o, (const float*)bottom_blob.channel(ci[k]) + t, val[k], n);
+
+            activate(o, n, activation_type, activation_params);
+        }
+    }
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(SparseConvolution1x1)
@@ -0,0 +1,37 @@
+#pragma once
+#include "ncnn/layer.h"
+
+// 1x1 stride-1 convolution with CSR-compressed weights, for pointwise convs
+// pruned by xtrim sparse_1x1. Written by NcnnConverter.sparsify_1x1 in place of
+// a dense Convolution whose density is below the configured threshold:
+//   SparseConvolution1x1 conv_12 1 1 in out 0=128 1=64 2=2150 5=1 9=1
+// Params: 0=num_output 1=num_input 2=nnz 5=bias_term
+//         9=activation_type 10=activation_params (same meaning as Convolution)
+// Model:  row_ptr[num_output+1] int32, col_idx[nnz] int32, values[nnz] fp32,
+//         bias[num_output] fp32 (if bias_term), all raw (no ncnn tag)
+//
+// Work is proportional to nnz: every output channel accumulates only the input
+// channels it has weights for, spatial tile by spatial tile.
+class SparseConvolution1x1 : public ncnn::Layer {
+public:
+    SparseConvolution1x1();
+
+    virtual int load_param(const ncnn::ParamDict& pd);
+    virtual int load_model(const ncnn::ModelBin& mb);
+    virtual int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const;
+
+public:
+    int num_output;
+    int num_input;
+    int nnz;
+    int bias_term;
+    int activation_type;
+    ncnn::Mat activation_params;
+
+    ncnn::Mat row_ptr;  // int32 bits
+    ncnn::Mat col_idx;  // int32 bits
+    ncnn::Mat values;
+    ncnn::Mat bias_data;
+};
+
+ncnn::Layer* SparseConvolution1x1_layer_creator(void* userdata);
@@ -0,0 +1,151 @@
+#include "tensor_cache.hpp"
+#include <android/log.h>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "tensorcache"
+
+static const uint32_t kVersion = 1;
+static const size_t kDataOffset = 4096;
+
+bool TensorCache::open(const char* path, int imgsz) {
+    close();
+    if (!path || imgsz <= 0) return false;
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < kDataOffset) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping keeps the file alive
+    if (p == MAP_FAILED) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "mmap failed: %s", path);
+        return false;
+    }
+
+    const TensorCacheHeader* h = (const TensorCacheHeader*)p;
+    const size_t frameBytes = (size_t)imgsz * imgsz * 3;
+    const size_t tableEnd = (size_t)h->tableOffset + (size_t)h->count * sizeof(TensorCacheEntry);
+    if (memcmp(h->magic, "XTC1", 4) != 0 || h->version != kVersion || (int)h->imgsz != imgsz ||
+        h->tableOffset != kDataOffset + (uint64_t)h->count * frameBytes || tableEnd != (size_t)st.st_size) {
+        __android_log_print(ANDROID_LOG_WARN, LOG_TAG, "stale or foreign cache: %s", path);
+        munmap(p, (size_t)st.st_size);
+        return false;
+    }
+
+    base = (uint8_t*)p;
+    length = (size_t)st.st_size;
+    dst = imgsz;
+    count = (int)h->count;
+    table = (const TensorCacheEntry*)(base + h->tableOffset);
+    madvise(base, length, MADV_WILLNEED);
+
+    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "opened %s: %d frames @%d (%zu MB)",
+                        path, count, dst, length >> 20);
+    return true;
+}
+
+void TensorCache::close() {
+    if (base) munmap(base, length);
+    base = nullptr;
+    length = 0;
+    count = 0;
+    table = nullptr;
+}
+
+const uint8_t* TensorCache::frame(int index, Letterbox& lb, int& srcW, int& srcH) const {
+    if (!base || index < 0 || index >= count) return nullptr;
+    const TensorCacheEntry& e = table[index];
+    lb.scale = e.scale;
+    lb.pad_w = e.padW;
+    lb.pad_h = e.padH;
+    srcW = e.srcW;
+    srcH = e.srcH;
+    return base + kDataOffset + (size_t)index * dst * dst * 3;
+}
+
+TensorCacheWriter::~TensorCacheWriter() { abort(); }
+
+bool TensorCacheWriter::begin(const char* path, int imgsz) {
+    abort();
+    if (!path || imgsz <= 0) return false;
+
+    finalPath = path;
+    tmpPath = finalPath + ".tmp";
+    f = fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "cannot create %s", tmpPath.c_str());
+        return false;
+    }
+
+    dst = imgsz;
+    frameBuf.resize((size_t)imgsz * imgsz * 3);
+    entries.clear();
+
+    // header is rewritten by finish()
+    std::vector<uint8_t> zeros(kDataOffset, 0);
+    return fwrite(zeros.data(), 1, zeros.size(), f) == zeros.size();
+}
+
+bool TensorCacheWriter::append(const uint8_t* rgba, int srcW, int srcH, int rowStride) {
+    if (!f || !rgba || srcW <= 0 || srcH <= 0) return false;
+
+    Letterbox lb;
+    YoloV8::letterbox_rgba_u8(rgba, srcW, srcH, rowStride, 0, dst, frameBuf.data(), lb);
+    if (fwrite(frameBuf.data(), 1, frameBuf.size(), f) != frameBuf.size()) return false;
+
+    TensorCacheEntry e;
+    e.srcW = srcW;
+    e.srcH = srcH;
+    e.scale = lb.scale;
+    e.padW = lb.pad_w;
+    e.padH = lb.pad_h;
+    entries.push_back(e);
+    return true;
+}
+
+int TensorCacheWriter::finish() {
+    if (!f) return -1;
+
+    TensorCacheHeader h;
+    memcpy(h.magic, "XTC1", 4);
+    h.version = kVersion;
+    h.imgsz = (uint32_t)dst;
+    h.count = (uint32_t)entries.size();
+    h.tableOffset = kDataOffset + (uint64_t)entries.size() * frameBuf.size();
+
+    bool ok = fwrite(entries.data(), sizeof(TensorCacheEntry), entries.size(), f) == entries.size();
+    ok = ok && fseek(f, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&h, sizeof(h), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    f = nullptr;
+
+    if (!ok || rename(tmpPath.c_str(), finalPath.c_str()) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "failed to write %s", finalPath.c_str());
+        unlink(tmpPath.c_str());
+        return -1;
+    }
+    // other runs (and the shell user) read the same file
+    chmod(finalPath.c_str(), 0644);
+
+    __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "built %s: %zu frames @%d",
+                        finalPath.c_str(), entries.size(), dst);
+    return (int)entries.size();
+}
+
+void TensorCacheWriter::abort() {
+    if (f) {
+        fclose(f);
+        f = nullptr;
+        unlink(tmpPath.c_str());
+    }
+    entries.clear();
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "yolov8.hpp"
+
+// Pre-letterboxed uint8 RGB frames for one dataset subset and one imgsz,
+// stored in a single file and memory-mapped for reading. Lets repeated
+// benchmark launches skip JPEG decoding and keep large image sets out of
+// the Java heap.
+//
+// File layout (little endian):
+//   [0, 4096)    TensorCacheHeader
+//   [4096, ...)  count frames of imgsz*imgsz*3 bytes
+//   tableOffset  count TensorCacheEntry records
+struct TensorCacheHeader {
+    char magic[4];          // "XTC1"
+    uint32_t version;
+    uint32_t imgsz;
+    uint32_t count;
+    uint64_t tableOffset;
+};
+
+struct TensorCacheEntry {
+    int32_t srcW, srcH;
+    float scale;
+    int32_t padW, padH;
+};
+
+class TensorCache {
+public:
+    ~TensorCache() { close(); }
+
+    // Maps path; fails if the file is missing, truncated or built for another imgsz
+    bool open(const char* path, int imgsz);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    int size() const { return count; }
+    int imgsz() const { return dst; }
+
+    // Letterboxed RGB frame and its letterbox/source size, nullptr if out of range
+    const uint8_t* frame(int index, Letterbox& lb, int& srcW, int& srcH) const;
+
+private:
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    int dst = 0;
+    int count = 0;
+    const TensorCacheEntry* table = nullptr;
+};
+
+// Builds a cache file next to its final path (`path.tmp`) and renames it on
+// finish(), so a killed run never leaves a half-written cache behind.
+class TensorCacheWriter {
+public:
+    ~TensorCacheWriter();
+
+    bool begin(const char* path, int imgsz);
+    bool append(const uint8_t* rgba, int srcW, int srcH, int rowStride);
+    // Returns the number of frames written, -1 on error
+    int finish();
+    void abort();
+
+private:
+    FILE* f = nullptr;
+    std::string finalPath;
+    std::string tmpPath;
+    int dst = 0;
+    std::vector<uint8_t> frameBuf;
+    std::vector<TensorCacheEntry> entries;
+};
@@ -0,0 +1,162 @@
+#include "yolo_detection_output.hpp"
+#include <algorithm>
+#include <vector>
+#include "ncnn/paramdict.h"
+
+YoloV8DetectionOutput::YoloV8DetectionOutput() {
+    one_blob_only = true;
+    support_inplace = false;
+    // Read the head's packed fp16 output as is instead of having ncnn insert
+    // an unpack + fp32 cast of the whole [feat x anchors] blob before us
+    support_packing = true;
+    support_fp16_storage = true;
+
+    num_class = 80;
+    conf_thresh = 0.25f;
+    nms_thresh = 0.45f;
+    max_det = 300;
+    mask_dim = 0;
+}
+
+int YoloV8DetectionOutput::load_param(const ncnn::ParamDict& pd) {
+    num_class = pd.get(0, 80);
+    conf_thresh = pd.get(1, 0.25f);
+    nms_thresh = pd.get(2, 0.45f);
+    max_det = pd.get(3, 300);
+    mask_dim = pd.get(4, 0);
+    return 0;
+}
+
+namespace {
+struct Cand {
+    float x1, y1, x2, y2, score;
+    int cls;
+    int anchor;
+};
+
+inline float iou(const Cand& a, const Cand& b) {
+    float iw = std::max(0.f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+    float ih = std::max(0.f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+    float inter = iw * ih;
+    float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+    float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+    return inter / (area_a + area_b - inter + 1e-6f);
+}
+}  // namespace
+
+int YoloV8DetectionOutput::forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const {
+    const int feat = 4 + num_class + mask_dim;
+    const int ep = bottom_blob.elempack;
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h * ep;
+    const bool fp16 = bottom_blob.elembits() == 16;
+
+    // [feat x anchors] planar (w = anchors) or one row per anchor (w = feat)
+    bool rows = false;
+    int anchors = 0;
+    if (h == feat) {
+        anchors = w;
+    } else if (w == feat) {
+        anchors = h;
+        rows = true;
+    } else {
+        return -1;
+    }
+
+    // Packing interleaves `ep` consecutive rows: element (x, y) sits at
+    // ((y / ep) * w + x) * ep + y % ep. Split into feature + anchor offsets.
+    auto packed = [&](int x, int y) -> size_t { return ((size_t)(y / ep) * w + x) * ep + y % ep; };
+    std::vector<size_t> foff(feat);
+    for (int j = 0; j < feat; ++j) foff[j] = rows ? packed(j, 0) : packed(0, j);
+    auto aoff = [&](int i) -> size_t { return rows ? packed(0, i) : packed(i, 0); };
+
+    const float* base32 = bottom_blob;
+    const unsigned short* base16 = bottom_blob;
+    auto at = [&](int j, int i) -> float {
+        const size_t k = foff[j] + aoff(i);
+        return fp16 ? ncnn::float16_to_float32(base16[k]) : base32[k];
+    };
+
+    // Score scan is the bulk of the work: split anchors across threads
+    const int nt = std::max(1, opt.num_threads);
+    std::vector<std::vector<Cand>> local(nt);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < nt; ++t) {
+        const int begin = (int)((long long)anchors * t / nt);
+        const int end = (int)((long long)anchors * (t + 1) / nt);
+        std::vector<Cand>& out = local[t];
+        for (int i = begin; i < end; ++i) {
+            const size_t a = aoff(i);
+            int cls = -1;
+            float best = conf_thresh;
+            if (fp16) {
+                // Scores are sigmoid outputs: for non-negative halves the bit
+                // patterns order like the values, so convert only the winner
+                unsigned short bestBits = 0;
+                for (int c = 0; c < num_class; ++c) {
+                    const unsigned short b = base16[foff[4 + c] + a];
+                    if (b & 0x8000) continue;
+                    if (cls < 0 || b >= bestBits) { bestBits = b; cls = c; }
+                }
+                if (cls < 0) continue;
+                best = ncnn::float16_to_float32(bestBits);
+                if (best < conf_thresh) continue;
+            } else {
+                for (int c = 0; c < num_class; ++c) {
+                    const float s = base32[foff[4 + c] + a];
+                    if (s >= best) { best = s; cls = c; }
+                }
+                if (cls < 0) continue;
+            }
+
+            const float cx = at(0, i), cy = at(1, i), w = at(2, i), h = at(3, i);
+            Cand d;
+            d.x1 = cx - w * 0.5f;
+            d.y1 = cy - h * 0.5f;
+            d.x2 = cx + w * 0.5f;
+            d.y2 = cy + h * 0.5f;
+            d.score = best;
+            d.cls = cls;
+            d.anchor = i;
+            out.push_back(d);
+        }
+    }
+
+    std::vector<Cand> cands;
+    for (const auto& v : local) cands.insert(cands.end(), v.begin(), v.end());
+    std::sort(cands.begin(), cands.end(), [](const Cand& a, const Cand& b) { return a.score > b.score; });
+
+    // class-aware NMS
+    std::vector<int> keep;
+    std::vector<char> suppressed(cands.size(), 0);
+    for (size_t i = 0; i < cands.size() && (int)keep.size() < max_det; ++i) {
+        if (suppressed[i]) continue;
+        keep.push_back((int)i);
+        for (size_t j = i + 1; j < cands.size(); ++j) {
+            if (!suppressed[j] && cands[j].cls == cands[i].cls && iou(cands[i], cands[j]) > nms_thresh)
+                suppressed[j] = 1;
+        }
+    }
+
+    if (keep.empty()) return 0;
+
+    const int outw = 6 + mask_dim;
+    top_blob.create(outw, (int)keep.size(), 4u, opt.blob_allocator);
+    if (top_blob.empty()) return -100;
+
+    for (size_t k = 0; k < keep.size(); ++k) {
+        const Cand& d = cands[keep[k]];
+        float* row = top_blob.row((int)k);
+        row[0] = d.x1;
+        row[1] = d.y1;
+        row[2] = d.x2;
+        row[3] = d.y2;
+        row[4] = d.score;
+        row[5] = (float)d.cls;
+        for (int m = 0; m < mask_dim; ++m) row[6 + m] = at(4 + num_class + m, d.anchor);
+    }
+    return 0;
+}
+
+DEFINE_LAYER_CREATOR(YoloV8DetectionOutput)
@@ -0,0 +1,30 @@
+#pragma once
+#include "ncnn/layer.h"
+
+// In-graph decode + NMS for dense YOLOv8/v11 (and -seg) heads.
+//
+// Appended to a .param by xtrim (NcnnConverter.append_detection_output):
+//   YoloV8DetectionOutput detout 1 1 out0_raw out0 0=80 1=0.25 2=0.45 3=300 4=0
+// Params: 0=num_class 1=conf_thresh 2=nms_thresh 3=max_det 4=mask_dim
+//
+// Bottom: dense head [4 + num_class + mask_dim] x anchors (either orientation),
+// boxes as cx,cy,w,h in input pixels; any packing, fp32 or fp16 storage.
+// Top:    K rows of [x1,y1,x2,y2,score,cls, mask coeffs...] sorted by score,
+// i.e. exactly the end2end layout, so engines decode it without NMS.
+// Empty when nothing passes conf_thresh.
+class YoloV8DetectionOutput : public ncnn::Layer {
+public:
+    YoloV8DetectionOutput();
+
+    virtual int load_param(const ncnn::ParamDict& pd);
+    virtual int forward(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Option& opt) const;
+
+public:
+    int num_class;
+    float conf_thresh;
+    float nms_thresh;
+    int max_det;
+    int mask_dim;
+};
+
+ncnn::Layer* YoloV8DetectionOutput_layer_creator(void* userdata);
@@ -1,12 +1,59 @@
 #include <jni.h>
 #include <android/asset_manager_jni.h>
+#include <chrono>
 #include "yolov8.hpp"
+#include "resolution_scheduler.hpp"
+#include "map_eval.hpp"
+#include "tensor_cache.hpp"
+#include "yuv_jni.hpp"
+#include "object_tracker.hpp"
+#include "motion_gate.hpp"
 
 static YoloV8* g = nullptr;
 
 // Store AssetManager reference for model reloading
 static AAssetManager* g_assetMgr = nullptr;
 
+// Adaptive input resolution for the camera path
+static ResolutionScheduler g_sched;
+
+// Camera path tracker: the detector runs only when g_tracker asks for it
+static ByteTracker g_tracker;
+
+// ROI mode of the tracked path: between full-frame refreshes the detector only
+// sees crops around the live tracks, run with the small roiSize variant.
+struct RoiPolicy {
+    bool enabled = false;
+    int fullEvery = 4;        // every fullEvery-th detector frame is full-frame
+    int roiSize = 320;
+    float maxAreaFrac = 0.5f; // crops covering more than this go full-frame
+    int detections = 0;
+};
+static RoiPolicy g_roi;
+
+// Static camera frames reuse the last tracked result (trackYuvAdaptive)
+static MotionGate g_gate;
+
+// On-device accuracy of the loaded CLI model (evalReset / evalAddImage / evalResult)
+static MapEvaluator g_eval;
+
+// Memory-mapped pre-letterboxed dataset for the CLI bench (tensorCache*)
+static TensorCache g_tcache;
+static TensorCacheWriter g_tcacheWriter;
+
+static jobjectArray dets_to_java(JNIEnv* env, const std::vector<Det>& dets) {
+    jclass floatArrCls = env->FindClass("[F");
+    jobjectArray out = env->NewObjectArray((jsize)dets.size(), floatArrCls, nullptr);
+    for (jsize i=0;i<(jsize)dets.size();++i){
+        jfloat tmp[6] = {dets[i].x1,dets[i].y1,dets[i].x2,dets[i].y2,dets[i].score,(float)dets[i].cls};
+        jfloatArray row = env->NewFloatArray(6);
+        env->SetFloatArrayRegion(row,0,6,tmp);
+        env->SetObjectArrayElement(out,i,row);
+        env->DeleteLocalRef(row);
+    }
+    return out;
+}
+
 // ===== MainActivity YoloBridge (camera path) =====
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_example_testyolo_MainActivity_00024YoloBridge_init(
@@ -17,6 +64,11 @@ Java_com_example_testyolo_MainActivity_00024YoloBridge_init(
     }
     g = new YoloV8();
     AAssetManager* mgr = AAssetManager_fromJava(env, assetMgr);
+    g_assetMgr = mgr;
+    g_sched.reset();
+    g_tracker.reset();
+    g_roi.detections = 0;
+    g_gate.reset();
     return g->load(mgr, "yolov8n.param", "yolov8n.bin");
 }
 
@@ -57,6 +109,218 @@ Java_com_example_testyolo_MainActivity_00024YoloBridge_detectRgba(
     return out;
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_setAdaptive(
+        JNIEnv*, jobject, jfloat targetMs) {
+    g_sched.configure(targetMs);
+}
+
+// Switches g to a size picked by g_sched. If that variant cannot be loaded, g
+// keeps the one it had and the size is dropped from g_sched, so later frames
+// neither retry it nor come back empty. Returns the size g now runs.
+static int load_scheduled_size(int size) {
+    if (g->getLoadedSize() == size || g->loadForSize(g_assetMgr, size)) return size;
+    g_sched.exclude(size, g->getLoadedSize());
+    return g->getLoadedSize();
+}
+
+// Runs detect(size) at the size g_sched picked and feeds the latency back.
+// Row 0 is [inputSize, frameMs, emaMs], detection rows follow.
+template <class Detect>
+static jobjectArray detect_adaptive(JNIEnv* env, Detect detect) {
+    jclass floatArrCls = env->FindClass("[F");
+    if (!g || !g_assetMgr) return env->NewObjectArray(0, floatArrCls, nullptr);
+
+    const int size = load_scheduled_size(g_sched.current());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Det> dets = detect(size);
+    auto t1 = std::chrono::steady_clock::now();
+    float ms = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    g_sched.update(ms);
+
+    jobjectArray out = env->NewObjectArray((jsize)dets.size() + 1, floatArrCls, nullptr);
+    jfloat meta[3] = {(float)size, ms, g_sched.emaMs()};
+    jfloatArray head = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(head, 0, 3, meta);
+    env->SetObjectArrayElement(out, 0, head);
+    env->DeleteLocalRef(head);
+    for (jsize i=0;i<(jsize)dets.size();++i){
+        jfloat tmp[6] = {dets[i].x1,dets[i].y1,dets[i].x2,dets[i].y2,dets[i].score,(float)dets[i].cls};
+        jfloatArray row = env->NewFloatArray(6);
+        env->SetFloatArrayRegion(row,0,6,tmp);
+        env->SetObjectArrayElement(out,i+1,row);
+        env->DeleteLocalRef(row);
+    }
+    return out;
+}
+
+// Same as detectRgba, but the input size (320/480/640 variant) is chosen per frame
+// by g_sched from measured latency. Row 0 is [inputSize, frameMs, emaMs],
+// detection rows [x1,y1,x2,y2,score,cls] follow.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_detectRgbaAdaptive(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject rgbaBuffer,
+        jint width, jint height, jint rowStride, jint rotationDeg,
+        jfloat conf, jfloat iou) {
+
+    uint8_t* ptr = (uint8_t*) env->GetDirectBufferAddress(rgbaBuffer);
+    if (!ptr || width <= 0 || height <= 0 || rowStride <= 0) {
+        return env->NewObjectArray(0, env->FindClass("[F"), nullptr);
+    }
+    return detect_adaptive(env, [&](int size) {
+        return g->detect_rgba(ptr, width, height, rowStride, rotationDeg, conf, iou, size);
+    });
+}
+
+// Same as detectRgbaAdaptive on the YUV_420_888 planes of the camera frame
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_detectYuvAdaptive(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject yBuffer, jobject uBuffer, jobject vBuffer,
+        jint width, jint height,
+        jint yRowStride, jint uvRowStride, jint uvPixelStride, jint rotationDeg,
+        jfloat conf, jfloat iou) {
+
+    YuvImage img;
+    if (!yuv_from_java(env, yBuffer, uBuffer, vBuffer, width, height,
+                       yRowStride, uvRowStride, uvPixelStride, rotationDeg, img)) {
+        return env->NewObjectArray(0, env->FindClass("[F"), nullptr);
+    }
+    return detect_adaptive(env, [&](int size) {
+        return g->detect_yuv(img, conf, iou, size);
+    });
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_setTracking(
+        JNIEnv*, jobject, jint detectEvery, jfloat minTrackConf) {
+    TrackerConfig cfg;
+    cfg.detectEvery = detectEvery;
+    cfg.minTrackConf = minTrackConf;
+    g_tracker.configure(cfg);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_setRoi(
+        JNIEnv*, jobject, jboolean enabled, jint fullEvery, jint roiSize) {
+    g_roi.enabled = enabled == JNI_TRUE;
+    g_roi.fullEvery = std::max(1, (int)fullEvery);
+    g_roi.roiSize = roiSize > 0 ? (int)roiSize : 320;
+    g_roi.detections = 0;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_setMotionGate(
+        JNIEnv*, jobject, jboolean enabled, jfloat blockDiff, jfloat minChanged, jint maxStale) {
+    MotionGateConfig cfg;
+    cfg.enabled = enabled == JNI_TRUE;
+    cfg.blockDiff = blockDiff;
+    cfg.minChanged = minChanged;
+    cfg.maxStale = maxStale;
+    g_gate.configure(cfg);
+}
+
+// [frames, reused, forcedByStaleness, gateMsPerFrame, savedMs] since setMotionGate / init
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_getGateStats(
+        JNIEnv* env, jobject) {
+    const MotionGateStats& st = g_gate.stats();
+    jfloat v[5] = {(float)st.frames, (float)st.reused, (float)st.forced,
+                   st.frames > 0 ? st.gateMs / st.frames : 0.f, st.savedMs};
+    jfloatArray arr = env->NewFloatArray(5);
+    env->SetFloatArrayRegion(arr, 0, 5, v);
+    return arr;
+}
+
+// Crops for this detector frame, or empty when it has to be full-frame
+static std::vector<RoiBox> plan_detector_rois(const YuvImage& img) {
+    const bool refresh = g_roi.detections++ % g_roi.fullEvery == 0;
+    const std::vector<TrackedObject>& objs = g_tracker.objects();
+    if (!g_roi.enabled || refresh || objs.empty()) return {};
+
+    const bool swap = img.rotationDeg == 90 || img.rotationDeg == 270;
+    const int fw = swap ? img.h : img.w;
+    const int fh = swap ? img.w : img.h;
+
+    std::vector<RoiBox> boxes;
+    boxes.reserve(objs.size());
+    for (const TrackedObject& o : objs) boxes.push_back({o.x1, o.y1, o.x2, o.y2});
+    std::vector<RoiBox> rois = YoloV8::plan_rois(boxes, fw, fh);
+
+    float area = 0.f;
+    for (const RoiBox& r : rois) area += (r.x2 - r.x1) * (r.y2 - r.y1);
+    if (area > g_roi.maxAreaFrac * fw * fh) return {};
+    return rois;
+}
+
+// Tracked variant of detectYuvAdaptive: the detector runs on the frames
+// g_tracker asks for, other frames only propagate the tracks. Row 0 is
+// [inputSize, frameMs, emaMs, detected, roiCount, reused], then
+// [x1,y1,x2,y2,score,cls,trackId]. roiCount > 0 marks a crop-only detector
+// frame (setRoi); emaMs / the scheduler only see full-frame detector frames.
+// reused = 1: g_gate saw no motion, the tracks were returned unchanged.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloBridge_trackYuvAdaptive(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject yBuffer, jobject uBuffer, jobject vBuffer,
+        jint width, jint height,
+        jint yRowStride, jint uvRowStride, jint uvPixelStride, jint rotationDeg,
+        jfloat conf, jfloat iou) {
+
+    jclass floatArrCls = env->FindClass("[F");
+    YuvImage img;
+    if (!g || !g_assetMgr ||
+        !yuv_from_java(env, yBuffer, uBuffer, vBuffer, width, height,
+                       yRowStride, uvRowStride, uvPixelStride, rotationDeg, img)) {
+        return env->NewObjectArray(0, floatArrCls, nullptr);
+    }
+
+    // frameMs excludes the gate itself (counted in its own gateMs), so
+    // savedMs and the scheduler only see the pipeline work
+    const bool run = g_gate.shouldRun(img.y, img.w, img.h, img.yRowStride);
+    auto t0 = std::chrono::steady_clock::now();
+    const bool detect = run && g_tracker.needsDetection();
+    const std::vector<RoiBox> rois = detect ? plan_detector_rois(img) : std::vector<RoiBox>();
+    int size = rois.empty() ? g_sched.current() : g_roi.roiSize;
+    if (detect) {
+        // Both sizes stay in the net cache, so switching is only a lookup
+        if (rois.empty()) {
+            size = load_scheduled_size(size);
+        } else if (g->getLoadedSize() != size && !g->loadForSize(g_assetMgr, size)) {
+            // No crop variant: these crops run on the loaded net, later frames full-frame
+            g_roi.enabled = false;
+            size = g->getLoadedSize();
+        }
+        g_tracker.update(rois.empty() ? g->detect_yuv(img, conf, iou, size)
+                                      : g->detect_yuv_rois(img, rois, conf, iou, size));
+    } else if (run) {
+        g_tracker.predict();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    float ms = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    if (detect && rois.empty()) g_sched.update(ms);
+    if (run) g_gate.reportRunMs(ms);
+
+    const std::vector<TrackedObject>& objs = g_tracker.objects();
+    jobjectArray out = env->NewObjectArray((jsize)objs.size() + 1, floatArrCls, nullptr);
+    jfloat meta[6] = {(float)size, ms, g_sched.emaMs(), detect ? 1.f : 0.f, (float)rois.size(), run ? 0.f : 1.f};
+    jfloatArray head = env->NewFloatArray(6);
+    env->SetFloatArrayRegion(head, 0, 6, meta);
+    env->SetObjectArrayElement(out, 0, head);
+    env->DeleteLocalRef(head);
+    for (jsize i=0;i<(jsize)objs.size();++i){
+        const TrackedObject& o = objs[i];
+        jfloat tmp[7] = {o.x1,o.y1,o.x2,o.y2,o.score,(float)o.cls,(float)o.id};
+        jfloatArray row = env->NewFloatArray(7);
+        env->SetFloatArrayRegion(row,0,7,tmp);
+        env->SetObjectArrayElement(out,i+1,row);
+        env->DeleteLocalRef(row);
+    }
+    return out;
+}
+
 // ===== YoloBenchmarkActivity YoloBridge (UI bench) =====
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_example_testyolo_YoloBenchmarkActivity_00024YoloBridge_init(
@@ -135,6 +399,31 @@ Java_com_example_testyolo_YoloBenchmarkActivity_00024YoloBridge_isOptimized(
     return true;
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_YoloBenchmarkActivity_00024YoloBridge_setCacheBudgetMb(
+        JNIEnv*, jobject, jint megabytes) {
+    if (g && megabytes > 0) g->setCacheBudget((size_t)megabytes * 1024u * 1024u);
+}
+
+// Returns [loads, hits, evictions, entries, usedKB, budgetKB]
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_example_testyolo_YoloBenchmarkActivity_00024YoloBridge_getCacheStats(
+        JNIEnv* env, jobject) {
+    jint tmp[6] = {0, 0, 0, 0, 0, 0};
+    if (g) {
+        NetCacheStats st = g->cacheStats();
+        tmp[0] = st.loads;
+        tmp[1] = st.hits;
+        tmp[2] = st.evictions;
+        tmp[3] = st.entries;
+        tmp[4] = (jint)(st.bytes / 1024);
+        tmp[5] = (jint)(st.budget / 1024);
+    }
+    jintArray out = env->NewIntArray(6);
+    env->SetIntArrayRegion(out, 0, 6, tmp);
+    return out;
+}
+
 // ===== NEW: CliBenchActivity YoloBridge (headless bench for PC pipeline) =====
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_init(
@@ -161,6 +450,12 @@ Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_isOptimized(
     return true;
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_setFastSwish(
+        JNIEnv*, jobject, jboolean enabled) {
+    if (g) g->setFastSwish(enabled);
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_loadFromFile(
         JNIEnv* env, jobject /*thiz*/,
@@ -206,6 +501,229 @@ Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_detectRgbaWithSize(
     return out;
 }
 
+// Tiled detection of one high-resolution RGBA still (YoloV8::detect_rgba_tiled),
+// rows as detectRgbaWithSize. tile <= 0 uses inputSize source pixels per tile.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_detectRgbaTiled(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject rgbaBuffer,
+        jint width, jint height, jint rowStride, jint rotationDeg,
+        jfloat conf, jfloat iou, jint inputSize,
+        jint tile, jfloat overlap, jint numWorkers, jboolean fullFrame) {
+
+    jclass floatArrCls = env->FindClass("[F");
+    if (!g) return env->NewObjectArray(0, floatArrCls, nullptr);
+
+    RgbaImage img;
+    img.rgba = (const uint8_t*) env->GetDirectBufferAddress(rgbaBuffer);
+    img.w = width;
+    img.h = height;
+    img.rowStride = rowStride;
+    img.rotationDeg = rotationDeg;
+
+    TileConfig cfg;
+    cfg.tile = tile > 0 ? (int)tile : (int)inputSize;
+    cfg.overlap = overlap;
+    cfg.numWorkers = std::max(1, (int)numWorkers);
+    cfg.fullFrame = fullFrame == JNI_TRUE;
+    return dets_to_java(env, g->detect_rgba_tiled(img, conf, iou, inputSize, cfg));
+}
+
+// Batch of RGBA frames in one call. Packed result:
+// [N, count_0 .. count_{N-1}, then count_i rows of (x1,y1,x2,y2,score,cls) per image]
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_detectBatch(
+        JNIEnv* env, jobject /*thiz*/,
+        jobjectArray rgbaBuffers, jintArray widths, jintArray heights, jintArray rowStrides,
+        jfloat conf, jfloat iou, jint inputSize, jint numWorkers) {
+
+    if (!g || !rgbaBuffers || !widths || !heights || !rowStrides) return env->NewFloatArray(0);
+
+    const jsize n = env->GetArrayLength(rgbaBuffers);
+    if (env->GetArrayLength(widths) < n || env->GetArrayLength(heights) < n ||
+        env->GetArrayLength(rowStrides) < n) {
+        return env->NewFloatArray(0);
+    }
+
+    std::vector<jint> ws(n), hs(n), ss(n);
+    env->GetIntArrayRegion(widths, 0, n, ws.data());
+    env->GetIntArrayRegion(heights, 0, n, hs.data());
+    env->GetIntArrayRegion(rowStrides, 0, n, ss.data());
+
+    std::vector<RgbaImage> images(n);
+    for (jsize i = 0; i < n; ++i) {
+        jobject buf = env->GetObjectArrayElement(rgbaBuffers, i);
+        images[i].rgba = buf ? (const uint8_t*) env->GetDirectBufferAddress(buf) : nullptr;
+        images[i].w = ws[i];
+        images[i].h = hs[i];
+        images[i].rowStride = ss[i];
+        if (buf) env->DeleteLocalRef(buf);
+    }
+
+    std::vector<std::vector<Det>> res = g->detect_batch(images, conf, iou, inputSize, numWorkers);
+
+    size_t total = 0;
+    for (const auto& r : res) total += r.size();
+
+    std::vector<jfloat> packed;
+    packed.reserve(1 + n + total * 6);
+    packed.push_back((float)n);
+    for (const auto& r : res) packed.push_back((float)r.size());
+    for (const auto& r : res) {
+        for (const Det& d : r) {
+            packed.push_back(d.x1);
+            packed.push_back(d.y1);
+            packed.push_back(d.x2);
+            packed.push_back(d.y2);
+            packed.push_back(d.score);
+            packed.push_back((float)d.cls);
+        }
+    }
+
+    jfloatArray out = env->NewFloatArray((jsize)packed.size());
+    env->SetFloatArrayRegion(out, 0, (jsize)packed.size(), packed.data());
+    return out;
+}
+
+// 0 = unknown (not run yet), 1 = dense + NMS, 2 = end2end (NMS-free)
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_getHeadType(
+        JNIEnv*, jobject) {
+    return g ? (jint)g->headType() : 0;
+}
+
+// [preprocess, inference, postprocess] of the last single-frame detect call, in ms
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_getStageTimesMs(
+        JNIEnv* env, jobject /*thiz*/) {
+    jfloat tmp[3] = {0.f, 0.f, 0.f};
+    if (g) {
+        const DetTimings& t = g->lastTimings();
+        tmp[0] = t.preprocess;
+        tmp[1] = t.inference;
+        tmp[2] = t.postprocess;
+    }
+    jfloatArray out = env->NewFloatArray(3);
+    env->SetFloatArrayRegion(out, 0, 3, tmp);
+    return out;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_evalReset(
+        JNIEnv*, jobject, jint numClasses) {
+    g_eval.reset((int)numClasses);
+}
+
+// Runs the same detect path as the benchmark on one image and scores it
+// against its YOLO label file. Returns detect time in ms, -1 on error.
+extern "C" JNIEXPORT jfloat JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_evalAddImage(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject rgbaBuffer,
+        jint width, jint height, jint rowStride,
+        jstring labelPath,
+        jfloat conf, jfloat iou, jint inputSize) {
+
+    if (!g) return -1.f;
+    uint8_t* ptr = (uint8_t*) env->GetDirectBufferAddress(rgbaBuffer);
+    if (!ptr || width <= 0 || height <= 0 || rowStride <= 0) return -1.f;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Det> dets = g->detect_rgba(ptr, width, height, rowStride, 0, conf, iou, inputSize);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<GtBox> gts;
+    const char* lp = labelPath ? env->GetStringUTFChars(labelPath, nullptr) : nullptr;
+    load_yolo_labels(lp, width, height, gts);
+    if (lp) env->ReleaseStringUTFChars(labelPath, lp);
+
+    g_eval.add(std::move(dets), gts);
+    return std::chrono::duration<float, std::milli>(t1 - t0).count();
+}
+
+// [images, classes_with_gt, map50, map50_95]
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_evalResult(
+        JNIEnv* env, jobject) {
+    MapResult r = g_eval.compute();
+    jfloat tmp[4] = {(float)r.images, (float)r.classes, r.map50, r.map50_95};
+    jfloatArray out = env->NewFloatArray(4);
+    env->SetFloatArrayRegion(out, 0, 4, tmp);
+    return out;
+}
+
+// Returns the number of cached frames, 0 if there is no valid cache for imgsz
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_tensorCacheOpen(
+        JNIEnv* env, jobject, jstring path, jint imgsz) {
+    const char* p = env->GetStringUTFChars(path, nullptr);
+    bool ok = g_tcache.open(p, (int)imgsz);
+    env->ReleaseStringUTFChars(path, p);
+    return ok ? g_tcache.size() : 0;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_tensorCacheBuildBegin(
+        JNIEnv* env, jobject, jstring path, jint imgsz) {
+    const char* p = env->GetStringUTFChars(path, nullptr);
+    bool ok = g_tcacheWriter.begin(p, (int)imgsz);
+    env->ReleaseStringUTFChars(path, p);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_tensorCacheAppend(
+        JNIEnv* env, jobject, jobject rgbaBuffer, jint width, jint height, jint rowStride) {
+    uint8_t* ptr = (uint8_t*) env->GetDirectBufferAddress(rgbaBuffer);
+    if (!ptr) return JNI_FALSE;
+    return g_tcacheWriter.append(ptr, width, height, rowStride) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Commits the file; returns the frame count, -1 on error
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_tensorCacheBuildEnd(
+        JNIEnv*, jobject) {
+    return g_tcacheWriter.finish();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_tensorCacheClose(
+        JNIEnv*, jobject) {
+    g_tcacheWriter.abort();
+    g_tcache.close();
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_detectCached(
+        JNIEnv* env, jobject, jint index, jfloat conf, jfloat iou) {
+    Letterbox lb;
+    int srcW = 0, srcH = 0;
+    const uint8_t* rgb = g_tcache.frame((int)index, lb, srcW, srcH);
+    if (!g || !rgb) return dets_to_java(env, {});
+    return dets_to_java(env, g->detect_rgb_letterboxed(rgb, g_tcache.imgsz(), lb, conf, iou));
+}
+
+extern "C" JNIEXPORT jfloat JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_evalAddCached(
+        JNIEnv* env, jobject, jint index, jstring labelPath, jfloat conf, jfloat iou) {
+    Letterbox lb;
+    int srcW = 0, srcH = 0;
+    const uint8_t* rgb = g_tcache.frame((int)index, lb, srcW, srcH);
+    if (!g || !rgb) return -1.f;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Det> dets = g->detect_rgb_letterboxed(rgb, g_tcache.imgsz(), lb, conf, iou);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<GtBox> gts;
+    const char* lp = labelPath ? env->GetStringUTFChars(labelPath, nullptr) : nullptr;
+    load_yolo_labels(lp, srcW, srcH, gts);
+    if (lp) env->ReleaseStringUTFChars(labelPath, lp);
+
+    g_eval.add(std::move(dets), gts);
+    return std::chrono::duration<float, std::milli>(t1 - t0).count();
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_release(
         JNIEnv*, jobject) {
@@ -215,4 +733,6 @@ Java_com_example_testyolo_CliBenchActivity_00024YoloBridge_release(
         g = nullptr;
     }
     g_assetMgr = nullptr;
+    g_tcacheWriter.abort();
+    g_tcache.close();
 }
\ No newline at end of file
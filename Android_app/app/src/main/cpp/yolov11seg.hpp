@@ -2,33 +2,125 @@
 #include <android/asset_manager_jni.h>
 #include <vector>
 #include "ncnn/net.h"
+#include "blob_index.hpp"
+#include "net_cache.hpp"
+#include "yolov8.hpp"
+
+// What detect_rgba produces. Boxes never extracts the proto blob, so ncnn's
+// lazy extractor skips the whole mask branch of the graph.
+enum class SegOutput {
+    Boxes = 0,        // boxes only, mask stays empty
+    CoarseMasks = 1,  // masks sampled at every 2nd proto pixel
+    FullMasks = 2     // masks at proto resolution
+};
 
 struct SegDet {
     float x1, y1, x2, y2;
     float score;
     int cls;
     std::vector<uint8_t> mask;  // Binary mask for the bounding box region
-    int mask_w, mask_h;          // Dimensions of the mask (matches bbox size)
+    int mask_w, mask_h;          // Dimensions of the mask (bbox region in proto space, 0 in Boxes mode)
+};
+
+// Wall time of the last detect_rgba() call per stage, in ms
+struct SegTimings {
+    float preprocess = 0.f;  // rotate + letterbox + normalize
+    float inference = 0.f;   // det blob (and proto blob, if masks are wanted) extraction
+    float decode = 0.f;      // proposal decode + NMS
+    float masks = 0.f;       // coefficients x protos for the kept boxes
 };
 
 class YoloV11Seg {
 public:
+    YoloV11Seg();
+
     bool load(AAssetManager* mgr, const char* param, const char* bin);
 
+    // Load the seg model for a specific input size (assets: yolov11n-seg_320.param etc.,
+    // sizes >= 640 share the 640 model). Variants are kept in an LRU cache.
+    // On failure the previously loaded variant (and getLoadedSize()) stays active.
+    bool loadForSize(AAssetManager* mgr, int inputSize);
+
+    // Load from filesystem paths (adb push), as YoloV8::loadFromFile
+    bool loadFromFile(const char* paramPath, const char* binPath, int inputSize, int numThreads);
+
     // Real-time camera path (RGBA + stride + rotation)
     // Returns detections with segmentation masks
     std::vector<SegDet> detect_rgba(const uint8_t* rgba,
                                     int srcW, int srcH, int rowStride,
                                     int rotationDeg,
-                                    float conf_thr, float iou_thr, int dst = 640);
+                                    float conf_thr, float iou_thr, int dst = 640,
+                                    SegOutput output = SegOutput::FullMasks);
+
+    // YUV_420_888 camera path, letterboxed as YoloV8::preprocess_yuv
+    std::vector<SegDet> detect_yuv(const YuvImage& img,
+                                   float conf_thr, float iou_thr, int dst = 640,
+                                   SegOutput output = SegOutput::FullMasks);
 
-    void clear() { net.clear(); }
+    // Already letterboxed dst x dst input (e.g. a FrameContext level) of the
+    // srcW x srcH frame rotated by rotationDeg; preprocess time stays 0
+    std::vector<SegDet> detect_letterboxed(const ncnn::Mat& in, const Letterbox& lb,
+                                           int srcW, int srcH, int rotationDeg,
+                                           float conf_thr, float iou_thr, int dst,
+                                           SegOutput output = SegOutput::FullMasks);
+
+    void clear() {
+        net.clear();
+        netCache.clear();
+        active = &net;
+        io = BlobIO();
+        protoBlob = -1;
+        layout = Layout();
+    }
+
+    int getLoadedSize() const { return loadedInputSize; }
+    const SegTimings& lastTimings() const { return timings; }
+
+    // Option profile for the next loadForSize()/loadFromFile(), as YoloV8
+    void setOptimized(bool enabled) { useOptimizations = enabled; }
+    bool isOptimized() const { return useOptimizations; }
+    void setFastSwish(bool enabled) { fastSwish = enabled; }
+    bool isFastSwish() const { return fastSwish; }
+
+    // Threads of the bound net, as YoloV8::setNumThreads
+    void setNumThreads(int n) { active->opt.num_threads = n > 0 ? n : 1; }
 
 private:
-    ncnn::Net net;
+    // Makes n the net used by detect_rgba() and resolves its blobs once
+    bool bind(ncnn::Net* n);
+
+    // Inference + decode + masks on a letterboxed input; boxes map back to
+    // the srcW x srcH frame rotated by rot
+    std::vector<SegDet> detect_input(const ncnn::Mat& in, const Letterbox& lb,
+                                     int srcW, int srcH, int rot,
+                                     float conf_thr, float iou_thr, int dst, SegOutput output);
+
+    // Det head layout, derived from the det blob shape once per shape
+    struct Layout {
+        int w = 0, h = 0;       // det blob dims it was derived from
+        bool transposed = false;
+        bool end2end = false;   // NMS-free one-to-one head: rows of [x1,y1,x2,y2,score,cls,coeffs..]
+        int featDim = 0;        // 4 + nc + maskDim (6 + maskDim for end2end)
+        int numPreds = 0;
+        int nc = 0;
+        int maskDim = 0;
+    };
+    void resolveLayout(int w, int h);
+
+    ncnn::Net net;             // load() / loadFromFile()
+    NetCache netCache;         // loadForSize() variants
+    ncnn::Net* active = &net;  // net used by detect_rgba()
+    BlobIO io;                 // in0/images -> out0/output0
+    int protoBlob = -1;        // out1/output1, -1 for det-only graphs
+    Layout layout;
     int num_class = 80;
     int mask_proto_dim = 32;   // Number of mask prototype channels
     int mask_proto_h = 160;    // Prototype mask height (for 640 input)
     int mask_proto_w = 160;    // Prototype mask width
+    int loadedInputSize = 640;
+    bool useOptimizations = true;
+    bool fastSwish = false;
+    bool netFastSwish = false;  // override currently registered on `net`
+    SegTimings timings;
 };
 
@@ -1,26 +1,98 @@
 #include <jni.h>
 #include <android/asset_manager_jni.h>
 #include "yolov11seg.hpp"
+#include "yuv_jni.hpp"
+#include "object_tracker.hpp"
 
 static YoloV11Seg* g_seg = nullptr;
 
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_example_testyolo_MainActivity_00024YoloSegBridge_init(
-        JNIEnv* env, jobject /*thiz*/, jobject assetMgr,
-        jstring paramPath, jstring binPath) {
+// Kept for loadForSize() (multi-size benchmark)
+static AAssetManager* g_segAssetMgr = nullptr;
+
+// Camera path tracker for MainActivity (boxes only)
+static ByteTracker g_segTracker;
 
-    // Clean up existing instance
+static jobjectArray empty_rows(JNIEnv* env) {
+    return env->NewObjectArray(0, env->FindClass("[F"), nullptr);
+}
+
+// Rows of [x1, y1, x2, y2, score, cls, mask_w, mask_h]
+static jobjectArray seg_dets_to_java(JNIEnv* env, const std::vector<SegDet>& dets) {
+    jclass floatArrCls = env->FindClass("[F");
+    jobjectArray out = env->NewObjectArray((jsize)dets.size(), floatArrCls, nullptr);
+
+    for (jsize i = 0; i < (jsize)dets.size(); ++i) {
+        const SegDet& d = dets[i];
+        jfloat tmp[8] = {
+            d.x1, d.y1, d.x2, d.y2,
+            d.score, (float)d.cls,
+            (float)d.mask_w, (float)d.mask_h
+        };
+        jfloatArray row = env->NewFloatArray(8);
+        env->SetFloatArrayRegion(row, 0, 8, tmp);
+        env->SetObjectArrayElement(out, i, row);
+        env->DeleteLocalRef(row);
+    }
+    return out;
+}
+
+static void seg_reset(JNIEnv* env, jobject assetMgr) {
     if (g_seg) {
         g_seg->clear();
         delete g_seg;
     }
     g_seg = new YoloV11Seg();
+    g_segAssetMgr = assetMgr ? AAssetManager_fromJava(env, assetMgr) : nullptr;
+    g_segTracker.reset();
+}
+
+static void seg_release() {
+    if (g_seg) {
+        g_seg->clear();
+        delete g_seg;
+        g_seg = nullptr;
+    }
+    g_segAssetMgr = nullptr;
+}
+
+static jobjectArray seg_detect(JNIEnv* env, jobject rgbaBuffer,
+                               jint width, jint height, jint rowStride, jint rotationDeg,
+                               jfloat conf, jfloat iou, jint inputSize, SegOutput output) {
+    if (!g_seg) return empty_rows(env);
+    uint8_t* ptr = (uint8_t*)env->GetDirectBufferAddress(rgbaBuffer);
+    if (!ptr || width <= 0 || height <= 0 || rowStride <= 0) return empty_rows(env);
+
+    std::vector<SegDet> dets = g_seg->detect_rgba(ptr, width, height, rowStride,
+                                                   rotationDeg, conf, iou, inputSize, output);
+    return seg_dets_to_java(env, dets);
+}
+
+// [preprocess, inference, decode, masks] of the last detect call, in ms
+static jfloatArray seg_stage_times(JNIEnv* env) {
+    jfloat tmp[4] = {0.f, 0.f, 0.f, 0.f};
+    if (g_seg) {
+        const SegTimings& t = g_seg->lastTimings();
+        tmp[0] = t.preprocess;
+        tmp[1] = t.inference;
+        tmp[2] = t.decode;
+        tmp[3] = t.masks;
+    }
+    jfloatArray out = env->NewFloatArray(4);
+    env->SetFloatArrayRegion(out, 0, 4, tmp);
+    return out;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloSegBridge_init(
+        JNIEnv* env, jobject /*thiz*/, jobject assetMgr,
+        jstring paramPath, jstring binPath) {
+
+    seg_reset(env, assetMgr);
 
-    AAssetManager* mgr = AAssetManager_fromJava(env, assetMgr);
     const char* param = env->GetStringUTFChars(paramPath, nullptr);
     const char* bin = env->GetStringUTFChars(binPath, nullptr);
 
-    bool ok = g_seg->load(mgr, param, bin);
+    bool ok = g_seg->load(g_segAssetMgr, param, bin);
 
     env->ReleaseStringUTFChars(paramPath, param);
     env->ReleaseStringUTFChars(binPath, bin);
@@ -31,50 +103,186 @@ Java_com_example_testyolo_MainActivity_00024YoloSegBridge_init(
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_testyolo_MainActivity_00024YoloSegBridge_release(
         JNIEnv*, jobject) {
-    if (g_seg) {
-        g_seg->clear();
-        delete g_seg;
-        g_seg = nullptr;
-    }
+    seg_release();
 }
 
 // Returns detection boxes: Array of FloatArray [x1, y1, x2, y2, score, cls, mask_w, mask_h]
+// Runs in SegOutput::Boxes mode: the proto branch is not executed, mask_w/mask_h are 0.
 extern "C" JNIEXPORT jobjectArray JNICALL
 Java_com_example_testyolo_MainActivity_00024YoloSegBridge_detectRgbaBoxesOnly(
         JNIEnv* env, jobject /*thiz*/,
         jobject rgbaBuffer,
         jint width, jint height, jint rowStride, jint rotationDeg,
         jfloat conf, jfloat iou) {
+    return seg_detect(env, rgbaBuffer, width, height, rowStride, rotationDeg, conf, iou, 640, SegOutput::Boxes);
+}
 
-    if (!g_seg) {
-        // Return empty array instead of null
-        jclass floatArrCls = env->FindClass("[F");
-        return env->NewObjectArray(0, floatArrCls, nullptr);
+// Boxes-only detection on the YUV_420_888 planes of the camera frame
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloSegBridge_detectYuvBoxesOnly(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject yBuffer, jobject uBuffer, jobject vBuffer,
+        jint width, jint height,
+        jint yRowStride, jint uvRowStride, jint uvPixelStride, jint rotationDeg,
+        jfloat conf, jfloat iou) {
+    YuvImage img;
+    if (!g_seg || !yuv_from_java(env, yBuffer, uBuffer, vBuffer, width, height,
+                                 yRowStride, uvRowStride, uvPixelStride, rotationDeg, img)) {
+        return empty_rows(env);
     }
+    return seg_dets_to_java(env, g_seg->detect_yuv(img, conf, iou, 640, SegOutput::Boxes));
+}
 
-    uint8_t* ptr = (uint8_t*)env->GetDirectBufferAddress(rgbaBuffer);
-    if (!ptr) {
-        jclass floatArrCls = env->FindClass("[F");
-        return env->NewObjectArray(0, floatArrCls, nullptr);
-    }
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloSegBridge_setTracking(
+        JNIEnv*, jobject, jint detectEvery, jfloat minTrackConf) {
+    TrackerConfig cfg;
+    cfg.detectEvery = detectEvery;
+    cfg.minTrackConf = minTrackConf;
+    g_segTracker.configure(cfg);
+}
 
-    std::vector<SegDet> dets = g_seg->detect_rgba(ptr, width, height, rowStride,
-                                                   rotationDeg, conf, iou);
+// Tracked boxes on the YUV camera frame: the seg net runs (boxes only) on the
+// frames g_segTracker asks for. Rows [x1,y1,x2,y2,score,cls,0,0,trackId].
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_MainActivity_00024YoloSegBridge_trackYuvBoxesOnly(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject yBuffer, jobject uBuffer, jobject vBuffer,
+        jint width, jint height,
+        jint yRowStride, jint uvRowStride, jint uvPixelStride, jint rotationDeg,
+        jfloat conf, jfloat iou) {
+    YuvImage img;
+    if (!g_seg || !yuv_from_java(env, yBuffer, uBuffer, vBuffer, width, height,
+                                 yRowStride, uvRowStride, uvPixelStride, rotationDeg, img)) {
+        return empty_rows(env);
+    }
 
-    jclass floatArrCls = env->FindClass("[F");
-    jobjectArray out = env->NewObjectArray((jsize)dets.size(), floatArrCls, nullptr);
+    if (g_segTracker.needsDetection()) {
+        std::vector<SegDet> segs = g_seg->detect_yuv(img, conf, iou, 640, SegOutput::Boxes);
+        std::vector<Det> dets;
+        dets.reserve(segs.size());
+        for (const SegDet& d : segs) dets.push_back({d.x1, d.y1, d.x2, d.y2, d.score, d.cls});
+        g_segTracker.update(dets);
+    } else {
+        g_segTracker.predict();
+    }
 
-    for (jsize i = 0; i < (jsize)dets.size(); ++i) {
-        const SegDet& d = dets[i];
-        jfloat tmp[8] = {
-            d.x1, d.y1, d.x2, d.y2,
-            d.score, (float)d.cls,
-            (float)d.mask_w, (float)d.mask_h
-        };
-        jfloatArray row = env->NewFloatArray(8);
-        env->SetFloatArrayRegion(row, 0, 8, tmp);
+    const std::vector<TrackedObject>& objs = g_segTracker.objects();
+    jobjectArray out = env->NewObjectArray((jsize)objs.size(), env->FindClass("[F"), nullptr);
+    for (jsize i = 0; i < (jsize)objs.size(); ++i) {
+        const TrackedObject& o = objs[i];
+        jfloat tmp[9] = {o.x1, o.y1, o.x2, o.y2, o.score, (float)o.cls, 0.f, 0.f, (float)o.id};
+        jfloatArray row = env->NewFloatArray(9);
+        env->SetFloatArrayRegion(row, 0, 9, tmp);
         env->SetObjectArrayElement(out, i, row);
         env->DeleteLocalRef(row);
     }
     return out;
 }
+
+// ===== YoloSegBenchmarkActivity YoloSegBridge (multi-size UI bench) =====
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_initSeg(
+        JNIEnv* env, jobject /*thiz*/, jobject assetMgr) {
+    seg_reset(env, assetMgr);
+    return g_segAssetMgr != nullptr;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_loadForSize(
+        JNIEnv*, jobject /*thiz*/, jint inputSize) {
+    if (!g_seg || !g_segAssetMgr || inputSize <= 0) return false;
+    return g_seg->loadForSize(g_segAssetMgr, inputSize);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_getLoadedSize(
+        JNIEnv*, jobject /*thiz*/) {
+    return g_seg ? g_seg->getLoadedSize() : 0;
+}
+
+// Full masks at proto resolution, rows as in seg_dets_to_java()
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_detectSegRgbaWithSize(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject rgbaBuffer,
+        jint width, jint height, jint rowStride, jint rotationDeg,
+        jfloat conf, jfloat iou, jint inputSize) {
+    return seg_detect(env, rgbaBuffer, width, height, rowStride, rotationDeg, conf, iou, inputSize,
+                      SegOutput::FullMasks);
+}
+
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_getStageTimesMs(
+        JNIEnv* env, jobject /*thiz*/) {
+    return seg_stage_times(env);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_YoloSegBenchmarkActivity_00024YoloSegBridge_releaseSeg(
+        JNIEnv*, jobject) {
+    seg_release();
+}
+
+// ===== CliBenchActivity SegBridge (task=seg headless bench) =====
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_init(
+        JNIEnv* env, jobject /*thiz*/, jobject assetMgr) {
+    seg_reset(env, assetMgr);
+    return true;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_setOptimized(
+        JNIEnv*, jobject, jboolean enabled) {
+    if (g_seg) g_seg->setOptimized(enabled);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_setFastSwish(
+        JNIEnv*, jobject, jboolean enabled) {
+    if (g_seg) g_seg->setFastSwish(enabled);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_loadFromFile(
+        JNIEnv* env, jobject /*thiz*/,
+        jstring paramPath, jstring binPath,
+        jint inputSize, jint numThreads) {
+    if (!g_seg) return false;
+
+    const char* p = env->GetStringUTFChars(paramPath, nullptr);
+    const char* b = env->GetStringUTFChars(binPath, nullptr);
+
+    bool ok = g_seg->loadFromFile(p, b, (int)inputSize, (int)numThreads);
+
+    env->ReleaseStringUTFChars(paramPath, p);
+    env->ReleaseStringUTFChars(binPath, b);
+
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+// maskMode: 0 = boxes only, 1 = coarse masks, 2 = full masks (SegOutput)
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_detectSegRgbaWithSize(
+        JNIEnv* env, jobject /*thiz*/,
+        jobject rgbaBuffer,
+        jint width, jint height, jint rowStride, jint rotationDeg,
+        jfloat conf, jfloat iou, jint inputSize, jint maskMode) {
+    const SegOutput output = maskMode <= 0 ? SegOutput::Boxes
+                           : maskMode == 1 ? SegOutput::CoarseMasks
+                                           : SegOutput::FullMasks;
+    return seg_detect(env, rgbaBuffer, width, height, rowStride, rotationDeg, conf, iou, inputSize, output);
+}
+
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_getStageTimesMs(
+        JNIEnv* env, jobject /*thiz*/) {
+    return seg_stage_times(env);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_testyolo_CliBenchActivity_00024SegBridge_release(
+        JNIEnv*, jobject) {
+    seg_release();
+}
@@ -1,8 +1,14 @@
 #include "yolov8.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
+#include <thread>
 #include <android/log.h>
+#include "custom_layers.hpp"
 
 static inline void read_pixel_rotated(const uint8_t* src,
                                       int srcW, int srcH, int rowStride,
@@ -22,6 +28,14 @@ static inline void read_pixel_rotated(const uint8_t* src,
     R = p[0]; G = p[1]; B = p[2];
 }
 
+static inline float ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+YoloV8::YoloV8() {
+    register_yolo_layers(net);
+}
+
 bool YoloV8::load(AAssetManager* mgr, const char* param, const char* bin) {
     net.opt.use_vulkan_compute = false;
     net.opt.num_threads = 4;
@@ -34,32 +48,50 @@ bool YoloV8::load(AAssetManager* mgr, const char* param, const char* bin) {
     net.opt.lightmode = true;
 
     loadedInputSize = 640;
-    return net.load_param(mgr, param) == 0 && net.load_model(mgr, bin) == 0;
+    active = &net;
+    io = BlobIO();
+    head = YoloHead::Unknown;
+    if (fastSwish || netFastSwish) set_fast_swish(net, fastSwish);
+    netFastSwish = fastSwish;
+    if (net.load_param(mgr, param) != 0 || net.load_model(mgr, bin) != 0) return false;
+    return bind(&net);
 }
 
-bool YoloV8::loadForSize(AAssetManager* mgr, int inputSize) {
-    net.clear();
-    net.opt.use_vulkan_compute = false;
-    net.opt.num_threads = 4;
+YoloHead detect_yolo_head(int w, int h) {
+    if (w <= 0 || h <= 0) return YoloHead::Unknown;
+    // end2end: a few hundred rows of 6 values; dense: 84/85 rows x thousands of anchors
+    if (w == 6 && h <= 1000) return YoloHead::End2End;
+    return YoloHead::Dense;
+}
 
-    if (useOptimizations) {
-        __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading with OPTIMIZATIONS enabled");
-        net.opt.use_fp16_packed = true;
-        net.opt.use_fp16_storage = true;
-        net.opt.use_packing_layout = true;
-        net.opt.use_winograd_convolution = true;
-        net.opt.use_sgemm_convolution = true;
-        net.opt.lightmode = true;
-    } else {
-        __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading in BASELINE mode (no optimizations)");
-        net.opt.use_fp16_packed = false;
-        net.opt.use_fp16_storage = false;
-        net.opt.use_packing_layout = false;
-        net.opt.use_winograd_convolution = false;
-        net.opt.use_sgemm_convolution = false;
-        net.opt.lightmode = false;
+static BlobIO resolve_io(const ncnn::Net& n) {
+    BlobIO b;
+    b.input = resolve_input_blob(n, {"in0", "images"});
+    b.output = resolve_output_blob(n, {"out0", "output0"});
+    return b;
+}
+
+// Switches to n only if its blobs resolve; otherwise nothing changes.
+bool YoloV8::bind(ncnn::Net* n) {
+    const BlobIO b = resolve_io(*n);
+    if (!b.ok()) {
+        __android_log_print(ANDROID_LOG_ERROR, "yolo", "no input/output blob in graph (in=%d out=%d)",
+                            b.input, b.output);
+        return false;
+    }
+    active = n;
+    io = b;
+    // Without a shape hint the head is detected on the first frame
+    const ncnn::Mat& hint = n->blobs()[io.output].shape;
+    head = detect_yolo_head(hint.w, hint.h);
+    if (head != YoloHead::Unknown) {
+        __android_log_print(ANDROID_LOG_INFO, "yolo", "head: %s",
+                            head == YoloHead::End2End ? "end2end (NMS-free)" : "dense");
     }
+    return true;
+}
 
+bool YoloV8::loadForSize(AAssetManager* mgr, int inputSize) {
     int modelSize = inputSize;
     if (inputSize >= 640) modelSize = 640;
 
@@ -67,23 +99,75 @@ bool YoloV8::loadForSize(AAssetManager* mgr, int inputSize) {
     snprintf(paramFile, sizeof(paramFile), "yolov8n_%d.param", modelSize);
     snprintf(binFile, sizeof(binFile), "yolov8n_%d.bin", modelSize);
 
-    __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading model: %s (for input size %d)", paramFile, inputSize);
+    NetKey key;
+    key.model = "yolov8n";
+    key.inputSize = modelSize;
+    key.profile = (useOptimizations ? 1 : 0) | (fastSwish ? 2 : 0);
+
+    const bool optimized = useOptimizations;
+    const bool swishOverride = fastSwish;
+    ncnn::Net* n = netCache.acquire(key, asset_size(mgr, binFile), [&](ncnn::Net& cached) {
+        cached.opt.use_vulkan_compute = false;
+        cached.opt.num_threads = 4;
+
+        if (optimized) {
+            __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading with OPTIMIZATIONS enabled");
+            cached.opt.use_fp16_packed = true;
+            cached.opt.use_fp16_storage = true;
+            cached.opt.use_packing_layout = true;
+            cached.opt.use_winograd_convolution = true;
+            cached.opt.use_sgemm_convolution = true;
+            cached.opt.lightmode = true;
+        } else {
+            __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading in BASELINE mode (no optimizations)");
+            cached.opt.use_fp16_packed = false;
+            cached.opt.use_fp16_storage = false;
+            cached.opt.use_packing_layout = false;
+            cached.opt.use_winograd_convolution = false;
+            cached.opt.use_sgemm_convolution = false;
+            cached.opt.lightmode = false;
+        }
 
-    int paramResult = net.load_param(mgr, paramFile);
-    int binResult = net.load_model(mgr, binFile);
+        __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading model: %s (for input size %d)", paramFile, inputSize);
 
-    if (paramResult == 0 && binResult == 0) {
-        loadedInputSize = inputSize;
-        __android_log_print(ANDROID_LOG_INFO, "yolo", "Model loaded for size %d (using %d model)", inputSize, modelSize);
+        register_yolo_layers(cached);
+        if (swishOverride) set_fast_swish(cached, true);
+        int paramResult = cached.load_param(mgr, paramFile);
+        int binResult = cached.load_model(mgr, binFile);
+        if (paramResult != 0 || binResult != 0) {
+            __android_log_print(ANDROID_LOG_ERROR, "yolo", "Failed to load model for size %d (param=%d, bin=%d)",
+                                inputSize, paramResult, binResult);
+            return false;
+        }
+        // A graph bind() would reject must not enter the cache (or evict the net in use)
+        if (!resolve_io(cached).ok()) {
+            __android_log_print(ANDROID_LOG_ERROR, "yolo", "No input/output blob in %s", paramFile);
+            return false;
+        }
         return true;
-    }
-
-    __android_log_print(ANDROID_LOG_ERROR, "yolo", "Failed to load model for size %d (param=%d, bin=%d)",
-                        inputSize, paramResult, binResult);
-    return false;
+    });
+
+    // Keep serving the variant bound before: the cache does not evict on a
+    // failed load, so it is still valid
+    if (!n) return false;
+
+    const bool wasSingleShot = active == &net;
+    if (!bind(n)) return false;
+    // The single-shot net is not used while serving cached variants.
+    if (wasSingleShot) net.clear();
+    loadedInputSize = inputSize;
+
+    NetCacheStats st = netCache.stats();
+    __android_log_print(ANDROID_LOG_INFO, "yolo", "Model ready for size %d (using %d model, loads=%d hits=%d evictions=%d)",
+                        inputSize, modelSize, st.loads, st.hits, st.evictions);
+    return true;
 }
 
 bool YoloV8::loadFromFile(const char* paramPath, const char* binPath, int inputSize, int numThreads) {
+    netCache.clear();
+    active = &net;
+    io = BlobIO();
+    head = YoloHead::Unknown;
     net.clear();
     net.opt.use_vulkan_compute = false;
     net.opt.num_threads = (numThreads > 0) ? numThreads : 4;
@@ -111,13 +195,16 @@ bool YoloV8::loadFromFile(const char* paramPath, const char* binPath, int inputS
         net.opt.lightmode = false;
     }
 
-    __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading from file: %s / %s (imgsz=%d threads=%d)",
-                        paramPath, binPath, inputSize, net.opt.num_threads);
+    __android_log_print(ANDROID_LOG_INFO, "yolo", "Loading from file: %s / %s (imgsz=%d threads=%d fast_swish=%d)",
+                        paramPath, binPath, inputSize, net.opt.num_threads, (int)fastSwish);
+
+    if (fastSwish || netFastSwish) set_fast_swish(net, fastSwish);
+    netFastSwish = fastSwish;
 
     int pr = net.load_param(paramPath);
     int br = net.load_model(binPath);
 
-    if (pr == 0 && br == 0) {
+    if (pr == 0 && br == 0 && bind(&net)) {
         loadedInputSize = inputSize;
         __android_log_print(ANDROID_LOG_INFO, "yolo", "FILE model loaded OK");
         return true;
@@ -127,50 +214,285 @@ bool YoloV8::loadFromFile(const char* paramPath, const char* binPath, int inputS
     return false;
 }
 
-std::vector<Det> YoloV8::detect_rgba(const uint8_t* rgba, int srcW, int srcH, int rowStride,
-                                     int rot, float conf_thr, float iou_thr, int dst) {
-    int w = (rot == 90 || rot == 270) ? srcH : srcW;
-    int h = (rot == 90 || rot == 270) ? srcW : srcH;
-
-    ncnn::Mat in(dst, dst, 3);
+// Letterbox sampling of the upright region [x0, x0+w) x [y0, y0+h), shared by
+// the RGBA, YUV and ROI paths. Calls read(sx, sy, R, G, B) with upright frame
+// coords for every pixel inside the letterbox and put(x, y, R, G, B) for every
+// dst pixel.
+template <class Read, class Put>
+static void letterbox_sample_region(int x0, int y0, int w, int h, int dst, Letterbox& lb,
+                                    Read read, Put put) {
     float r = std::min(dst / (float)w, dst / (float)h);
     int new_w = (int)std::round(w * r);
     int new_h = (int)std::round(h * r);
     int pad_w = dst - new_w, pad_h = dst - new_h;
 
-    float* ch0 = in.channel(0);
-    float* ch1 = in.channel(1);
-    float* ch2 = in.channel(2);
-
     for (int y=0; y<dst; y++) {
         for (int x=0; x<dst; x++) {
             int rx = x - pad_w/2, ry = y - pad_h/2;
             uint8_t R=114,G=114,B=114;
             if (rx>=0 && rx<new_w && ry>=0 && ry<new_h) {
-                int sx = (int)std::round(rx / r);
-                int sy = (int)std::round(ry / r);
-                read_pixel_rotated(rgba, srcW, srcH, rowStride, rot, sx, sy, R,G,B);
+                int sx = x0 + (int)std::round(rx / r);
+                int sy = y0 + (int)std::round(ry / r);
+                read(sx, sy, R, G, B);
             }
+            put(x, y, R, G, B);
+        }
+    }
+
+    lb.scale = r;
+    lb.pad_w = pad_w;
+    lb.pad_h = pad_h;
+    lb.off_x = x0;
+    lb.off_y = y0;
+}
+
+// Whole frame after rotation
+template <class Read, class Put>
+static void letterbox_sample(int srcW, int srcH, int rot, int dst, Letterbox& lb, Read read, Put put) {
+    int w = (rot == 90 || rot == 270) ? srcH : srcW;
+    int h = (rot == 90 || rot == 270) ? srcW : srcH;
+    letterbox_sample_region(0, 0, w, h, dst, lb, read, put);
+}
+
+static inline uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// BT.601 video range, the integer coefficients CameraX's own YUV->RGBA
+// conversion (libyuv) uses, so both camera paths see the same colours
+static inline void read_yuv_rotated(const YuvImage& img, int x, int y,
+                                    uint8_t& R, uint8_t& G, uint8_t& B) {
+    const int srcW = img.w, srcH = img.h, rot = img.rotationDeg;
+    int sx = x, sy = y;
+    if (rot == 90)      { sx = y;             sy = srcW - 1 - x; }
+    else if (rot == 180){ sx = srcW - 1 - x;  sy = srcH - 1 - y; }
+    else if (rot == 270){ sx = srcH - 1 - y;  sy = x; }
+
+    if (sx < 0 || sx >= srcW || sy < 0 || sy >= srcH) {
+        R = 114; G = 114; B = 114;
+        return;
+    }
+
+    const int uv = (sy >> 1) * img.uvRowStride + (sx >> 1) * img.uvPixelStride;
+    const int c = ((int)img.y[sy * img.yRowStride + sx] - 16) * 298 + 128;
+    const int d = (int)img.u[uv] - 128;
+    const int e = (int)img.v[uv] - 128;
+    R = clamp_u8((c + 409 * e) >> 8);
+    G = clamp_u8((c - 100 * d - 208 * e) >> 8);
+    B = clamp_u8((c + 516 * d) >> 8);
+}
+
+ncnn::Mat YoloV8::preprocess_rgba(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                  int rot, int dst, Letterbox& lb) {
+    ncnn::Mat in(dst, dst, 3);
+    float* ch0 = in.channel(0);
+    float* ch1 = in.channel(1);
+    float* ch2 = in.channel(2);
+
+    letterbox_sample(srcW, srcH, rot, dst, lb,
+        [&](int sx, int sy, uint8_t& R, uint8_t& G, uint8_t& B) {
+            read_pixel_rotated(rgba, srcW, srcH, rowStride, rot, sx, sy, R,G,B);
+        },
+        [&](int x, int y, uint8_t R, uint8_t G, uint8_t B) {
+            int idx = y * dst + x;
+            ch0[idx] = R/255.f;
+            ch1[idx] = G/255.f;
+            ch2[idx] = B/255.f;
+        });
+    return in;
+}
+
+ncnn::Mat YoloV8::preprocess_yuv(const YuvImage& img, int dst, Letterbox& lb) {
+    ncnn::Mat in(dst, dst, 3);
+    float* ch0 = in.channel(0);
+    float* ch1 = in.channel(1);
+    float* ch2 = in.channel(2);
+
+    letterbox_sample(img.w, img.h, img.rotationDeg, dst, lb,
+        [&](int sx, int sy, uint8_t& R, uint8_t& G, uint8_t& B) {
+            read_yuv_rotated(img, sx, sy, R,G,B);
+        },
+        [&](int x, int y, uint8_t R, uint8_t G, uint8_t B) {
+            int idx = y * dst + x;
+            ch0[idx] = R/255.f;
+            ch1[idx] = G/255.f;
+            ch2[idx] = B/255.f;
+        });
+    return in;
+}
+
+ncnn::Mat YoloV8::preprocess_rgba_roi(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                      int rot, const RoiBox& roi, int dst, Letterbox& lb) {
+    const int x0 = (int)std::floor(roi.x1), y0 = (int)std::floor(roi.y1);
+    const int w = std::max(1, (int)std::ceil(roi.x2) - x0);
+    const int h = std::max(1, (int)std::ceil(roi.y2) - y0);
+
+    ncnn::Mat in(dst, dst, 3);
+    float* ch0 = in.channel(0);
+    float* ch1 = in.channel(1);
+    float* ch2 = in.channel(2);
+
+    letterbox_sample_region(x0, y0, w, h, dst, lb,
+        [&](int sx, int sy, uint8_t& R, uint8_t& G, uint8_t& B) {
+            read_pixel_rotated(rgba, srcW, srcH, rowStride, rot, sx, sy, R,G,B);
+        },
+        [&](int x, int y, uint8_t R, uint8_t G, uint8_t B) {
             int idx = y * dst + x;
             ch0[idx] = R/255.f;
             ch1[idx] = G/255.f;
             ch2[idx] = B/255.f;
+        });
+    return in;
+}
+
+ncnn::Mat YoloV8::preprocess_yuv_roi(const YuvImage& img, const RoiBox& roi, int dst, Letterbox& lb) {
+    const int x0 = (int)std::floor(roi.x1), y0 = (int)std::floor(roi.y1);
+    const int w = std::max(1, (int)std::ceil(roi.x2) - x0);
+    const int h = std::max(1, (int)std::ceil(roi.y2) - y0);
+
+    ncnn::Mat in(dst, dst, 3);
+    float* ch0 = in.channel(0);
+    float* ch1 = in.channel(1);
+    float* ch2 = in.channel(2);
+
+    letterbox_sample_region(x0, y0, w, h, dst, lb,
+        [&](int sx, int sy, uint8_t& R, uint8_t& G, uint8_t& B) {
+            read_yuv_rotated(img, sx, sy, R,G,B);
+        },
+        [&](int x, int y, uint8_t R, uint8_t G, uint8_t B) {
+            int idx = y * dst + x;
+            ch0[idx] = R/255.f;
+            ch1[idx] = G/255.f;
+            ch2[idx] = B/255.f;
+        });
+    return in;
+}
+
+void YoloV8::letterbox_rgba_u8(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                               int rot, int dst, uint8_t* rgbOut, Letterbox& lb) {
+    letterbox_sample(srcW, srcH, rot, dst, lb,
+        [&](int sx, int sy, uint8_t& R, uint8_t& G, uint8_t& B) {
+            read_pixel_rotated(rgba, srcW, srcH, rowStride, rot, sx, sy, R,G,B);
+        },
+        [&](int x, int y, uint8_t R, uint8_t G, uint8_t B) {
+            uint8_t* px = rgbOut + ((size_t)y * dst + x) * 3;
+            px[0] = R;
+            px[1] = G;
+            px[2] = B;
+        });
+}
+
+std::vector<Det> YoloV8::detect_rgb_letterboxed(const uint8_t* rgb, int dst, const Letterbox& lb,
+                                                float conf_thr, float iou_thr) {
+    auto t0 = std::chrono::steady_clock::now();
+    ncnn::Mat in = ncnn::Mat::from_pixels(rgb, ncnn::Mat::PIXEL_RGB, dst, dst);
+    const float norm[3] = {1/255.f, 1/255.f, 1/255.f};
+    in.substract_mean_normalize(0, norm);
+    timings.preprocess = ms_since(t0);
+    return infer(in, lb, conf_thr, iou_thr);
+}
+
+std::vector<Det> YoloV8::detect_rgba(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                     int rot, float conf_thr, float iou_thr, int dst) {
+    auto t0 = std::chrono::steady_clock::now();
+    Letterbox lb;
+    ncnn::Mat in = preprocess_rgba(rgba, srcW, srcH, rowStride, rot, dst, lb);
+    timings.preprocess = ms_since(t0);
+    return infer(in, lb, conf_thr, iou_thr);
+}
+
+std::vector<Det> YoloV8::detect_yuv(const YuvImage& img, float conf_thr, float iou_thr, int dst) {
+    if (!img.y || !img.u || !img.v || img.w <= 0 || img.h <= 0) return {};
+    auto t0 = std::chrono::steady_clock::now();
+    Letterbox lb;
+    ncnn::Mat in = preprocess_yuv(img, dst, lb);
+    timings.preprocess = ms_since(t0);
+    return infer(in, lb, conf_thr, iou_thr);
+}
+
+// Class-aware greedy NMS, props are sorted by score in place
+static std::vector<Det> nms_per_class(std::vector<Det>& props, float iou_thr) {
+    std::sort(props.begin(), props.end(),
+              [](const Det& a, const Det& b) { return a.score > b.score; });
+
+    auto iou = [](const Det& a, const Det& b) -> float {
+        float iw = std::max(0.f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+        float ih = std::max(0.f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+        float inter = iw * ih;
+        float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+        float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+        return inter / (area_a + area_b - inter + 1e-6f);
+    };
+
+    std::vector<Det> keep;
+    std::vector<bool> suppressed(props.size(), false);
+    for (size_t i = 0; i < props.size(); ++i) {
+        if (suppressed[i]) continue;
+        keep.push_back(props[i]);
+        for (size_t j = i + 1; j < props.size(); ++j) {
+            if (!suppressed[j] && props[j].cls == props[i].cls && iou(props[i], props[j]) > iou_thr)
+                suppressed[j] = true;
         }
     }
+    return keep;
+}
 
-    ncnn::Extractor ex = net.create_extractor();
+std::vector<Det> YoloV8::infer(const ncnn::Mat& in, const Letterbox& lb, float conf_thr, float iou_thr) {
+    timings.inference = timings.postprocess = 0.f;
+    auto t0 = std::chrono::steady_clock::now();
+
+    ncnn::Extractor ex = active->create_extractor();
     ex.set_light_mode(useOptimizations); // IMPORTANT: baseline vs optimized
 
-    if (ex.input("in0", in) != 0 && ex.input("images", in) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, "yolo", "ex.input failed (no blob in0/images)");
+    if (!io.ok() || ex.input(io.input, in) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "yolo", "ex.input failed (blob %d)", io.input);
         return {};
     }
 
     ncnn::Mat out;
-    if (ex.extract("out0", out) != 0 && ex.extract("output0", out) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, "yolo", "ex.extract failed (no blob out0/output0)");
+    if (ex.extract(io.output, out) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "yolo", "ex.extract failed (blob %d)", io.output);
         return {};
     }
+    timings.inference = ms_since(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    std::vector<Det> dets = decode(out, lb, conf_thr, iou_thr);
+    timings.postprocess = ms_since(t0);
+    return dets;
+}
+
+std::vector<Det> YoloV8::decode(const ncnn::Mat& out, const Letterbox& lb, float conf_thr, float iou_thr) {
+    const float r = lb.scale;
+    const int pad_w = lb.pad_w, pad_h = lb.pad_h;
+    const float off_x = (float)lb.off_x, off_y = (float)lb.off_y;
+
+    // In-graph YoloV8DetectionOutput yields an empty blob when nothing passed
+    if (out.empty()) return {};
+
+    if (head == YoloHead::Unknown) {
+        head = detect_yolo_head(out.w, out.h);
+        __android_log_print(ANDROID_LOG_INFO, "yolo", "head: %s (out %dx%d)",
+                            head == YoloHead::End2End ? "end2end (NMS-free)" : "dense", out.w, out.h);
+    }
+
+    // One-to-one head: rows are already the final boxes in input pixels, no NMS
+    if (head == YoloHead::End2End) {
+        std::vector<Det> dets;
+        for (int i = 0; i < out.h; ++i) {
+            const float* row = out.row(i);
+            if (row[4] < conf_thr) continue;
+            Det d;
+            d.x1 = (row[0] - pad_w/2) / r + off_x;
+            d.y1 = (row[1] - pad_h/2) / r + off_y;
+            d.x2 = (row[2] - pad_w/2) / r + off_x;
+            d.y2 = (row[3] - pad_h/2) / r + off_y;
+            d.score = row[4];
+            d.cls = (int)row[5];
+            dets.push_back(d);
+        }
+        return dets;
+    }
 
     // ======= дальше твой existing decode (оставлено как было) =======
     const int num_preds = out.w;
@@ -185,12 +507,12 @@ std::vector<Det> YoloV8::detect_rgba(const uint8_t* rgba, int srcW, int srcH, in
     std::vector<Det> props;
     std::vector<float> f;
 
+    const int cls_start = (no == 84) ? 4 : 5;
+    if (no - cls_start <= 0) return {};
+
     for (int i = 0; i < num_preds; ++i) {
         get_feat_col(i, f);
 
-        const int cls_start = (no == 84) ? 4 : 5;
-        if (no - cls_start <= 0) continue;
-
         float x = f[0], y = f[1], bw = f[2], bh = f[3];
         float obj = (cls_start == 5) ? f[4] : 1.f;
 
@@ -209,10 +531,10 @@ std::vector<Det> YoloV8::detect_rgba(const uint8_t* rgba, int srcW, int srcH, in
         float y2 = y + bh/2.f;
 
         // inverse letterbox to original
-        float rbx = (x1 - pad_w/2)/r;
-        float rby = (y1 - pad_h/2)/r;
-        float rbx2= (x2 - pad_w/2)/r;
-        float rby2= (y2 - pad_h/2)/r;
+        float rbx = (x1 - pad_w/2)/r + off_x;
+        float rby = (y1 - pad_h/2)/r + off_y;
+        float rbx2= (x2 - pad_w/2)/r + off_x;
+        float rby2= (y2 - pad_h/2)/r + off_y;
 
         Det d;
         d.x1 = rbx;
@@ -224,6 +546,276 @@ std::vector<Det> YoloV8::detect_rgba(const uint8_t* rgba, int srcW, int srcH, in
         props.push_back(d);
     }
 
-    // NMS у тебя уже где-то ниже/в другом месте — оставь как есть, если он есть.
-    return props;
-}
\ No newline at end of file
+    return nms_per_class(props, iou_thr);
+}
+std::vector<RoiBox> YoloV8::plan_rois(const std::vector<RoiBox>& boxes, int frameW, int frameH,
+                                     float margin, float minSide) {
+    auto square = [&](float cx, float cy, float side) {
+        side = std::min(side, (float)std::max(frameW, frameH));
+        RoiBox r{cx - side / 2, cy - side / 2, cx + side / 2, cy + side / 2};
+        // shift inside the frame first, clip only what still does not fit
+        if (r.x1 < 0) { r.x2 -= r.x1; r.x1 = 0; }
+        if (r.y1 < 0) { r.y2 -= r.y1; r.y1 = 0; }
+        if (r.x2 > frameW) { r.x1 -= r.x2 - frameW; r.x2 = (float)frameW; }
+        if (r.y2 > frameH) { r.y1 -= r.y2 - frameH; r.y2 = (float)frameH; }
+        r.x1 = std::max(0.f, r.x1);
+        r.y1 = std::max(0.f, r.y1);
+        return r;
+    };
+
+    std::vector<RoiBox> rois;
+    for (const RoiBox& b : boxes) {
+        const float side = std::max(minSide, std::max(b.x2 - b.x1, b.y2 - b.y1) * margin);
+        rois.push_back(square((b.x1 + b.x2) / 2, (b.y1 + b.y2) / 2, side));
+    }
+
+    // Merge overlapping crops until none overlap (few boxes, quadratic is fine)
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rois.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < rois.size(); ++j) {
+                const RoiBox& a = rois[i];
+                const RoiBox& b = rois[j];
+                if (a.x2 <= b.x1 || b.x2 <= a.x1 || a.y2 <= b.y1 || b.y2 <= a.y1) continue;
+                const float x1 = std::min(a.x1, b.x1), y1 = std::min(a.y1, b.y1);
+                const float x2 = std::max(a.x2, b.x2), y2 = std::max(a.y2, b.y2);
+                rois[i] = square((x1 + x2) / 2, (y1 + y2) / 2, std::max(x2 - x1, y2 - y1));
+                rois.erase(rois.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+    return rois;
+}
+
+std::vector<Det> YoloV8::detect_yuv_rois(const YuvImage& img, const std::vector<RoiBox>& rois,
+                                         float conf_thr, float iou_thr, int dst) {
+    timings = DetTimings();
+    if (!img.y || !img.u || !img.v || img.w <= 0 || img.h <= 0) return {};
+
+    std::vector<Det> all;
+    DetTimings sum;
+    for (const RoiBox& roi : rois) {
+        auto t0 = std::chrono::steady_clock::now();
+        Letterbox lb;
+        ncnn::Mat in = preprocess_yuv_roi(img, roi, dst, lb);
+        sum.preprocess += ms_since(t0);
+
+        std::vector<Det> dets = infer(in, lb, conf_thr, iou_thr);
+        sum.inference += timings.inference;
+        sum.postprocess += timings.postprocess;
+        all.insert(all.end(), dets.begin(), dets.end());
+    }
+
+    // An object on the border of two crops is found twice
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Det> merged = rois.size() > 1 ? nms_per_class(all, iou_thr) : all;
+    sum.postprocess += ms_since(t0);
+    timings = sum;
+    return merged;
+}
+
+RoiBox YoloV8::upright_to_sensor(const RoiBox& b, int srcW, int srcH, int rot) {
+    RoiBox r = b;
+    if (rot == 90)       r = {b.y1, srcW - b.x2, b.y2, srcW - b.x1};
+    else if (rot == 180) r = {srcW - b.x2, srcH - b.y2, srcW - b.x1, srcH - b.y1};
+    else if (rot == 270) r = {srcH - b.y2, b.x1, srcH - b.y1, b.x2};
+    r.x1 = std::min(std::max(r.x1, 0.f), (float)srcW);
+    r.x2 = std::min(std::max(r.x2, 0.f), (float)srcW);
+    r.y1 = std::min(std::max(r.y1, 0.f), (float)srcH);
+    r.y2 = std::min(std::max(r.y2, 0.f), (float)srcH);
+    return r;
+}
+
+std::vector<RoiBox> YoloV8::plan_tiles(int frameW, int frameH, int tile, float overlap) {
+    const float side = (float)std::max(1, std::min(tile, std::max(frameW, frameH)));
+    const float step = std::max(1.f, side * (1.f - std::min(std::max(overlap, 0.f), 0.9f)));
+
+    auto starts = [&](int len) {
+        std::vector<float> v{0.f};
+        if (len <= side) return v;
+        for (float x = step; x + side < len; x += step) v.push_back(x);
+        v.push_back(len - side);
+        return v;
+    };
+
+    std::vector<RoiBox> tiles;
+    for (float y : starts(frameH)) {
+        for (float x : starts(frameW)) {
+            tiles.push_back({x, y, std::min(x + side, (float)frameW), std::min(y + side, (float)frameH)});
+        }
+    }
+    return tiles;
+}
+
+// Greedy box fusion after cross-tile NMS: an object cut by a tile border
+// leaves a partial box that mostly lies inside the full one (or its other
+// half), which IoU-NMS keeps. Same-class boxes whose intersection covers
+// iosThr of the smaller box are merged into their union, keeping the best score.
+static std::vector<Det> fuse_tile_boxes(std::vector<Det>& dets, float iosThr) {
+    std::sort(dets.begin(), dets.end(), [](const Det& a, const Det& b) { return a.score > b.score; });
+    std::vector<bool> used(dets.size(), false);
+    std::vector<Det> out;
+    for (size_t i = 0; i < dets.size(); ++i) {
+        if (used[i]) continue;
+        Det d = dets[i];
+        for (size_t j = i + 1; j < dets.size(); ++j) {
+            const Det& o = dets[j];
+            if (used[j] || o.cls != d.cls) continue;
+            const float iw = std::min(d.x2, o.x2) - std::max(d.x1, o.x1);
+            const float ih = std::min(d.y2, o.y2) - std::max(d.y1, o.y1);
+            if (iw <= 0.f || ih <= 0.f) continue;
+            const float smaller = std::min((d.x2 - d.x1) * (d.y2 - d.y1), (o.x2 - o.x1) * (o.y2 - o.y1));
+            if (smaller <= 0.f || iw * ih < iosThr * smaller) continue;
+            d.x1 = std::min(d.x1, o.x1); d.y1 = std::min(d.y1, o.y1);
+            d.x2 = std::max(d.x2, o.x2); d.y2 = std::max(d.y2, o.y2);
+            used[j] = true;
+        }
+        out.push_back(d);
+    }
+    return out;
+}
+
+std::vector<Det> YoloV8::detect_rgba_tiled(const RgbaImage& img, float conf_thr, float iou_thr,
+                                           int dst, const TileConfig& cfg) {
+    timings = DetTimings();
+    if (!img.rgba || img.w <= 0 || img.h <= 0 || img.rowStride <= 0 || !io.ok()) return {};
+
+    const bool swap = img.rotationDeg == 90 || img.rotationDeg == 270;
+    const int fw = swap ? img.h : img.w;
+    const int fh = swap ? img.w : img.h;
+    std::vector<RoiBox> tiles = plan_tiles(fw, fh, cfg.tile > 0 ? cfg.tile : dst, cfg.overlap);
+    if (cfg.fullFrame && tiles.size() > 1) tiles.push_back({0.f, 0.f, (float)fw, (float)fh});
+
+    // Workers only touch their own slots; decode (which settles `head`) stays
+    // on this thread. Concurrent extractors on one const Net are supported.
+    const int n = (int)tiles.size();
+    std::vector<ncnn::Mat> outs(n);
+    std::vector<Letterbox> boxes(n);
+    std::atomic<int> next{0};
+    const BlobIO blobs = io;
+    const int numWorkers = std::max(1, std::min(cfg.numWorkers, n));
+
+    // Split the net's threads across the workers instead of running
+    // numWorkers x num_threads OpenMP threads on the same cores. This ncnn
+    // has no Extractor::set_num_threads; an extractor copies net.opt when it
+    // is created, so build one here and let the workers copy it per tile.
+    const int savedThreads = active->opt.num_threads;
+    active->opt.num_threads = std::max(1, savedThreads / numWorkers);
+    ncnn::Extractor proto = active->create_extractor();
+    active->opt.num_threads = savedThreads;
+    proto.set_light_mode(useOptimizations);
+
+    auto worker = [&]() {
+        for (int i = next++; i < n; i = next++) {
+            ncnn::Mat in = preprocess_rgba_roi(img.rgba, img.w, img.h, img.rowStride, img.rotationDeg,
+                                               tiles[i], dst, boxes[i]);
+            ncnn::Extractor ex = proto;
+            if (ex.input(blobs.input, in) != 0 || ex.extract(blobs.output, outs[i]) != 0) {
+                __android_log_print(ANDROID_LOG_ERROR, "yolo", "tile %d: extract failed", i);
+                outs[i].release();
+            }
+        }
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    pool.reserve(numWorkers - 1);
+    for (int t = 1; t < numWorkers; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    const float inferMs = ms_since(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    std::vector<Det> all;
+    for (int i = 0; i < n; ++i) {
+        std::vector<Det> dets = decode(outs[i], boxes[i], conf_thr, iou_thr);
+        all.insert(all.end(), dets.begin(), dets.end());
+    }
+    std::vector<Det> kept = nms_per_class(all, iou_thr);
+    std::vector<Det> merged = fuse_tile_boxes(kept, cfg.fuseIos);
+
+    timings.inference = inferMs;
+    timings.postprocess = ms_since(t0);
+    return merged;
+}
+
+std::vector<std::vector<Det>> YoloV8::detect_batch(const std::vector<RgbaImage>& images,
+                                                   float conf_thr, float iou_thr, int dst,
+                                                   int numWorkers) {
+    const int n = (int)images.size();
+    std::vector<std::vector<Det>> results(n);
+    timings = DetTimings();
+    if (n == 0) return results;
+
+    if (numWorkers < 1) numWorkers = 1;
+    numWorkers = std::min(numWorkers, n);
+
+    // Workers letterbox frames into a ring of `window` slots ahead of the
+    // inference loop, so preprocessing of frame i+1.. overlaps inference of i
+    // while at most `window` dst x dst x 3 float inputs are alive.
+    const int window = std::min(n, numWorkers * 2);
+    std::vector<ncnn::Mat> slots(window);
+    std::vector<Letterbox> boxes(window);
+    std::vector<int> ready(window, -1);   // frame index held by the slot, -1 = free
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    int nextFrame = 0;
+    int consumed = 0;   // frames already taken by the inference loop
+
+    auto worker = [&]() {
+        for (;;) {
+            int i;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return nextFrame >= n || nextFrame < consumed + window; });
+                if (nextFrame >= n) return;
+                i = nextFrame++;
+            }
+
+            const RgbaImage& img = images[i];
+            Letterbox lb;
+            ncnn::Mat in;
+            if (img.rgba && img.w > 0 && img.h > 0 && img.rowStride > 0) {
+                in = preprocess_rgba(img.rgba, img.w, img.h, img.rowStride, img.rotationDeg, dst, lb);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                slots[i % window] = in;
+                boxes[i % window] = lb;
+                ready[i % window] = i;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(numWorkers);
+    for (int t = 0; t < numWorkers; ++t) pool.emplace_back(worker);
+
+    for (int i = 0; i < n; ++i) {
+        ncnn::Mat in;
+        Letterbox lb;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return ready[i % window] == i; });
+            in = slots[i % window];
+            lb = boxes[i % window];
+            slots[i % window].release();
+            ready[i % window] = -1;
+            consumed = i + 1;
+        }
+        cv.notify_all();
+
+        if (!in.empty()) results[i] = infer(in, lb, conf_thr, iou_thr);
+    }
+
+    for (std::thread& t : pool) t.join();
+    // infer() left the last frame's times; a batch has no single-frame timing
+    timings = DetTimings();
+    return results;
+}
@@ -2,14 +2,73 @@
 #include <android/asset_manager_jni.h>
 #include <vector>
 #include "ncnn/net.h"
+#include "net_cache.hpp"
+#include "blob_index.hpp"
 
 struct Det { float x1,y1,x2,y2,score; int cls; };
 
+// Detection head of the loaded graph
+enum class YoloHead {
+    Unknown = 0,
+    Dense,     // [4+nc (+obj)] x anchors, needs NMS (YOLOv8/v11)
+    End2End    // top-K rows of [x1,y1,x2,y2,score,cls], NMS-free (YOLO26/v10 one-to-one)
+};
+
+// Head type from the output blob dims (w = values per row, h = rows)
+YoloHead detect_yolo_head(int w, int h);
+
+// Letterbox of one preprocessed frame: dst = (src - off) * scale + pad / 2.
+// off is the top-left of the sampled region (0 for full frames, the crop for ROIs).
+struct Letterbox { float scale = 1.f; int pad_w = 0, pad_h = 0; int off_x = 0, off_y = 0; };
+
+// Region of the upright (rotated) frame, in the same pixels as Det
+struct RoiBox { float x1, y1, x2, y2; };
+
+// One RGBA frame of a batch (buffer is not owned)
+struct RgbaImage {
+    const uint8_t* rgba = nullptr;
+    int w = 0, h = 0, rowStride = 0;
+    int rotationDeg = 0;
+};
+
+// One YUV_420_888 camera frame (buffers are not owned). U and V share row and
+// pixel strides; uvPixelStride == 2 is the interleaved NV12/NV21 layout.
+struct YuvImage {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    int w = 0, h = 0;
+    int yRowStride = 0;
+    int uvRowStride = 0, uvPixelStride = 1;
+    int rotationDeg = 0;
+};
+
+// Tiling of still images much larger than the model input (SAHI-style)
+struct TileConfig {
+    int tile = 640;          // tile side in source pixels, each tile is letterboxed to dst
+    float overlap = 0.2f;    // share of a tile covered by its neighbour
+    int numWorkers = 2;      // threads preprocessing + extracting tiles on the shared net
+    bool fullFrame = true;   // also run the whole image, for objects larger than a tile
+    float fuseIos = 0.6f;    // same-class boxes overlapping this much of the smaller one are fused
+};
+
+// Wall time of the last single-frame detect call per stage, in ms
+// (all 0 after detect_batch)
+struct DetTimings {
+    float preprocess = 0.f;   // rotate + letterbox + normalize (0 for tiled)
+    float inference = 0.f;    // ex.input + output blob extraction
+    float postprocess = 0.f;  // decode + NMS + inverse letterbox
+};
+
 class YoloV8 {
 public:
+    YoloV8();
+
     bool load(AAssetManager* mgr, const char* param, const char* bin);
 
     // Load model for specific input size (assets: yolov8n_320.param etc.)
+    // Variants are kept in an LRU cache, switching back to a cached size is instant.
+    // On failure the previously loaded variant (and getLoadedSize()) stays active.
     bool loadForSize(AAssetManager* mgr, int inputSize);
 
     // NEW: Load model from filesystem paths (adb push)
@@ -20,15 +79,105 @@ public:
                                  int rotationDeg,
                                  float conf_thr, float iou_thr, int dst=640);
 
-    void clear() { net.clear(); }
+    // Camera path without an RGBA copy: YUV->RGB is done only for the pixels
+    // the letterbox samples
+    std::vector<Det> detect_yuv(const YuvImage& img, float conf_thr, float iou_thr, int dst=640);
+
+    // ROI path: letterbox each region into a dst x dst input (run with a small
+    // variant, e.g. 320), map boxes back to frame pixels and merge them with
+    // per-class NMS across crops. Regions are sampled like preprocess_yuv.
+    std::vector<Det> detect_yuv_rois(const YuvImage& img, const std::vector<RoiBox>& rois,
+                                     float conf_thr, float iou_thr, int dst);
+
+    // Crops for detect_yuv_rois around known boxes: each box grows to a square
+    // of side max(w, h) * margin (at least minSide), clamped to the frame;
+    // crops that overlap are merged into their bounding square.
+    static std::vector<RoiBox> plan_rois(const std::vector<RoiBox>& boxes, int frameW, int frameH,
+                                         float margin = 1.6f, float minSide = 96.f);
+
+    // Tiled path for high-resolution stills: overlapping tiles (plus the whole
+    // image, cfg.fullFrame) are preprocessed and extracted on cfg.numWorkers
+    // threads sharing the active net, then decoded, merged with per-class NMS
+    // and fused across tile borders. Boxes are in upright image pixels.
+    std::vector<Det> detect_rgba_tiled(const RgbaImage& img, float conf_thr, float iou_thr,
+                                       int dst, const TileConfig& cfg);
+
+    // Tile grid over a frameW x frameH upright image, last row/column flush
+    // with the border; a single tile when the image fits into one
+    static std::vector<RoiBox> plan_tiles(int frameW, int frameH, int tile, float overlap);
+
+    // Upright box (Det space) -> rectangle of the unrotated source frame, using
+    // the same mapping as the letterbox sampling; clamped to srcW x srcH
+    static RoiBox upright_to_sensor(const RoiBox& box, int srcW, int srcH, int rotationDeg);
+
+    // Offline batch path: frames are letterboxed on numWorkers threads while
+    // the calling thread runs inference in order. Results keep input order.
+    std::vector<std::vector<Det>> detect_batch(const std::vector<RgbaImage>& images,
+                                               float conf_thr, float iou_thr, int dst,
+                                               int numWorkers);
+
+    // Rotate + letterbox + normalize into a dst x dst x 3 planar Mat (thread-safe)
+    static ncnn::Mat preprocess_rgba(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                     int rotationDeg, int dst, Letterbox& lb);
+
+    // Same sampling as preprocess_rgba, converting YUV (BT.601, video range)
+    // per sampled pixel
+    static ncnn::Mat preprocess_yuv(const YuvImage& img, int dst, Letterbox& lb);
+
+    // preprocess_yuv restricted to roi (upright frame pixels)
+    static ncnn::Mat preprocess_yuv_roi(const YuvImage& img, const RoiBox& roi, int dst, Letterbox& lb);
+
+    // preprocess_rgba restricted to roi (upright image pixels)
+    static ncnn::Mat preprocess_rgba_roi(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                         int rotationDeg, const RoiBox& roi, int dst, Letterbox& lb);
+
+    // Same sampling as preprocess_rgba, but into packed uint8 RGB (dst*dst*3),
+    // the format stored by TensorCache
+    static void letterbox_rgba_u8(const uint8_t* rgba, int srcW, int srcH, int rowStride,
+                                  int rotationDeg, int dst, uint8_t* rgbOut, Letterbox& lb);
+
+    // Detect on an already letterboxed dst x dst RGB frame (e.g. from TensorCache)
+    std::vector<Det> detect_rgb_letterboxed(const uint8_t* rgb, int dst, const Letterbox& lb,
+                                            float conf_thr, float iou_thr);
+
+    // Run the net on a preprocessed input and decode boxes back to source pixels
+    std::vector<Det> infer(const ncnn::Mat& in, const Letterbox& lb, float conf_thr, float iou_thr);
+
+    void clear() { net.clear(); netCache.clear(); active = &net; io = BlobIO(); head = YoloHead::Unknown; }
 
     int getLoadedSize() const { return loadedInputSize; }
+    YoloHead headType() const { return head; }
+    const DetTimings& lastTimings() const { return timings; }
 
     void setOptimized(bool enabled) { useOptimizations = enabled; }
     bool isOptimized() const { return useOptimizations; }
 
+    // Swap Swish for the polynomial-sigmoid FastSwish layer on the next load
+    void setFastSwish(bool enabled) { fastSwish = enabled; }
+    bool isFastSwish() const { return fastSwish; }
+
+    void setCacheBudget(size_t bytes) { netCache.setBudget(bytes); }
+    NetCacheStats cacheStats() const { return netCache.stats(); }
+
+    // Threads of the bound net (e.g. its share when run next to other engines);
+    // the next load sets its own count again
+    void setNumThreads(int n) { active->opt.num_threads = n > 0 ? n : 1; }
+
 private:
-    ncnn::Net net;
+    // Makes n the net used by infer() and resolves its blob indices once
+    bool bind(ncnn::Net* n);
+
+    // Output blob -> boxes in source pixels (dense head + NMS, or end2end rows)
+    std::vector<Det> decode(const ncnn::Mat& out, const Letterbox& lb, float conf_thr, float iou_thr);
+
+    ncnn::Net net;               // load() / loadFromFile()
+    NetCache netCache;           // loadForSize() variants
+    ncnn::Net* active = &net;    // net used by detect_rgba()
+    BlobIO io;                   // blob indices of *active
+    YoloHead head = YoloHead::Unknown;
     int loadedInputSize = 640;
     bool useOptimizations = true;
+    bool fastSwish = false;
+    bool netFastSwish = false;   // override currently registered on `net`
+    DetTimings timings;
 };
\ No newline at end of file
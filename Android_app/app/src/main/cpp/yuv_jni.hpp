@@ -0,0 +1,22 @@
+#pragma once
+#include <jni.h>
+#include "yolov8.hpp"
+
+// Wraps the three direct plane buffers of a YUV_420_888 android.media.Image
+// (no copy). Returns false if a buffer is not direct or the strides are invalid.
+inline bool yuv_from_java(JNIEnv* env, jobject yBuf, jobject uBuf, jobject vBuf,
+                          jint width, jint height,
+                          jint yRowStride, jint uvRowStride, jint uvPixelStride,
+                          jint rotationDeg, YuvImage& img) {
+    img.y = (const uint8_t*)env->GetDirectBufferAddress(yBuf);
+    img.u = (const uint8_t*)env->GetDirectBufferAddress(uBuf);
+    img.v = (const uint8_t*)env->GetDirectBufferAddress(vBuf);
+    img.w = width;
+    img.h = height;
+    img.yRowStride = yRowStride;
+    img.uvRowStride = uvRowStride;
+    img.uvPixelStride = uvPixelStride;
+    img.rotationDeg = rotationDeg;
+    return img.y && img.u && img.v && width > 0 && height > 0 &&
+           yRowStride >= width && uvRowStride > 0 && uvPixelStride > 0;
+}
@@ -18,8 +18,6 @@ import androidx.recyclerview.widget.LinearLayoutManager
 import androidx.recyclerview.widget.ListAdapter
 import androidx.recyclerview.widget.RecyclerView
 import java.io.IOException
-import java.nio.ByteBuffer
-import java.nio.ByteOrder
 import java.util.Locale
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicBoolean
@@ -155,19 +153,7 @@ class BenchmarkActivity : ComponentActivity() {
                 // Convert to RGBA buffer
                 val width = bitmap.width
                 val height = bitmap.height
-                val rgbaBuffer = ByteBuffer.allocateDirect(width * height * 4)
-                rgbaBuffer.order(ByteOrder.nativeOrder())
-                
-                val pixels = IntArray(width * height)
-                bitmap.getPixels(pixels, 0, width, 0, 0, width, height)
-                
-                for (pixel in pixels) {
-                    rgbaBuffer.put((pixel shr 16 and 0xFF).toByte()) // R
-                    rgbaBuffer.put((pixel shr 8 and 0xFF).toByte())  // G
-                    rgbaBuffer.put((pixel and 0xFF).toByte())        // B
-                    rgbaBuffer.put((pixel shr 24 and 0xFF).toByte()) // A
-                }
-                rgbaBuffer.rewind()
+                val rgbaBuffer = ImageBridge.rgbaBuffer(bitmap)
 
                 // Run inference with timing
                 val startTime = SystemClock.elapsedRealtimeNanos()
@@ -8,8 +8,6 @@ import ai.onnxruntime.OrtSession
 import ai.onnxruntime.TensorInfo
 import android.graphics.Bitmap
 import android.graphics.BitmapFactory
-import android.graphics.Canvas
-import android.graphics.Color
 import android.os.Bundle
 import android.os.SystemClock
 import android.util.Log
@@ -20,9 +18,9 @@ import java.io.IOException
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.nio.FloatBuffer
+import java.security.MessageDigest
 import java.util.concurrent.Executors
 import kotlin.math.min
-import kotlin.math.roundToInt
 import ai.onnxruntime.providers.NNAPIFlags
 import java.util.EnumSet
 import org.tensorflow.lite.DataType
@@ -59,12 +57,158 @@ class CliBenchActivity : ComponentActivity() {
             inputSize: Int
         ): Array<FloatArray>
 
+        // Overlapping tiles of `tile` source pixels (<= 0: inputSize) on numWorkers
+        // threads, merged across tiles; rows as detectRgbaWithSize
+        external fun detectRgbaTiled(
+            rgba: ByteBuffer,
+            width: Int,
+            height: Int,
+            rowStride: Int,
+            rotationDeg: Int,
+            conf: Float,
+            iou: Float,
+            inputSize: Int,
+            tile: Int,
+            overlap: Float,
+            numWorkers: Int,
+            fullFrame: Boolean
+        ): Array<FloatArray>
+
+        // Packed: [N, count_0..count_{N-1}, then (x1,y1,x2,y2,score,cls) rows per image]
+        external fun detectBatch(
+            rgba: Array<ByteBuffer>,
+            widths: IntArray,
+            heights: IntArray,
+            rowStrides: IntArray,
+            conf: Float,
+            iou: Float,
+            inputSize: Int,
+            numWorkers: Int
+        ): FloatArray
+
+        // 0 = unknown, 1 = dense + NMS, 2 = end2end (NMS-free)
+        external fun getHeadType(): Int
+
+        // [preprocess, inference, postprocess] of the last single-frame detect call, ms
+        external fun getStageTimesMs(): FloatArray
+
+        // On-device COCO-style mAP of the loaded model
+        external fun evalReset(numClasses: Int)
+        external fun evalAddImage(
+            rgba: ByteBuffer,
+            width: Int,
+            height: Int,
+            rowStride: Int,
+            labelPath: String?,
+            conf: Float,
+            iou: Float,
+            inputSize: Int
+        ): Float
+
+        // [images, classes_with_gt, map50, map50_95]
+        external fun evalResult(): FloatArray
+
+        // Memory-mapped cache of pre-letterboxed frames (one file per subset and imgsz)
+        external fun tensorCacheOpen(path: String, imgsz: Int): Int
+        external fun tensorCacheBuildBegin(path: String, imgsz: Int): Boolean
+        external fun tensorCacheAppend(rgba: ByteBuffer, width: Int, height: Int, rowStride: Int): Boolean
+        external fun tensorCacheBuildEnd(): Int
+        external fun tensorCacheClose()
+        external fun detectCached(index: Int, conf: Float, iou: Float): Array<FloatArray>
+        external fun evalAddCached(index: Int, labelPath: String?, conf: Float, iou: Float): Float
+
         external fun release()
         external fun setOptimized(enabled: Boolean)
         external fun isOptimized(): Boolean
+        external fun setFastSwish(enabled: Boolean)
+    }
+
+    // task=seg: YOLOv11-seg engine (yolov11seg_jni.cpp)
+    object SegBridge {
+        init {
+            System.loadLibrary("ncnn")
+            System.loadLibrary("yolo")
+        }
+
+        external fun init(assetMgr: android.content.res.AssetManager): Boolean
+        external fun setOptimized(enabled: Boolean)
+        external fun setFastSwish(enabled: Boolean)
+        external fun loadFromFile(paramPath: String, binPath: String, inputSize: Int, numThreads: Int): Boolean
+
+        // Rows of [x1, y1, x2, y2, score, cls, mask_w, mask_h];
+        // maskMode 0 = boxes only, 1 = coarse masks, 2 = full masks
+        external fun detectSegRgbaWithSize(
+            rgba: ByteBuffer,
+            width: Int,
+            height: Int,
+            rowStride: Int,
+            rotationDeg: Int,
+            conf: Float,
+            iou: Float,
+            inputSize: Int,
+            maskMode: Int
+        ): Array<FloatArray>
+
+        // [preprocess, inference, decode, masks] of the last detect call, ms
+        external fun getStageTimesMs(): FloatArray
+        external fun release()
+    }
+
+    // Per-stage averages of the timed loop (preprocess / inference / postprocess),
+    // reported next to avg_ms so backends can be compared stage by stage
+    private class StageTimes {
+        private var preprocess = 0.0
+        private var inference = 0.0
+        private var postprocess = 0.0
+        private var n = 0
+
+        // Four elapsedRealtimeNanos() stamps around the three stages
+        fun add(t0: Long, t1: Long, t2: Long, t3: Long) {
+            preprocess += (t1 - t0) / 1_000_000.0
+            inference += (t2 - t1) / 1_000_000.0
+            postprocess += (t3 - t2) / 1_000_000.0
+            n++
+        }
+
+        fun addNative(ms: FloatArray) {
+            if (ms.size < 3) return
+            preprocess += ms[0]
+            inference += ms[1]
+            postprocess += ms[2]
+            n++
+        }
+
+        fun putInto(json: JSONObject) {
+            if (n == 0) return
+            json.put("preprocess_ms", preprocess / n)
+            json.put("inference_ms", inference / n)
+            json.put("postprocess_ms", postprocess / n)
+        }
+    }
+
+    // labelPath: YOLO .txt pushed next to the image (same stem), null if absent
+    private data class ImageData(
+        val buffer: ByteBuffer,
+        val width: Int,
+        val height: Int,
+        val labelPath: String? = null
+    )
+    // Frames served from the native tensor cache; labels[i] belongs to frame i
+    private data class CachedDataset(
+        val frames: Int,
+        val labels: List<String?>,
+        val status: String,
+        val path: String,
+        val buildMs: Double
+    )
+
+    private data class TensorCacheConfig(val enabled: Boolean, val dir: String, val datasetKey: String)
+
+    // tile > 0: SAHI-style tiled inference on full-resolution images (detectRgbaTiled)
+    private data class TileConfig(val tile: Int, val overlap: Float, val workers: Int, val fullFrame: Boolean) {
+        val enabled: Boolean get() = tile > 0
     }
 
-    private data class ImageData(val buffer: ByteBuffer, val width: Int, val height: Int)
     private data class OrtInputShape(val n: Long, val c: Long, val h: Long, val w: Long)
     private data class ImageSourceConfig(
         val dataset: String,
@@ -86,6 +230,7 @@ class CliBenchActivity : ComponentActivity() {
         super.onCreate(savedInstanceState)
 
         val backend = (intent.getStringExtra("backend") ?: "ncnn").trim().lowercase()
+        val task = (intent.getStringExtra("task") ?: "detect").trim().lowercase()
         val provider = (intent.getStringExtra("provider") ?: "xnnpack").trim().lowercase()
         val delegate = (intent.getStringExtra("delegate") ?: provider).trim().lowercase()
 
@@ -104,7 +249,25 @@ class CliBenchActivity : ComponentActivity() {
         val conf = intent.getFloatExtra("conf", 0.25f)
         val iou = intent.getFloatExtra("iou", 0.45f)
         val optimized = intent.getBooleanExtra("optimized", true)
+        val fastSwish = intent.getBooleanExtra("fast_swish", false)
         val maxAssetImages = intent.getIntExtra("max_images", MAX_ASSET_IMAGES_DEFAULT).coerceAtLeast(1)
+        val batch = intent.getIntExtra("batch", 1).coerceAtLeast(1)
+        val batchWorkers = intent.getIntExtra("batch_workers", 2).coerceAtLeast(1)
+        val evalMap = intent.getBooleanExtra("eval_map", false)
+        val evalConf = intent.getFloatExtra("eval_conf", 0.001f)
+        val numClasses = intent.getIntExtra("num_classes", 80).coerceAtLeast(1)
+        val segMasks = (intent.getStringExtra("seg_masks") ?: "full").trim().lowercase()
+        val tensorCache = TensorCacheConfig(
+            enabled = intent.getBooleanExtra("tensor_cache", false),
+            dir = intent.getStringExtra("tensor_cache_dir") ?: "/data/local/tmp/xtrim_tensor_cache",
+            datasetKey = intent.getStringExtra("dataset_key") ?: ""
+        )
+        val tiles = TileConfig(
+            tile = intent.getIntExtra("tile", 0).coerceAtLeast(0),
+            overlap = intent.getFloatExtra("tile_overlap", 0.2f).coerceIn(0f, 0.9f),
+            workers = intent.getIntExtra("tile_workers", 2).coerceAtLeast(1),
+            fullFrame = intent.getBooleanExtra("tile_full", true)
+        )
 
         // Optional external image subset pushed by the Python benchmark wrapper.
         // If use_pushed_images=false, the activity keeps the old behavior and reads assets/<dataset>/.
@@ -150,7 +313,23 @@ class CliBenchActivity : ComponentActivity() {
                         )
                     }
 
-                    else -> {
+                    else -> if (task == "seg") {
+                        benchSegOnce(
+                            paramPath = paramPath,
+                            binPath = binPath,
+                            imageSource = imageSource,
+                            runId = runId,
+                            imgsz = imgsz,
+                            loops = loops,
+                            warmup = warmup,
+                            threads = threads,
+                            conf = conf,
+                            iou = iou,
+                            optimized = optimized,
+                            fastSwish = fastSwish,
+                            segMasks = segMasks
+                        )
+                    } else {
                         benchNcnnOnce(
                             paramPath = paramPath,
                             binPath = binPath,
@@ -162,7 +341,15 @@ class CliBenchActivity : ComponentActivity() {
                             threads = threads,
                             conf = conf,
                             iou = iou,
-                            optimized = optimized
+                            optimized = optimized,
+                            fastSwish = fastSwish,
+                            batch = batch,
+                            batchWorkers = batchWorkers,
+                            evalMap = evalMap,
+                            evalConf = evalConf,
+                            numClasses = numClasses,
+                            tensorCache = tensorCache,
+                            tiles = tiles
                         )
                     }
                 }
@@ -182,7 +369,7 @@ class CliBenchActivity : ComponentActivity() {
 
             try {
                 if (backend != "ort" && backend != "onnx" && backend != "ort_android" && backend != "tflite" && backend != "tf_lite" && backend != "litert") {
-                    YoloBridge.release()
+                    if (task == "seg") SegBridge.release() else YoloBridge.release()
                 }
             } catch (_: Exception) {
             }
@@ -202,7 +389,15 @@ class CliBenchActivity : ComponentActivity() {
         threads: Int,
         conf: Float,
         iou: Float,
-        optimized: Boolean
+        optimized: Boolean,
+        fastSwish: Boolean,
+        batch: Int,
+        batchWorkers: Int,
+        evalMap: Boolean,
+        evalConf: Float,
+        numClasses: Int,
+        tensorCache: TensorCacheConfig,
+        tiles: TileConfig
     ): JSONObject {
         if (paramPath.isNullOrBlank() || binPath.isNullOrBlank()) {
             throw IllegalArgumentException("Missing extras: param/bin")
@@ -214,54 +409,287 @@ class CliBenchActivity : ComponentActivity() {
         }
 
         YoloBridge.setOptimized(optimized)
+        YoloBridge.setFastSwish(fastSwish)
 
         val okLoad = YoloBridge.loadFromFile(paramPath, binPath, imgsz, threads)
         if (!okLoad) {
             throw RuntimeException("loadFromFile failed: param=$paramPath bin=$binPath imgsz=$imgsz threads=$threads")
         }
 
+        // The batch API letterboxes on its own workers and tiles need the original
+        // resolution, so the cache is for plain batch=1 only.
+        val cached = if (tensorCache.enabled && batch == 1 && !tiles.enabled && imageSource.usePushedImages) {
+            openOrBuildTensorCache(imageSource, tensorCache, imgsz)
+        } else {
+            null
+        }
+
+        val imageList = if (cached != null) emptyList() else loadImages(imageSource)
+        if (cached == null && imageList.isEmpty()) {
+            throw RuntimeException("No images from ${describeImageSource(imageSource)}")
+        }
+
+        fun detectTiled(img: ImageData): Array<FloatArray> {
+            img.buffer.rewind()
+            return YoloBridge.detectRgbaTiled(
+                img.buffer, img.width, img.height, img.width * 4, 0, conf, iou, imgsz,
+                tiles.tile, tiles.overlap, tiles.workers, tiles.fullFrame
+            )
+        }
+
+        repeat(warmup) {
+            if (cached != null) {
+                YoloBridge.detectCached(0, conf, iou)
+            } else if (tiles.enabled) {
+                detectTiled(imageList[0])
+            } else {
+                val warmImg = imageList[0]
+                warmImg.buffer.rewind()
+                YoloBridge.detectRgbaWithSize(
+                    warmImg.buffer,
+                    warmImg.width,
+                    warmImg.height,
+                    warmImg.width * 4,
+                    0,
+                    conf,
+                    iou,
+                    imgsz
+                )
+            }
+        }
+
+        val times = DoubleArray(loops)
+        val stages = StageTimes()  // single-frame paths only, detectBatch overlaps the stages
+        var detSum = 0L
+
+        if (cached != null) {
+            for (i in 0 until loops) {
+                val t0 = SystemClock.elapsedRealtimeNanos()
+                val dets = YoloBridge.detectCached(i % cached.frames, conf, iou)
+                val t1 = SystemClock.elapsedRealtimeNanos()
+
+                times[i] = (t1 - t0) / 1_000_000.0
+                detSum += dets.size.toLong()
+                stages.addNative(YoloBridge.getStageTimesMs())
+            }
+        } else if (tiles.enabled) {
+            for (i in 0 until loops) {
+                val img = imageList[i % imageList.size]
+
+                val t0 = SystemClock.elapsedRealtimeNanos()
+                val dets = detectTiled(img)
+                val t1 = SystemClock.elapsedRealtimeNanos()
+
+                times[i] = (t1 - t0) / 1_000_000.0
+                detSum += dets.size.toLong()
+                stages.addNative(YoloBridge.getStageTimesMs())
+            }
+        } else if (batch > 1) {
+            // One JNI call per `batch` images; times[] keeps per-image latency.
+            for (i in 0 until loops) {
+                val chunk = List(batch) { imageList[(i * batch + it) % imageList.size] }
+                val buffers = Array(batch) { chunk[it].buffer }
+                val widths = IntArray(batch) { chunk[it].width }
+                val heights = IntArray(batch) { chunk[it].height }
+                val strides = IntArray(batch) { chunk[it].width * 4 }
+
+                val t0 = SystemClock.elapsedRealtimeNanos()
+                val packed = YoloBridge.detectBatch(
+                    buffers, widths, heights, strides, conf, iou, imgsz, batchWorkers
+                )
+                val t1 = SystemClock.elapsedRealtimeNanos()
+
+                times[i] = (t1 - t0) / 1_000_000.0 / batch
+                val n = if (packed.isNotEmpty()) packed[0].toInt() else 0
+                for (k in 0 until n) detSum += packed[1 + k].toLong()
+            }
+        } else {
+            for (i in 0 until loops) {
+                val img = imageList[i % imageList.size]
+                img.buffer.rewind()
+
+                val t0 = SystemClock.elapsedRealtimeNanos()
+                val dets = YoloBridge.detectRgbaWithSize(
+                    img.buffer,
+                    img.width,
+                    img.height,
+                    img.width * 4,
+                    0,
+                    conf,
+                    iou,
+                    imgsz
+                )
+                val t1 = SystemClock.elapsedRealtimeNanos()
+
+                times[i] = (t1 - t0) / 1_000_000.0
+                detSum += dets.size.toLong()
+                stages.addNative(YoloBridge.getStageTimesMs())
+            }
+        }
+
+        val avg = times.average()
+        val min = times.minOrNull() ?: avg
+        val max = times.maxOrNull() ?: avg
+
+        var varSum = 0.0
+        for (t in times) {
+            val d = t - avg
+            varSum += d * d
+        }
+        val std = kotlin.math.sqrt(varSum / times.size.coerceAtLeast(1))
+        val detAvg = detSum.toDouble() / (times.size.toDouble() * (if (tiles.enabled) 1 else batch))
+
+        // Accuracy pass: same engine, same decode/NMS, one pass over the subset.
+        // Uses a low conf threshold like COCO val; its latency is reported separately.
+        var evalSum = 0.0
+        var evalN = 0
+        val evalResult: FloatArray? = if (evalMap) {
+            YoloBridge.evalReset(numClasses)
+            val n = cached?.frames ?: imageList.size
+            for (i in 0 until n) {
+                val ms = if (cached != null) {
+                    YoloBridge.evalAddCached(i, cached.labels[i], evalConf, iou)
+                } else {
+                    val img = imageList[i]
+                    img.buffer.rewind()
+                    YoloBridge.evalAddImage(
+                        img.buffer, img.width, img.height, img.width * 4,
+                        img.labelPath, evalConf, iou, imgsz
+                    )
+                }
+                if (ms >= 0f) {
+                    evalSum += ms
+                    evalN++
+                }
+            }
+            YoloBridge.evalResult()
+        } else {
+            null
+        }
+        val evalAvgMs = if (evalN > 0) evalSum / evalN else 0.0
+
+        return JSONObject().apply {
+            put("ok", true)
+            put("backend", "ncnn")
+            put("run_id", runId)
+            put("avg_ms", avg)
+            put("min_ms", min)
+            put("max_ms", max)
+            put("std_ms", std)
+            put("n", times.size)
+            put("images", cached?.frames ?: imageList.size)
+            put("loops", loops)
+            put("warmup", warmup)
+            put("imgsz", imgsz)
+            put("threads", threads)
+            put("optimized", optimized)
+            put("fast_swish", fastSwish)
+            put("head", when (YoloBridge.getHeadType()) {
+                1 -> "dense"
+                2 -> "end2end"
+                else -> "unknown"
+            })
+            put("tensor_cache", cached?.status ?: "off")
+            if (cached != null) {
+                put("tensor_cache_path", cached.path)
+                put("tensor_cache_build_ms", cached.buildMs)
+            }
+            put("batch", batch)
+            put("batch_workers", batchWorkers)
+            put("tile", tiles.tile)
+            if (tiles.enabled) {
+                put("tile_overlap", tiles.overlap.toDouble())
+                put("tile_workers", tiles.workers)
+                put("tile_full", tiles.fullFrame)
+            }
+            put("det_avg", detAvg)
+            stages.putInto(this)
+            put("eval_map", evalMap)
+            if (evalResult != null && evalResult.size >= 4) {
+                put("eval_images", evalResult[0].toInt())
+                put("eval_classes", evalResult[1].toInt())
+                put("map50", evalResult[2].toDouble())
+                put("map50_95", evalResult[3].toDouble())
+                put("eval_conf", evalConf.toDouble())
+                put("eval_avg_ms", evalAvgMs)
+            }
+            put("dataset", imageSource.dataset)
+            put("image_source", describeImageSource(imageSource))
+            put("use_pushed_images", imageSource.usePushedImages)
+            put("image_dir", imageSource.imageDir ?: "")
+            put("image_list", imageSource.imageList ?: "")
+            put("requested_image_count", requestedImageLimit(imageSource))
+            put("param", paramPath)
+            put("bin", binPath)
+        }
+    }
+
+    private fun benchSegOnce(
+        paramPath: String?,
+        binPath: String?,
+        imageSource: ImageSourceConfig,
+        runId: String,
+        imgsz: Int,
+        loops: Int,
+        warmup: Int,
+        threads: Int,
+        conf: Float,
+        iou: Float,
+        optimized: Boolean,
+        fastSwish: Boolean,
+        segMasks: String
+    ): JSONObject {
+        if (paramPath.isNullOrBlank() || binPath.isNullOrBlank()) {
+            throw IllegalArgumentException("Missing extras: param/bin")
+        }
+        val maskMode = when (segMasks) {
+            "none", "boxes" -> 0
+            "coarse" -> 1
+            else -> 2
+        }
+
+        if (!SegBridge.init(assets)) {
+            throw RuntimeException("SegBridge.init() failed")
+        }
+        SegBridge.setOptimized(optimized)
+        SegBridge.setFastSwish(fastSwish)
+        if (!SegBridge.loadFromFile(paramPath, binPath, imgsz, threads)) {
+            throw RuntimeException("seg loadFromFile failed: param=$paramPath bin=$binPath imgsz=$imgsz threads=$threads")
+        }
+
         val imageList = loadImages(imageSource)
         if (imageList.isEmpty()) {
             throw RuntimeException("No images from ${describeImageSource(imageSource)}")
         }
 
-        val warmImg = imageList[0]
-        repeat(warmup) {
-            warmImg.buffer.rewind()
-            YoloBridge.detectRgbaWithSize(
-                warmImg.buffer,
-                warmImg.width,
-                warmImg.height,
-                warmImg.width * 4,
-                0,
-                conf,
-                iou,
-                imgsz
+        fun detect(img: ImageData): Array<FloatArray> {
+            img.buffer.rewind()
+            return SegBridge.detectSegRgbaWithSize(
+                img.buffer, img.width, img.height, img.width * 4, 0, conf, iou, imgsz, maskMode
             )
         }
 
+        repeat(warmup) { detect(imageList[it % imageList.size]) }
+
         val times = DoubleArray(loops)
+        val stageSums = DoubleArray(4)
         var detSum = 0L
+        var maskPixels = 0L
 
         for (i in 0 until loops) {
             val img = imageList[i % imageList.size]
-            img.buffer.rewind()
 
             val t0 = SystemClock.elapsedRealtimeNanos()
-            val dets = YoloBridge.detectRgbaWithSize(
-                img.buffer,
-                img.width,
-                img.height,
-                img.width * 4,
-                0,
-                conf,
-                iou,
-                imgsz
-            )
+            val dets = detect(img)
             val t1 = SystemClock.elapsedRealtimeNanos()
 
             times[i] = (t1 - t0) / 1_000_000.0
+            val stages = SegBridge.getStageTimesMs()
+            for (k in 0 until min(4, stages.size)) stageSums[k] += stages[k].toDouble()
             detSum += dets.size.toLong()
+            for (d in dets) {
+                if (d.size >= 8) maskPixels += d[6].toLong() * d[7].toLong()
+            }
         }
 
         val avg = times.average()
@@ -274,11 +702,11 @@ class CliBenchActivity : ComponentActivity() {
             varSum += d * d
         }
         val std = kotlin.math.sqrt(varSum / times.size.coerceAtLeast(1))
-        val detAvg = detSum.toDouble() / times.size.toDouble()
 
         return JSONObject().apply {
             put("ok", true)
             put("backend", "ncnn")
+            put("task", "seg")
             put("run_id", runId)
             put("avg_ms", avg)
             put("min_ms", min)
@@ -291,7 +719,14 @@ class CliBenchActivity : ComponentActivity() {
             put("imgsz", imgsz)
             put("threads", threads)
             put("optimized", optimized)
-            put("det_avg", detAvg)
+            put("fast_swish", fastSwish)
+            put("seg_masks", segMasks)
+            put("preprocess_ms", stageSums[0] / loops)
+            put("inference_ms", stageSums[1] / loops)
+            put("decode_ms", stageSums[2] / loops)
+            put("masks_ms", stageSums[3] / loops)
+            put("det_avg", detSum.toDouble() / loops)
+            put("mask_px_avg", if (detSum > 0) maskPixels.toDouble() / detSum else 0.0)
             put("dataset", imageSource.dataset)
             put("image_source", describeImageSource(imageSource))
             put("use_pushed_images", imageSource.usePushedImages)
@@ -332,46 +767,41 @@ class CliBenchActivity : ComponentActivity() {
             val inputShape = resolveInputShape(session, inputName, imgsz)
             val inputArrayShape = longArrayOf(inputShape.n, inputShape.c, inputShape.h, inputShape.w)
 
-            repeat(warmup) {
-                val bmp = bitmaps[it % bitmaps.size]
-                val chw = bitmapToFloatCHWLetterbox(bmp, inputShape.w.toInt(), inputShape.h.toInt())
-                val tensor = OnnxTensor.createTensor(ortEnv, chw, inputArrayShape)
-                try {
-                    val result = session.run(mapOf(inputName to tensor))
-                    try {
-                        // Просто дожидаемся выполнения графа и освобождаем выходы.
-                    } finally {
-                        result.close()
-                    }
-                } finally {
-                    tensor.close()
-                }
-            }
+            // The native preprocessor fills the same direct buffer every frame, and ORT
+            // wraps a direct buffer without copying: one input tensor serves the whole run.
+            val chw = bitmapToFloatCHWLetterbox(bitmaps[0], inputShape.w.toInt(), inputShape.h.toInt())
+            val tensor = OnnxTensor.createTensor(ortEnv, chw, inputArrayShape)
 
             val times = DoubleArray(loops)
+            val stages = StageTimes()
             var outputCountSum = 0L
 
-            for (i in 0 until loops) {
-                val bmp = bitmaps[i % bitmaps.size]
-
-                val t0 = SystemClock.elapsedRealtimeNanos()
-
-                val chw = bitmapToFloatCHWLetterbox(bmp, inputShape.w.toInt(), inputShape.h.toInt())
-                val tensor = OnnxTensor.createTensor(ortEnv, chw, inputArrayShape)
-
-                try {
+            try {
+                fun runOnce(bmp: Bitmap, record: Boolean) {
+                    val t0 = SystemClock.elapsedRealtimeNanos()
+                    bitmapToFloatCHWLetterbox(bmp, inputShape.w.toInt(), inputShape.h.toInt())
+                    val t1 = SystemClock.elapsedRealtimeNanos()
                     val result = session.run(mapOf(inputName to tensor))
+                    val t2 = SystemClock.elapsedRealtimeNanos()
                     try {
-                        outputCountSum += result.size().toLong()
+                        if (record) outputCountSum += result.size().toLong()
                     } finally {
                         result.close()
                     }
-                } finally {
-                    tensor.close()
+                    val t3 = SystemClock.elapsedRealtimeNanos()
+                    if (record) stages.add(t0, t1, t2, t3)
                 }
 
-                val t1 = SystemClock.elapsedRealtimeNanos()
-                times[i] = (t1 - t0) / 1_000_000.0
+                repeat(warmup) { runOnce(bitmaps[it % bitmaps.size], record = false) }
+
+                for (i in 0 until loops) {
+                    val t0 = SystemClock.elapsedRealtimeNanos()
+                    runOnce(bitmaps[i % bitmaps.size], record = true)
+                    val t1 = SystemClock.elapsedRealtimeNanos()
+                    times[i] = (t1 - t0) / 1_000_000.0
+                }
+            } finally {
+                tensor.close()
             }
 
             val avg = times.average()
@@ -408,6 +838,7 @@ class CliBenchActivity : ComponentActivity() {
                 put("input_h", inputShape.h)
                 put("input_w", inputShape.w)
                 put("output_count_avg", outAvg)
+                stages.putInto(this)
                 put("dataset", imageSource.dataset)
                 put("image_source", describeImageSource(imageSource))
                 put("use_pushed_images", imageSource.usePushedImages)
@@ -480,8 +911,12 @@ class CliBenchActivity : ComponentActivity() {
 
             val outputBuffers = createTfliteOutputBuffers(interpreter)
 
-            repeat(warmup) {
-                val bmp = bitmaps[it % bitmaps.size]
+            val times = DoubleArray(loops)
+            val stages = StageTimes()
+            var outputCountSum = 0L
+
+            fun runOnce(bmp: Bitmap, record: Boolean) {
+                val t0 = SystemClock.elapsedRealtimeNanos()
                 val input = bitmapToTfliteInputLetterbox(
                     src = bmp,
                     targetW = inputW,
@@ -491,32 +926,22 @@ class CliBenchActivity : ComponentActivity() {
                     zeroPoint = inputTensor.quantizationParams().zeroPoint,
                     layout = layout
                 )
-                clearTfliteOutputBuffers(outputBuffers)
+                val t1 = SystemClock.elapsedRealtimeNanos()
                 interpreter.runForMultipleInputsOutputs(arrayOf(input), outputBuffers)
+                val t2 = SystemClock.elapsedRealtimeNanos()
+                if (record) outputCountSum += outputBuffers.size.toLong()
+                clearTfliteOutputBuffers(outputBuffers)
+                val t3 = SystemClock.elapsedRealtimeNanos()
+                if (record) stages.add(t0, t1, t2, t3)
             }
 
-            val times = DoubleArray(loops)
-            var outputCountSum = 0L
+            repeat(warmup) { runOnce(bitmaps[it % bitmaps.size], record = false) }
 
             for (i in 0 until loops) {
-                val bmp = bitmaps[i % bitmaps.size]
-
                 val t0 = SystemClock.elapsedRealtimeNanos()
-                val input = bitmapToTfliteInputLetterbox(
-                    src = bmp,
-                    targetW = inputW,
-                    targetH = inputH,
-                    dataType = inputTensor.dataType(),
-                    scale = inputTensor.quantizationParams().scale,
-                    zeroPoint = inputTensor.quantizationParams().zeroPoint,
-                    layout = layout
-                )
-                clearTfliteOutputBuffers(outputBuffers)
-                interpreter.runForMultipleInputsOutputs(arrayOf(input), outputBuffers)
+                runOnce(bitmaps[i % bitmaps.size], record = true)
                 val t1 = SystemClock.elapsedRealtimeNanos()
-
                 times[i] = (t1 - t0) / 1_000_000.0
-                outputCountSum += outputBuffers.size.toLong()
             }
 
             val avg = times.average()
@@ -559,6 +984,7 @@ class CliBenchActivity : ComponentActivity() {
                 put("input_scale", inputTensor.quantizationParams().scale.toDouble())
                 put("input_zero_point", inputTensor.quantizationParams().zeroPoint)
                 put("output_count_avg", outAvg)
+                stages.putInto(this)
                 put("output_tensors", outputBuffers.size)
                 put("dataset", imageSource.dataset)
                 put("image_source", describeImageSource(imageSource))
@@ -658,84 +1084,30 @@ class CliBenchActivity : ComponentActivity() {
         zeroPoint: Int,
         layout: String
     ): ByteBuffer {
-        val resizeScale = min(
-            targetW.toFloat() / src.width.toFloat(),
-            targetH.toFloat() / src.height.toFloat()
-        )
-
-        val newW = (src.width * resizeScale).roundToInt().coerceAtLeast(1)
-        val newH = (src.height * resizeScale).roundToInt().coerceAtLeast(1)
-
-        val resized = Bitmap.createScaledBitmap(src, newW, newH, true)
-        val canvasBitmap = Bitmap.createBitmap(targetW, targetH, Bitmap.Config.ARGB_8888)
-        val canvas = Canvas(canvasBitmap)
-        canvas.drawColor(Color.rgb(114, 114, 114))
-
-        val left = ((targetW - newW) / 2f)
-        val top = ((targetH - newH) / 2f)
-        canvas.drawBitmap(resized, left, top, null)
-
-        val pixels = IntArray(targetW * targetH)
-        canvasBitmap.getPixels(pixels, 0, targetW, 0, 0, targetW, targetH)
-
-        val bytesPerValue = when (dataType) {
-            DataType.FLOAT32 -> 4
-            DataType.UINT8, DataType.INT8 -> 1
+        val type = when (dataType) {
+            DataType.FLOAT32 -> ImageBridge.TYPE_FLOAT32
+            DataType.UINT8 -> ImageBridge.TYPE_UINT8
+            DataType.INT8 -> ImageBridge.TYPE_INT8
             else -> throw RuntimeException("Unsupported TFLite input dtype: $dataType")
         }
-
-        val byteBuf = ByteBuffer
-            .allocateDirect(bytesPerValue * 3 * targetW * targetH)
-            .order(ByteOrder.nativeOrder())
-
-        fun putValue(v: Float) {
-            when (dataType) {
-                DataType.FLOAT32 -> byteBuf.putFloat(v)
-                DataType.UINT8 -> {
-                    val q = quantizeToInt(v, scale, zeroPoint, 0, 255)
-                    byteBuf.put((q and 0xFF).toByte())
-                }
-                DataType.INT8 -> {
-                    val q = quantizeToInt(v, scale, zeroPoint, -128, 127)
-                    byteBuf.put(q.toByte())
-                }
-                else -> throw RuntimeException("Unsupported TFLite input dtype: $dataType")
-            }
-        }
-
-        if (layout == "NCHW") {
-            for (channel in 0 until 3) {
-                for (i in pixels.indices) {
-                    val p = pixels[i]
-                    val value = when (channel) {
-                        0 -> ((p shr 16) and 0xFF) / 255.0f
-                        1 -> ((p shr 8) and 0xFF) / 255.0f
-                        else -> (p and 0xFF) / 255.0f
-                    }
-                    putValue(value)
-                }
-            }
-        } else {
-            for (p in pixels) {
-                putValue(((p shr 16) and 0xFF) / 255.0f)
-                putValue(((p shr 8) and 0xFF) / 255.0f)
-                putValue((p and 0xFF) / 255.0f)
-            }
+        val byteBuf = inputTensorBuffer(ImageBridge.tensorBytes(targetW, targetH, type))
+        if (!ImageBridge.bitmapToTensor(src, targetW, targetH, type, layout == "NCHW", scale, zeroPoint, byteBuf)) {
+            throw RuntimeException("bitmapToTensor failed: ${targetW}x${targetH} $dataType $layout")
         }
-
-        byteBuf.rewind()
-        resized.recycle()
-        canvasBitmap.recycle()
         return byteBuf
     }
 
-    private fun quantizeToInt(value: Float, scale: Float, zeroPoint: Int, minValue: Int, maxValue: Int): Int {
-        val q = if (scale > 0.0f) {
-            (value / scale + zeroPoint).roundToInt()
-        } else {
-            (value * 255.0f + zeroPoint).roundToInt()
+    // One direct input buffer reused across iterations: ORT tensors are closed and
+    // TFLite runs synchronously before the next frame is written into it
+    private var inputTensorBuf: ByteBuffer? = null
+
+    private fun inputTensorBuffer(bytes: Int): ByteBuffer {
+        val cur = inputTensorBuf
+        if (cur != null && cur.capacity() == bytes) {
+            cur.rewind()
+            return cur
         }
-        return q.coerceIn(minValue, maxValue)
+        return ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder()).also { inputTensorBuf = it }
     }
 
     private fun createOrtSession(modelPath: String, provider: String, threads: Int): OrtSession {
@@ -866,6 +1238,82 @@ class CliBenchActivity : ComponentActivity() {
             .take(limit)
     }
 
+    // Key of the pushed subset: the Python side passes its hash as dataset_key,
+    // otherwise paths + sizes + mtimes of the resolved files are hashed here.
+    private fun datasetKey(files: List<File>, cfg: TensorCacheConfig): String {
+        if (cfg.datasetKey.isNotBlank()) {
+            return cfg.datasetKey.filter { it.isLetterOrDigit() || it == '-' || it == '_' }
+        }
+        val md = MessageDigest.getInstance("SHA-1")
+        for (f in files) {
+            md.update("${f.absolutePath}|${f.length()}|${f.lastModified()}\n".toByteArray())
+        }
+        return md.digest().joinToString("") { "%02x".format(it) }.take(16)
+    }
+
+    private fun tensorCacheDir(cfg: TensorCacheConfig): File {
+        val dir = File(cfg.dir)
+        if ((dir.isDirectory || dir.mkdirs()) && dir.canWrite()) return dir
+        // /data/local/tmp/<dir> must be created world-writable by the host; fall back to app cache
+        Log.w(TAG, "Tensor cache dir ${cfg.dir} is not writable, using app cache")
+        return File(cacheDir, "xtrim_tensor_cache").apply { mkdirs() }
+    }
+
+    // Opens <key>_<imgsz>.xtc or decodes the pushed images once to build it.
+    // The .txt sidecar lists the source image of every frame (for labels).
+    // Returns null if nothing could be cached; the caller then decodes as before.
+    private fun openOrBuildTensorCache(source: ImageSourceConfig, cfg: TensorCacheConfig, imgsz: Int): CachedDataset? {
+        val files = resolvePushedImageFiles(source)
+        if (files.isEmpty()) return null
+
+        val dir = tensorCacheDir(cfg)
+        val cacheFile = File(dir, "${datasetKey(files, cfg)}_$imgsz.xtc")
+        val sidecar = File(cacheFile.path + ".txt")
+
+        fun labelsOf(images: List<String>): List<String?> = images.map { path ->
+            val f = File(path)
+            val label = File(f.parentFile, f.nameWithoutExtension + ".txt")
+            if (label.isFile) label.absolutePath else null
+        }
+
+        if (sidecar.isFile) {
+            val images = sidecar.readLines().filter { it.isNotBlank() }
+            val frames = YoloBridge.tensorCacheOpen(cacheFile.path, imgsz)
+            if (frames > 0 && frames == images.size) {
+                return CachedDataset(frames, labelsOf(images), "hit", cacheFile.path, 0.0)
+            }
+        }
+
+        val t0 = SystemClock.elapsedRealtimeNanos()
+        if (!YoloBridge.tensorCacheBuildBegin(cacheFile.path, imgsz)) return null
+
+        val opts = BitmapFactory.Options().apply {
+            inPreferredConfig = Bitmap.Config.ARGB_8888
+        }
+        val written = ArrayList<String>(files.size)
+        for (file in files) {
+            try {
+                val bmp = BitmapFactory.decodeFile(file.absolutePath, opts) ?: continue
+                val buf = bitmapToRgbaBuffer(bmp)
+                if (YoloBridge.tensorCacheAppend(buf, bmp.width, bmp.height, bmp.width * 4)) {
+                    written.add(file.absolutePath)
+                }
+                bmp.recycle()
+            } catch (e: Exception) {
+                Log.w(TAG, "Failed to decode pushed image ${file.absolutePath}: $e")
+            }
+        }
+
+        if (YoloBridge.tensorCacheBuildEnd() != written.size || written.isEmpty()) return null
+        sidecar.writeText(written.joinToString("\n") + "\n")
+        sidecar.setReadable(true, false)
+
+        val frames = YoloBridge.tensorCacheOpen(cacheFile.path, imgsz)
+        if (frames != written.size) return null
+        val buildMs = (SystemClock.elapsedRealtimeNanos() - t0) / 1_000_000.0
+        return CachedDataset(frames, labelsOf(written), "built", cacheFile.path, buildMs)
+    }
+
     private fun loadBitmaps(source: ImageSourceConfig): List<Bitmap> {
         return if (source.usePushedImages) {
             loadBitmapsFromFiles(resolvePushedImageFiles(source), requestedImageLimit(source))
@@ -911,7 +1359,8 @@ class CliBenchActivity : ComponentActivity() {
             try {
                 val bmp = BitmapFactory.decodeFile(file.absolutePath, opts) ?: continue
                 val buf = bitmapToRgbaBuffer(bmp)
-                out.add(ImageData(buf, bmp.width, bmp.height))
+                val label = File(file.parentFile, file.nameWithoutExtension + ".txt")
+                out.add(ImageData(buf, bmp.width, bmp.height, if (label.isFile) label.absolutePath else null))
                 bmp.recycle()
             } catch (e: Exception) {
                 Log.w(TAG, "Failed to decode pushed image ${file.absolutePath}: $e")
@@ -955,48 +1404,11 @@ class CliBenchActivity : ComponentActivity() {
     }
 
     private fun bitmapToFloatCHWLetterbox(src: Bitmap, targetW: Int, targetH: Int): FloatBuffer {
-        val scale = min(
-            targetW.toFloat() / src.width.toFloat(),
-            targetH.toFloat() / src.height.toFloat()
-        )
-
-        val newW = (src.width * scale).roundToInt().coerceAtLeast(1)
-        val newH = (src.height * scale).roundToInt().coerceAtLeast(1)
-
-        val resized = Bitmap.createScaledBitmap(src, newW, newH, true)
-        val canvasBitmap = Bitmap.createBitmap(targetW, targetH, Bitmap.Config.ARGB_8888)
-        val canvas = Canvas(canvasBitmap)
-        canvas.drawColor(Color.rgb(114, 114, 114))
-
-        val left = ((targetW - newW) / 2f)
-        val top = ((targetH - newH) / 2f)
-        canvas.drawBitmap(resized, left, top, null)
-
-        val pixels = IntArray(targetW * targetH)
-        canvasBitmap.getPixels(pixels, 0, targetW, 0, 0, targetW, targetH)
-
-        val byteBuf = ByteBuffer
-            .allocateDirect(4 * 3 * targetW * targetH)
-            .order(ByteOrder.nativeOrder())
-
-        val floatBuf = byteBuf.asFloatBuffer()
-        val plane = targetW * targetH
-
-        for (i in pixels.indices) {
-            val p = pixels[i]
-            val r = ((p shr 16) and 0xFF) / 255.0f
-            val g = ((p shr 8) and 0xFF) / 255.0f
-            val b = (p and 0xFF) / 255.0f
-
-            floatBuf.put(i, r)
-            floatBuf.put(plane + i, g)
-            floatBuf.put(2 * plane + i, b)
+        val byteBuf = inputTensorBuffer(ImageBridge.tensorBytes(targetW, targetH, ImageBridge.TYPE_FLOAT32))
+        if (!ImageBridge.bitmapToTensor(src, targetW, targetH, ImageBridge.TYPE_FLOAT32, true, 0f, 0, byteBuf)) {
+            throw RuntimeException("bitmapToTensor failed: ${targetW}x${targetH}")
         }
-
-        floatBuf.rewind()
-        resized.recycle()
-        canvasBitmap.recycle()
-        return floatBuf
+        return byteBuf.asFloatBuffer()
     }
 
     private fun loadImagesFromAssets(dataset: String, maxImages: Int): List<ImageData> {
@@ -1033,25 +1445,7 @@ class CliBenchActivity : ComponentActivity() {
         return out
     }
 
-    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer {
-        val width = bitmap.width
-        val height = bitmap.height
-        val buffer = ByteBuffer.allocateDirect(width * height * 4)
-        buffer.order(ByteOrder.nativeOrder())
-
-        val pixels = IntArray(width * height)
-        bitmap.getPixels(pixels, 0, width, 0, 0, width, height)
-
-        for (pixel in pixels) {
-            buffer.put(((pixel shr 16) and 0xFF).toByte())
-            buffer.put(((pixel shr 8) and 0xFF).toByte())
-            buffer.put((pixel and 0xFF).toByte())
-            buffer.put(((pixel shr 24) and 0xFF).toByte())
-        }
-
-        buffer.rewind()
-        return buffer
-    }
+    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer = ImageBridge.rgbaBuffer(bitmap)
 
     override fun onDestroy() {
         super.onDestroy()
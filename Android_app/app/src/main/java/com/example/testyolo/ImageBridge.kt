@@ -0,0 +1,40 @@
+package com.example.testyolo
+
+import android.graphics.Bitmap
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+// Native bitmap conversion (bitmap_convert.cpp). Benchmark image loading and the
+// ORT / TFLite input tensors go through here, so every backend sees the same
+// pixels and no per-pixel Kotlin loop is involved.
+object ImageBridge {
+    init { System.loadLibrary("ncnn"); System.loadLibrary("yolo") }
+
+    const val TYPE_FLOAT32 = 0
+    const val TYPE_UINT8 = 1
+    const val TYPE_INT8 = 2
+
+    // Tightly packed RGBA8888 into a direct buffer of width * height * 4 bytes
+    external fun bitmapToRgba(bitmap: Bitmap, out: ByteBuffer): Boolean
+
+    // Letterbox (bilinear fit, 114 padding) into a width x height x 3 tensor,
+    // float32 = px / 255, uint8 / int8 quantized with scale / zeroPoint
+    external fun bitmapToTensor(
+        bitmap: Bitmap,
+        width: Int, height: Int,
+        type: Int, nchw: Boolean,
+        scale: Float, zeroPoint: Int,
+        out: ByteBuffer
+    ): Boolean
+
+    fun tensorBytes(width: Int, height: Int, type: Int): Int =
+        (if (type == TYPE_FLOAT32) 4 else 1) * 3 * width * height
+
+    fun rgbaBuffer(bitmap: Bitmap): ByteBuffer {
+        val buf = ByteBuffer.allocateDirect(bitmap.width * bitmap.height * 4).order(ByteOrder.nativeOrder())
+        if (!bitmapToRgba(bitmap, buf)) {
+            throw RuntimeException("bitmapToRgba failed (${bitmap.width}x${bitmap.height} ${bitmap.config})")
+        }
+        return buf
+    }
+}
@@ -31,7 +31,7 @@ import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicLong
 
-enum class Mode { YOLO, YOLOSEG, RESNET }
+enum class Mode { YOLO, YOLOSEG, RESNET, CASCADE, MULTI }
 
 class MainActivity : ComponentActivity() {
 
@@ -69,6 +69,46 @@ class MainActivity : ComponentActivity() {
     private var frames = 0
     private var skipEvery = 1 // можно 2 для снижения нагрузки
 
+    // Adaptive input resolution (YOLO mode)
+    private val targetFrameMs = 33f
+    @Volatile private var lastInputSize = 0
+
+    // (or when a tracked box decays below trackMinConf x its matched score), other frames only
+    // (or when a tracked box decays below trackMinConf), other frames only
+    // propagate the native tracker. The log gets one event per new track id.
+    private val trackDetectEvery = 3
+    private val trackMinConf = 0.3f
+    private val trackConf = 0.1f  // ByteTrack also matches low-score boxes
+    @Volatile private var detectorFrames = 0
+
+    // Between full-frame refreshes (every roiFullEvery-th detector frame) the
+    // detector only runs the roiSize model on crops around the live tracks.
+    private val roiEnabled = true
+    private val roiFullEvery = 4
+    private val roiSize = 320
+
+    // Cascade: only the best cascadeMaxCrops boxes go to the classifier, on
+    // cascadeWorkers parallel extractors
+    private val cascadeTopK = 1
+    private val cascadeMaxCrops = 8
+    private val cascadeWorkers = 2
+    @Volatile private var cascadeDetMs = 0f
+    @Volatile private var cascadeClsMs = 0f
+
+    // Shared-frame mode: [buildMs, detMs, segMs, clsMs] of the last frame
+    @Volatile private var multiMs = FloatArray(4)
+    @Volatile private var multiSegCount = 0
+
+    // Motion gate: frames whose luma barely changed since the last processed one
+    // reuse its result (forced refresh after gateMaxStale frames)
+    private val gateEnabled = true
+    private val gateBlockDiff = 6f
+    private val gateMinChanged = 0.004f
+    private val gateMaxStale = 30
+    @Volatile private var reusedFrames = 0
+    @Volatile private var gateSavedMs = 0f
+    private var lastLoggedTrackId = 0
+
     // Current mode
     private var mode: Mode = Mode.YOLO
 
@@ -82,6 +122,42 @@ class MainActivity : ComponentActivity() {
             width: Int, height: Int, rowStride: Int, rotationDeg: Int,
             conf: Float, iou: Float
         ): Array<FloatArray>  // [x1,y1,x2,y2,score,cls,mask_w,mask_h]
+        external fun detectYuvBoxesOnly(
+            y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+            width: Int, height: Int,
+            yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float
+        ): Array<FloatArray>  // as detectRgbaBoxesOnly
+        external fun setTracking(detectEvery: Int, minTrackConf: Float)
+        external fun trackYuvBoxesOnly(
+            y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+            width: Int, height: Int,
+            yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float
+        ): Array<FloatArray>  // [x1,y1,x2,y2,score,cls,0,0,trackId]
+        external fun release()
+    }
+
+    // YOLOv8 boxes, each classified by ResNet-50 in one native call (cascade_jni.cpp)
+    object CascadeBridge {
+        init { System.loadLibrary("ncnn"); System.loadLibrary("yolo") }
+        external fun init(assetMgr: android.content.res.AssetManager): Boolean
+        external fun detectClassifyRgba(
+            rgba: ByteBuffer,
+            width: Int, height: Int, rowStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float, topK: Int, maxCrops: Int, numWorkers: Int
+        ): FloatArray // [n, topK, detectMs, classifyMs], then n x [x1,y1,x2,y2,score,cls, fineCls,fineProb x topK]
+        external fun release()
+    }
+
+    // Detector, seg and classifier on one frame letterboxed once (multi_jni.cpp)
+    object MultiBridge {
+        init { System.loadLibrary("ncnn"); System.loadLibrary("yolo") }
+        external fun init(assetMgr: android.content.res.AssetManager, det: Boolean, seg: Boolean, cls: Boolean): Boolean
+        external fun runRgba(
+            rgba: ByteBuffer,
+            width: Int, height: Int, rowStride: Int, rotationDeg: Int
+        ): FloatArray // [buildMs, detMs, segMs, clsMs, nDet, nSeg, nTop], det rows, seg rows (6 each), top pairs
         external fun release()
     }
 
@@ -103,6 +179,28 @@ class MainActivity : ComponentActivity() {
             width: Int, height: Int, rowStride: Int, rotationDeg: Int,
             conf: Float, iou: Float
         ): Array<FloatArray> // [x1,y1,x2,y2,score,cls]
+        external fun setAdaptive(targetMs: Float)
+        external fun detectRgbaAdaptive(
+            rgba: ByteBuffer,
+            width: Int, height: Int, rowStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float
+        ): Array<FloatArray> // [0] = [inputSize, frameMs, emaMs], then [x1,y1,x2,y2,score,cls]
+        external fun detectYuvAdaptive(
+            y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+            width: Int, height: Int,
+            yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float
+        ): Array<FloatArray> // as detectRgbaAdaptive
+        external fun setTracking(detectEvery: Int, minTrackConf: Float)
+        external fun setRoi(enabled: Boolean, fullEvery: Int, roiSize: Int)
+        external fun setMotionGate(enabled: Boolean, blockDiff: Float, minChanged: Float, maxStale: Int)
+        external fun getGateStats(): FloatArray // [frames, reused, forced, gateMsPerFrame, savedMs]
+        external fun trackYuvAdaptive(
+            y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+            width: Int, height: Int,
+            yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, rotationDeg: Int,
+            conf: Float, iou: Float
+        ): Array<FloatArray> // [0] = [inputSize, frameMs, emaMs, detected, roiCount, reused], then [x1,y1,x2,y2,score,cls,trackId]
         external fun release()
     }
 
@@ -155,13 +253,18 @@ class MainActivity : ComponentActivity() {
         spModel.adapter = ArrayAdapter(
             this,
             android.R.layout.simple_spinner_dropdown_item,
-            listOf("YOLOv8 (detector)", "YOLOv11n-seg (segmentation)", "ResNet-50 (classifier)")
+            listOf(
+                "YOLOv8 (detector)", "YOLOv11n-seg (segmentation)", "ResNet-50 (classifier)",
+                "YOLOv8 + ResNet-50 (cascade)", "All models (shared frame)"
+            )
         )
         spModel.onItemSelectedListener = object : AdapterView.OnItemSelectedListener {
             override fun onItemSelected(parent: AdapterView<*>, view: View?, position: Int, id: Long) {
                 val newMode = when (position) {
                     1 -> Mode.YOLOSEG
                     2 -> Mode.RESNET
+                    3 -> Mode.CASCADE
+                    4 -> Mode.MULTI
                     else -> Mode.YOLO
                 }
                 if (newMode != mode) {
@@ -173,7 +276,13 @@ class MainActivity : ComponentActivity() {
         }
 
         // init YOLO by default
-        runCatching { YoloBridge.init(assets) }
+        runCatching {
+            YoloBridge.init(assets)
+            YoloBridge.setAdaptive(targetFrameMs)
+            YoloBridge.setTracking(trackDetectEvery, trackMinConf)
+            YoloBridge.setRoi(roiEnabled, roiFullEvery, roiSize)
+            YoloBridge.setMotionGate(gateEnabled, gateBlockDiff, gateMinChanged, gateMaxStale)
+        }
 
         // camera permission
         if (ContextCompat.checkSelfPermission(this, Manifest.permission.CAMERA)
@@ -186,6 +295,8 @@ class MainActivity : ComponentActivity() {
         runCatching { YoloBridge.release() }
         runCatching { YoloSegBridge.release() }
         runCatching { ResNetBridge.release() }
+        runCatching { CascadeBridge.release() }
+        runCatching { MultiBridge.release() }
         cameraExecutor.shutdown()
         workExecutor.shutdown()
         super.onDestroy()
@@ -222,9 +333,17 @@ class MainActivity : ComponentActivity() {
     }
 
     private fun buildAnalyzerUseCase(targetRotation: Int, token: Long): ImageAnalysis {
+        // YOLO modes take the YUV planes directly: the native letterbox converts only
+        // the pixels it samples, instead of CameraX converting the whole frame to RGBA.
+        // The classifier and the cascade still read RGBA. The use case is rebuilt on
+        // every mode switch.
+        val yuvInput = usesYuv(mode)
         val analysis = ImageAnalysis.Builder()
             .setBackpressureStrategy(ImageAnalysis.STRATEGY_KEEP_ONLY_LATEST)
-            .setOutputImageFormat(ImageAnalysis.OUTPUT_IMAGE_FORMAT_RGBA_8888)
+            .setOutputImageFormat(
+                if (yuvInput) ImageAnalysis.OUTPUT_IMAGE_FORMAT_YUV_420_888
+                else ImageAnalysis.OUTPUT_IMAGE_FORMAT_RGBA_8888
+            )
             .setTargetResolution(Size(1280, 720))
             .setTargetRotation(targetRotation)
             .build()
@@ -232,6 +351,8 @@ class MainActivity : ComponentActivity() {
         analysis.setAnalyzer(cameraExecutor, ImageAnalysis.Analyzer { image ->
             // игнорируем кадры прошлых сессий
             if (sessionToken.get() != token) { image.close(); return@Analyzer }
+            // mode already switched, but this use case still delivers the old format
+            if (yuvInput != usesYuv(mode)) { image.close(); return@Analyzer }
 
             inFlight.incrementAndGet()
             try {
@@ -239,13 +360,31 @@ class MainActivity : ComponentActivity() {
                 if (frames % skipEvery != 0) { image.close(); return@Analyzer }
 
                 val plane = image.planes[0]
-                val buf = plane.buffer // RGBA8888
+                val buf = plane.buffer // Y plane, or RGBA8888 for the classifier
+                val uv = if (yuvInput) image.planes[1] else null
                 when (mode) {
                     Mode.YOLO -> {
-                        val dets = YoloBridge.detectRgba(
-                            buf, image.width, image.height, plane.rowStride,
-                            image.imageInfo.rotationDegrees, 0.25f, 0.45f
-                        )
+                        val res = if (uv != null) {
+                            YoloBridge.trackYuvAdaptive(
+                                buf, uv.buffer, image.planes[2].buffer,
+                                image.width, image.height,
+                                plane.rowStride, uv.rowStride, uv.pixelStride,
+                                image.imageInfo.rotationDegrees, trackConf, 0.45f
+                            )
+                        } else {
+                            YoloBridge.detectRgbaAdaptive(
+                                buf, image.width, image.height, plane.rowStride,
+                                image.imageInfo.rotationDegrees, 0.25f, 0.45f
+                            )
+                        }
+                        if (res.isNotEmpty()) {
+                            // ROI frames run the small model on crops; keep showing the full-frame size
+                            if (res[0].size < 5 || res[0][4] == 0f) lastInputSize = res[0][0].toInt()
+                            if (res[0].size < 4 || res[0][3] > 0f) detectorFrames++
+                            if (res[0].size >= 6 && res[0][5] > 0f) reusedFrames++
+                            if (uv != null && frames % 30 == 0) gateSavedMs = YoloBridge.getGateStats()[4]
+                        }
+                        val dets = res.drop(1)
                         overlay.post {
                             overlay.update(
                                 image.width, image.height, dets.toList(),
@@ -253,20 +392,22 @@ class MainActivity : ComponentActivity() {
                             )
                             updateHudFps(dets.size)
                         }
-                        val events = dets.sortedByDescending { it[4] }.take(5).map { d ->
-                            DetectionEvent(
-                                System.currentTimeMillis(),
-                                clsName(d[5].toInt()),
-                                d[4]
-                            )
-                        }
-                        DetectionLog.addAll(events)
+                        logNewTracks(dets, 6)
                     }
                     Mode.YOLOSEG -> {
-                        val dets = YoloSegBridge.detectRgbaBoxesOnly(
-                            buf, image.width, image.height, plane.rowStride,
-                            image.imageInfo.rotationDegrees, 0.25f, 0.45f
-                        )
+                        val dets = if (uv != null) {
+                            YoloSegBridge.trackYuvBoxesOnly(
+                                buf, uv.buffer, image.planes[2].buffer,
+                                image.width, image.height,
+                                plane.rowStride, uv.rowStride, uv.pixelStride,
+                                image.imageInfo.rotationDegrees, trackConf, 0.45f
+                            )
+                        } else {
+                            YoloSegBridge.detectRgbaBoxesOnly(
+                                buf, image.width, image.height, plane.rowStride,
+                                image.imageInfo.rotationDegrees, 0.25f, 0.45f
+                            )
+                        }
                         overlay.post {
                             overlay.updateSeg(
                                 image.width, image.height, dets.toList(),
@@ -274,14 +415,7 @@ class MainActivity : ComponentActivity() {
                             )
                             updateHudFps(dets.size)
                         }
-                        val events = dets.sortedByDescending { it[4] }.take(5).map { d ->
-                            DetectionEvent(
-                                System.currentTimeMillis(),
-                                clsName(d[5].toInt()),
-                                d[4]
-                            )
-                        }
-                        DetectionLog.addAll(events)
+                        logNewTracks(dets.toList(), 8)
                     }
                     Mode.RESNET -> {
                         val top = ResNetBridge.classifyRgba(
@@ -311,6 +445,54 @@ class MainActivity : ComponentActivity() {
                         }
                         DetectionLog.addAll(events)
                     }
+                    Mode.CASCADE -> {
+                        val packed = CascadeBridge.detectClassifyRgba(
+                            buf, image.width, image.height, plane.rowStride,
+                            image.imageInfo.rotationDegrees, 0.25f, 0.45f,
+                            cascadeTopK, cascadeMaxCrops, cascadeWorkers
+                        )
+                        val n = if (packed.size >= 4) packed[0].toInt() else 0
+                        val stride = 6 + 2 * (if (packed.size >= 4) packed[1].toInt() else 0)
+                        val dets = List(n) { packed.copyOfRange(4 + it * stride, 4 + (it + 1) * stride) }
+                        if (packed.size >= 4) { cascadeDetMs = packed[2]; cascadeClsMs = packed[3] }
+                        overlay.post {
+                            overlay.update(
+                                image.width, image.height, dets,
+                                image.imageInfo.rotationDegrees
+                            )
+                            updateHudFps(n)
+                        }
+                        val now = System.currentTimeMillis()
+                        DetectionLog.addAll(dets.filter { it[6] >= 0f }.take(5).map { d ->
+                            DetectionEvent(now, "${clsName(d[5].toInt())} / imagenet ${d[6].toInt()}", d[7])
+                        })
+                    }
+                    Mode.MULTI -> {
+                        val packed = MultiBridge.runRgba(
+                            buf, image.width, image.height, plane.rowStride,
+                            image.imageInfo.rotationDegrees
+                        )
+                        if (packed.size < 7) return@Analyzer
+                        val nDet = packed[4].toInt()
+                        val nSeg = packed[5].toInt()
+                        val nTop = packed[6].toInt()
+                        val dets = List(nDet) { packed.copyOfRange(7 + it * 6, 13 + it * 6) }
+                        val topAt = 7 + (nDet + nSeg) * 6
+                        multiMs = packed.copyOfRange(0, 4)
+                        multiSegCount = nSeg
+                        overlay.post {
+                            overlay.update(
+                                image.width, image.height, dets,
+                                image.imageInfo.rotationDegrees
+                            )
+                            updateHudFps(nDet)
+                        }
+                        if (nTop > 0) {
+                            DetectionLog.addAll(listOf(DetectionEvent(
+                                System.currentTimeMillis(), clsName(packed[topAt].toInt()), packed[topAt + 1]
+                            )))
+                        }
+                    }
                 }
             } catch (_: Throwable) {
                 // не падаем из анализатора
@@ -363,22 +545,52 @@ class MainActivity : ComponentActivity() {
 
         // 3) release/init на ворк-исполнителе
         workExecutor.execute {
+            lastLoggedTrackId = 0
             when (newMode) {
                 Mode.YOLO -> {
                     runCatching { ResNetBridge.release() }
                     runCatching { YoloSegBridge.release() }
-                    runCatching { YoloBridge.init(assets) }
+                    runCatching { CascadeBridge.release() }
+                    runCatching { MultiBridge.release() }
+                    runCatching {
+                        YoloBridge.init(assets)
+                        YoloBridge.setAdaptive(targetFrameMs)
+                        YoloBridge.setTracking(trackDetectEvery, trackMinConf)
+                        YoloBridge.setRoi(roiEnabled, roiFullEvery, roiSize)
+                        YoloBridge.setMotionGate(gateEnabled, gateBlockDiff, gateMinChanged, gateMaxStale)
+                    }
                 }
                 Mode.YOLOSEG -> {
                     runCatching { YoloBridge.release() }
                     runCatching { ResNetBridge.release() }
-                    runCatching { YoloSegBridge.init(assets, "yolov11n-seg.param", "yolov11n-seg.bin") }
+                    runCatching { CascadeBridge.release() }
+                    runCatching { MultiBridge.release() }
+                    runCatching {
+                        YoloSegBridge.init(assets, "yolov11n-seg.param", "yolov11n-seg.bin")
+                        YoloSegBridge.setTracking(trackDetectEvery, trackMinConf)
+                    }
                 }
                 Mode.RESNET -> {
                     runCatching { YoloBridge.release() }
                     runCatching { YoloSegBridge.release() }
+                    runCatching { CascadeBridge.release() }
+                    runCatching { MultiBridge.release() }
                     runCatching { ResNetBridge.init(assets, "resnet50.param", "resnet50.bin") }
                 }
+                Mode.CASCADE -> {
+                    runCatching { YoloBridge.release() }
+                    runCatching { YoloSegBridge.release() }
+                    runCatching { ResNetBridge.release() }
+                    runCatching { MultiBridge.release() }
+                    runCatching { CascadeBridge.init(assets) }
+                }
+                Mode.MULTI -> {
+                    runCatching { YoloBridge.release() }
+                    runCatching { YoloSegBridge.release() }
+                    runCatching { ResNetBridge.release() }
+                    runCatching { CascadeBridge.release() }
+                    runCatching { MultiBridge.init(assets, det = true, seg = true, cls = true) }
+                }
             }
 
             val myToken = sessionToken.incrementAndGet()
@@ -417,6 +629,8 @@ class MainActivity : ComponentActivity() {
         }
     }
 
+    private fun usesYuv(m: Mode): Boolean = m == Mode.YOLO || m == Mode.YOLOSEG
+
     private fun clsName(clsIdx: Int): String =
         labels.getOrNull(clsIdx) ?: "class_$clsIdx"
 
@@ -426,11 +640,45 @@ class MainActivity : ComponentActivity() {
         val dt = (now - lastT) / 1e9
         if (dt >= 1.0) {
             val fps = frames / dt
-            hud.text = String.format(Locale.US, "%.1f fps | %d det", fps, numDet)
-            frames = 0; lastT = now
+            // share of frames that ran the detector (the rest were tracked)
+            val detPct = if (frames > 0) 100 * detectorFrames / frames else 0
+            // share of frames the motion gate served from the last result
+            val staticPct = if (frames > 0) 100 * reusedFrames / frames else 0
+            hud.text = if (mode == Mode.YOLO && lastInputSize > 0) {
+                String.format(
+                    Locale.US, "%.1f fps | %d det | %dpx | %d%% infer | %d%% static, %.1fs saved",
+                    fps, numDet, lastInputSize, detPct, staticPct, gateSavedMs / 1000f
+                )
+            } else if (mode == Mode.MULTI) {
+                val t = multiMs
+                String.format(
+                    Locale.US, "%.1f fps | %d det, %d seg | frame %.0f | det %.0f seg %.0f cls %.0f ms",
+                    fps, numDet, multiSegCount, t[0], t[1], t[2], t[3]
+                )
+            } else if (mode == Mode.CASCADE) {
+                String.format(
+                    Locale.US, "%.1f fps | %d det | det %.0f ms | cls %.0f ms",
+                    fps, numDet, cascadeDetMs, cascadeClsMs
+                )
+            } else {
+                String.format(Locale.US, "%.1f fps | %d det", fps, numDet)
+            }
+            frames = 0; detectorFrames = 0; reusedFrames = 0; lastT = now
         }
     }
 
+    // One log event per track id not seen before; untracked rows (no id) are logged as-is
+    private fun logNewTracks(dets: List<FloatArray>, idIndex: Int) {
+        val now = System.currentTimeMillis()
+        val fresh = dets.filter { it.size <= idIndex || it[idIndex].toInt() > lastLoggedTrackId }
+        for (d in fresh) {
+            if (d.size > idIndex) lastLoggedTrackId = maxOf(lastLoggedTrackId, d[idIndex].toInt())
+        }
+        DetectionLog.addAll(fresh.sortedByDescending { it[4] }.take(5).map { d ->
+            DetectionEvent(now, clsName(d[5].toInt()), d[4])
+        })
+    }
+
     private fun fpsString(): String {
         val now = System.nanoTime()
         if (lastT == 0L) return "-- fps"
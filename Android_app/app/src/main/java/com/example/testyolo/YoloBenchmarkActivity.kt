@@ -17,7 +17,6 @@ import androidx.recyclerview.widget.ListAdapter
 import androidx.recyclerview.widget.RecyclerView
 import java.io.IOException
 import java.nio.ByteBuffer
-import java.nio.ByteOrder
 import java.util.Locale
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicBoolean
@@ -74,6 +73,10 @@ class YoloBenchmarkActivity : ComponentActivity() {
         // Optimization mode control
         external fun setOptimized(enabled: Boolean)
         external fun isOptimized(): Boolean
+
+        // Loaded-model cache (per size + optimization profile)
+        external fun setCacheBudgetMb(megabytes: Int)
+        external fun getCacheStats(): IntArray  // [loads, hits, evictions, entries, usedKB, budgetKB]
     }
 
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -364,9 +367,15 @@ class YoloBenchmarkActivity : ComponentActivity() {
         bitmaps.clear()
         System.gc()
 
+        val cache = YoloBridge.getCacheStats()
+        val cacheInfo = if (cache.size >= 6) {
+            "cache: ${cache[0]} loads, ${cache[1]} hits, ${cache[2]} evictions, ${cache[4] / 1024}/${cache[5] / 1024} MB"
+        } else ""
+
         runOnUiThread {
             tvTotalTime.text = formatTime(totalTimeMs)
-            tvStatus.text = if (shouldStop.get()) "Stopped" else "Completed!"
+            tvStatus.text = (if (shouldStop.get()) "Stopped" else "Completed!") +
+                    if (cacheInfo.isNotEmpty()) "\n$cacheInfo" else ""
             progressBar.progress = 100
             isRunning.set(false)
             btnRun.isEnabled = true
@@ -374,24 +383,7 @@ class YoloBenchmarkActivity : ComponentActivity() {
         }
     }
 
-    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer {
-        val width = bitmap.width
-        val height = bitmap.height
-        val buffer = ByteBuffer.allocateDirect(width * height * 4)
-        buffer.order(ByteOrder.nativeOrder())
-
-        val pixels = IntArray(width * height)
-        bitmap.getPixels(pixels, 0, width, 0, 0, width, height)
-
-        for (pixel in pixels) {
-            buffer.put((pixel shr 16 and 0xFF).toByte()) // R
-            buffer.put((pixel shr 8 and 0xFF).toByte())  // G
-            buffer.put((pixel and 0xFF).toByte())        // B
-            buffer.put((pixel shr 24 and 0xFF).toByte()) // A
-        }
-        buffer.rewind()
-        return buffer
-    }
+    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer = ImageBridge.rgbaBuffer(bitmap)
 
     private fun formatTime(ms: Double): String {
         return when {
@@ -15,7 +15,6 @@ import androidx.recyclerview.widget.ListAdapter
 import androidx.recyclerview.widget.RecyclerView
 import java.io.IOException
 import java.nio.ByteBuffer
-import java.nio.ByteOrder
 import java.util.Locale
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicBoolean
@@ -27,7 +26,12 @@ data class SegBenchmarkResult(
     val numSegmentations: Int,
     val minTimeMs: Double,
     val maxTimeMs: Double,
-    val avgMaskPixels: Int
+    val avgMaskPixels: Int,
+    // Mean per-stage split of avgTimeMs (native side, excludes JNI marshalling)
+    val preprocessMs: Double = 0.0,
+    val inferenceMs: Double = 0.0,
+    val decodeMs: Double = 0.0,
+    val masksMs: Double = 0.0
 )
 
 class YoloSegBenchmarkActivity : ComponentActivity() {
@@ -71,6 +75,8 @@ class YoloSegBenchmarkActivity : ComponentActivity() {
             width: Int, height: Int, rowStride: Int, rotationDeg: Int,
             conf: Float, iou: Float, inputSize: Int
         ): Array<FloatArray>
+        // [preprocess, inference, decode, masks] of the last detect call, ms
+        external fun getStageTimesMs(): FloatArray
         external fun releaseSeg()
     }
 
@@ -316,6 +322,7 @@ class YoloSegBenchmarkActivity : ComponentActivity() {
             }
 
             val times = mutableListOf<Double>()
+            val stageSums = DoubleArray(4)
             var totalSegmentations = 0
             var totalMaskPixels = 0L
 
@@ -337,6 +344,8 @@ class YoloSegBenchmarkActivity : ComponentActivity() {
                     val end = SystemClock.elapsedRealtimeNanos()
 
                     times.add((end - start) / 1_000_000.0)
+                    val stages = YoloSegBridge.getStageTimesMs()
+                    for (k in 0 until minOf(4, stages.size)) stageSums[k] += stages[k].toDouble()
                     totalSegmentations += dets.size
 
                     // Sum up mask pixels (mask_w * mask_h from detection results)
@@ -365,7 +374,11 @@ class YoloSegBenchmarkActivity : ComponentActivity() {
                     numSegmentations = avgSegs,
                     minTimeMs = minTime,
                     maxTimeMs = maxTime,
-                    avgMaskPixels = avgMaskPx
+                    avgMaskPixels = avgMaskPx,
+                    preprocessMs = stageSums[0] / times.size,
+                    inferenceMs = stageSums[1] / times.size,
+                    decodeMs = stageSums[2] / times.size,
+                    masksMs = stageSums[3] / times.size
                 ))
 
                 runOnUiThread {
@@ -392,24 +405,7 @@ class YoloSegBenchmarkActivity : ComponentActivity() {
         }
     }
 
-    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer {
-        val width = bitmap.width
-        val height = bitmap.height
-        val buffer = ByteBuffer.allocateDirect(width * height * 4)
-        buffer.order(ByteOrder.nativeOrder())
-
-        val pixels = IntArray(width * height)
-        bitmap.getPixels(pixels, 0, width, 0, 0, width, height)
-
-        for (pixel in pixels) {
-            buffer.put((pixel shr 16 and 0xFF).toByte()) // R
-            buffer.put((pixel shr 8 and 0xFF).toByte())  // G
-            buffer.put((pixel and 0xFF).toByte())        // B
-            buffer.put((pixel shr 24 and 0xFF).toByte()) // A
-        }
-        buffer.rewind()
-        return buffer
-    }
+    private fun bitmapToRgbaBuffer(bitmap: Bitmap): ByteBuffer = ImageBridge.rgbaBuffer(bitmap)
 
     private fun formatTime(ms: Double): String {
         return when {
@@ -452,8 +448,9 @@ class SegResolutionResultAdapter : ListAdapter<SegBenchmarkResult, SegResolution
         holder.tvFps.text = String.format(Locale.US, "%.1f FPS", item.fps)
         holder.tvLatency.text = String.format(Locale.US, "%.1f ms", item.avgTimeMs)
         holder.tvDetails.text = String.format(
-            Locale.US, "min: %.1fms | max: %.1fms",
-            item.minTimeMs, item.maxTimeMs
+            Locale.US, "min: %.1fms | max: %.1fms\npre %.1f • infer %.1f • decode %.1f • masks %.1f ms",
+            item.minTimeMs, item.maxTimeMs,
+            item.preprocessMs, item.inferenceMs, item.decodeMs, item.masksMs
         )
         holder.tvMaskInfo.text = String.format(
             Locale.US, "~%d segs • %d mask px",
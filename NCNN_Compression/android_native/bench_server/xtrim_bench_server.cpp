@@ -0,0 +1,546 @@
+// Persistent ncnn benchmark server for xtrim latency runs.
+//
+// Replaces one `am start CliBenchActivity` per candidate: the process stays
+// up, models are loaded and unloaded over a TCP socket and results come back
+// as JSON, one object per line. On the phone it listens on the device
+// loopback and xtrim reaches it through `adb forward` (xtrim/bench_server.py);
+// on Linux it runs as is and any local client can talk to it:
+//   xtrim_bench_server --port 7700
+//   printf '{"cmd":"ping"}\n' | nc -q1 127.0.0.1 7700
+//
+// Requests (flat JSON objects, one per line):
+//   {"cmd":"load", "param":..., "bin":..., "imgsz":640, "threads":4,
+//    "optimized":true, "fast_swish":false, "powersave":0,
+//    "input":"in0", "output":"out0"}            input/output are optional
+//   {"cmd":"bench", "loops":50, "warmup":10, "progress":false, "run_id":...,
+//    "batch":1, "batch_workers":2}           batch fields are optional
+//   {"cmd":"unload"}  {"cmd":"ping"}  {"cmd":"shutdown"}
+// Every request gets exactly one final line with "ok" (and "error" when
+// false). bench with progress=true first streams {"event":"progress",...}
+// lines, one per timed loop.
+//
+// The net is loaded with the app's Option profile and custom layers
+// (custom_layers.hpp), so passes written by NcnnConverter load here too.
+// Timings cover the net forward on a letterbox-filled imgsz x imgsz frame;
+// image decode and postprocessing outside the graph are not included.
+// batch > 1 mirrors the app's detect_batch(): each timed step letterboxes
+// `batch` 1280x720 RGB frames on batch_workers threads, overlapped with the
+// forwards of one net; times are per image and include the letterbox.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "net.h"
+
+#include "app_option.hpp"
+#include "custom_layers.hpp"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+// Flat JSON object; values are kept as their raw text (strings unescaped).
+// Nested objects/arrays are not part of the protocol and are rejected.
+using Request = std::map<std::string, std::string>;
+
+void skip_ws(const std::string& s, size_t& i) {
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+}
+
+bool parse_string(const std::string& s, size_t& i, std::string& out) {
+    if (i >= s.size() || s[i] != '"') return false;
+    i++;
+    out.clear();
+    while (i < s.size() && s[i] != '"') {
+        char c = s[i++];
+        if (c == '\\') {
+            if (i >= s.size()) return false;
+            const char e = s[i++];
+            switch (e) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u':
+                    // Paths and ids are ASCII; keep a placeholder for anything else
+                    if (i + 4 > s.size()) return false;
+                    i += 4;
+                    c = '?';
+                    break;
+                default: c = e; break;
+            }
+        }
+        out += c;
+    }
+    if (i >= s.size()) return false;
+    i++;
+    return true;
+}
+
+bool parse_request(const std::string& line, Request& req) {
+    req.clear();
+    size_t i = 0;
+    skip_ws(line, i);
+    if (i >= line.size() || line[i] != '{') return false;
+    i++;
+    skip_ws(line, i);
+    if (i < line.size() && line[i] == '}') return true;
+
+    while (i < line.size()) {
+        std::string key;
+        skip_ws(line, i);
+        if (!parse_string(line, i, key)) return false;
+        skip_ws(line, i);
+        if (i >= line.size() || line[i] != ':') return false;
+        i++;
+        skip_ws(line, i);
+        if (i >= line.size()) return false;
+
+        std::string value;
+        if (line[i] == '"') {
+            if (!parse_string(line, i, value)) return false;
+        } else {
+            const size_t start = i;
+            while (i < line.size() && line[i] != ',' && line[i] != '}' && line[i] != ' ' && line[i] != '\t') i++;
+            value = line.substr(start, i - start);
+            if (value.empty() || value[0] == '{' || value[0] == '[') return false;
+        }
+        req[key] = value;
+
+        skip_ws(line, i);
+        if (i >= line.size()) return false;
+        if (line[i] == '}') return true;
+        if (line[i] != ',') return false;
+        i++;
+    }
+    return false;
+}
+
+std::string get_str(const Request& r, const char* key, const char* def = "") {
+    auto it = r.find(key);
+    return it == r.end() ? std::string(def) : it->second;
+}
+
+int get_int(const Request& r, const char* key, int def) {
+    auto it = r.find(key);
+    return it == r.end() ? def : atoi(it->second.c_str());
+}
+
+bool get_bool(const Request& r, const char* key, bool def) {
+    auto it = r.find(key);
+    if (it == r.end()) return def;
+    return it->second == "true" || it->second == "1";
+}
+
+std::string escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// One JSON object under construction, fields in insertion order
+struct Reply {
+    std::string body;
+
+    Reply& add_raw(const char* key, const std::string& raw) {
+        if (!body.empty()) body += ", ";
+        body += "\"";
+        body += key;
+        body += "\": ";
+        body += raw;
+        return *this;
+    }
+    Reply& add(const char* key, const std::string& v) { return add_raw(key, "\"" + escape(v) + "\""); }
+    Reply& add(const char* key, const char* v) { return add(key, std::string(v)); }
+    Reply& add(const char* key, bool v) { return add_raw(key, v ? "true" : "false"); }
+    Reply& add(const char* key, int v) { return add_raw(key, std::to_string(v)); }
+    Reply& add(const char* key, double v) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.4f", v);
+        return add_raw(key, buf);
+    }
+    std::string str() const { return "{" + body + "}"; }
+};
+
+bool send_line(int fd, const std::string& s) {
+    const std::string line = s + "\n";
+    size_t off = 0;
+    while (off < line.size()) {
+        const ssize_t n = send(fd, line.data() + off, line.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        off += (size_t)n;
+    }
+    return true;
+}
+
+std::string error_reply(const std::string& msg) {
+    return Reply().add("ok", false).add("error", msg).str();
+}
+
+struct Model {
+    std::unique_ptr<ncnn::Net> net;
+    std::string param;
+    std::string bin;
+    std::string input;
+    std::string output;
+    int imgsz = 640;
+    int threads = 4;
+    bool optimized = true;
+    bool fastSwish = false;
+};
+
+// Source frame for batch runs, a typical camera/video resolution
+const int kBatchSrcW = 1280;
+const int kBatchSrcH = 720;
+
+// Same letterbox as the app's preprocess: aspect-preserving resize, 114 pad,
+// scaled to [0, 1]. Single-threaded, the batch workers run several at once.
+ncnn::Mat letterbox_rgb(const unsigned char* rgb, int w, int h, int dst) {
+    const float scale = std::min((float)dst / w, (float)dst / h);
+    const int nw = std::max(1, (int)(w * scale));
+    const int nh = std::max(1, (int)(h * scale));
+    ncnn::Mat resized = ncnn::Mat::from_pixels_resize(rgb, ncnn::Mat::PIXEL_RGB, w, h, nw, nh);
+
+    ncnn::Option opt;
+    opt.num_threads = 1;
+    const int top = (dst - nh) / 2;
+    const int left = (dst - nw) / 2;
+    ncnn::Mat in;
+    ncnn::copy_make_border(resized, in, top, dst - nh - top, left, dst - nw - left, ncnn::BORDER_CONSTANT, 114.f,
+                           opt);
+    const float norm[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
+    in.substract_mean_normalize(0, norm);
+    return in;
+}
+
+class Server {
+public:
+    // false once a shutdown was requested
+    bool serve(int fd);
+
+private:
+    std::string handle(const Request& req, int fd, bool& quit);
+    std::string cmd_load(const Request& req);
+    std::string cmd_bench(const Request& req, int fd);
+    std::string cmd_unload();
+    bool run_batch(const std::vector<unsigned char>& src, int batch, int workers);
+
+    Model model;
+};
+
+std::string Server::cmd_load(const Request& req) {
+    cmd_unload();
+
+    Model m;
+    m.param = get_str(req, "param");
+    m.bin = get_str(req, "bin");
+    m.imgsz = get_int(req, "imgsz", 640);
+    m.threads = get_int(req, "threads", 4);
+    m.optimized = get_bool(req, "optimized", true);
+    m.fastSwish = get_bool(req, "fast_swish", false);
+    if (m.param.empty() || m.bin.empty()) return error_reply("load needs param and bin");
+    if (m.imgsz <= 0 || m.threads <= 0) return error_reply("imgsz and threads must be positive");
+
+    ncnn::set_cpu_powersave(get_int(req, "powersave", 0));
+
+    m.net.reset(new ncnn::Net());
+    apply_app_option(m.net->opt, m.threads, m.optimized);
+    register_yolo_layers(*m.net);
+    if (m.fastSwish) set_fast_swish(*m.net, true);
+
+    const double t0 = ncnn::get_current_time();
+    if (m.net->load_param(m.param.c_str()) != 0) return error_reply("load_param failed: " + m.param);
+    if (m.net->load_model(m.bin.c_str()) != 0) return error_reply("load_model failed: " + m.bin);
+    const double loadMs = ncnn::get_current_time() - t0;
+
+    m.input = get_str(req, "input");
+    m.output = get_str(req, "output");
+    if (m.input.empty() && !m.net->input_names().empty()) m.input = m.net->input_names()[0];
+    if (m.output.empty() && !m.net->output_names().empty()) m.output = m.net->output_names()[0];
+    if (m.input.empty() || m.output.empty()) return error_reply("cannot resolve input/output blob names");
+
+    model = std::move(m);
+    return Reply()
+        .add("ok", true)
+        .add("event", "loaded")
+        .add("load_ms", loadMs)
+        .add("input", model.input)
+        .add("output", model.output)
+        .add("layers", (int)model.net->layers().size())
+        .str();
+}
+
+// Letterboxes `batch` copies of src on `workers` threads into a ring of
+// slots while this thread runs the forwards in order, like the app's
+// YoloV8::detect_batch()
+bool Server::run_batch(const std::vector<unsigned char>& src, int batch, int workers) {
+    workers = std::max(1, std::min(workers, batch));
+    const int window = std::min(batch, workers * 2);
+    std::vector<ncnn::Mat> slots(window);
+    std::vector<int> ready(window, -1);  // frame index held by the slot, -1 = free
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    int nextFrame = 0;
+    int consumed = 0;
+
+    auto worker = [&]() {
+        for (;;) {
+            int i;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return nextFrame >= batch || nextFrame < consumed + window; });
+                if (nextFrame >= batch) return;
+                i = nextFrame++;
+            }
+            ncnn::Mat in = letterbox_rgb(src.data(), kBatchSrcW, kBatchSrcH, model.imgsz);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                slots[i % window] = in;
+                ready[i % window] = i;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < workers; t++) pool.emplace_back(worker);
+
+    bool ok = true;
+    for (int i = 0; i < batch; i++) {
+        ncnn::Mat in;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return ready[i % window] == i; });
+            in = slots[i % window];
+            slots[i % window].release();
+            ready[i % window] = -1;
+            consumed = i + 1;
+        }
+        cv.notify_all();
+
+        // Keep draining the ring on failure so the workers can finish
+        if (!ok) continue;
+        ncnn::Extractor ex = model.net->create_extractor();
+        ncnn::Mat out;
+        ok = ex.input(model.input.c_str(), in) == 0 && ex.extract(model.output.c_str(), out) == 0;
+    }
+
+    for (std::thread& t : pool) t.join();
+    return ok;
+}
+
+std::string Server::cmd_bench(const Request& req, int fd) {
+    if (!model.net) return error_reply("no model loaded");
+
+    const int loops = get_int(req, "loops", 50);
+    const int warmup = get_int(req, "warmup", 10);
+    const bool progress = get_bool(req, "progress", false);
+    const int batch = get_int(req, "batch", 1);
+    const int batchWorkers = get_int(req, "batch_workers", 2);
+    if (loops <= 0 || warmup < 0) return error_reply("loops must be positive");
+    if (batch <= 0 || batchWorkers <= 0) return error_reply("batch and batch_workers must be positive");
+
+    // Letterbox pad value the app normalizes to; content does not change the
+    // graph's work except inside in-graph NMS
+    ncnn::Mat in(model.imgsz, model.imgsz, 3);
+    in.fill(114.f / 255.f);
+
+    // Mid-grey with a gradient, so the resize is not a constant fill
+    std::vector<unsigned char> src;
+    if (batch > 1) {
+        src.resize((size_t)kBatchSrcW * kBatchSrcH * 3);
+        for (size_t k = 0; k < src.size(); k++) src[k] = (unsigned char)(96 + (k / 3) % 64);
+    }
+
+    std::vector<double> times;
+    times.reserve(loops);
+    for (int i = 0; i < warmup + loops; i++) {
+        const double t0 = ncnn::get_current_time();
+        if (batch > 1) {
+            if (!run_batch(src, batch, batchWorkers)) return error_reply("extract failed on " + model.output);
+        } else {
+            ncnn::Extractor ex = model.net->create_extractor();
+            ncnn::Mat out;
+            if (ex.input(model.input.c_str(), in) != 0 || ex.extract(model.output.c_str(), out) != 0)
+                return error_reply("extract failed on " + model.output);
+        }
+        const double ms = (ncnn::get_current_time() - t0) / batch;
+        if (i < warmup) continue;
+
+        times.push_back(ms);
+        if (progress && !send_line(fd, Reply()
+                                           .add("event", "progress")
+                                           .add("i", (int)times.size())
+                                           .add("loops", loops)
+                                           .add("ms", ms)
+                                           .str()))
+            return std::string();
+    }
+
+    double sum = 0.0;
+    for (double t : times) sum += t;
+    const double avg = sum / times.size();
+    double var = 0.0;
+    for (double t : times) var += (t - avg) * (t - avg);
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+
+    return Reply()
+        .add("ok", true)
+        .add("event", "result")
+        .add("backend", "ncnn")
+        .add("run_id", get_str(req, "run_id"))
+        .add("avg_ms", avg)
+        .add("min_ms", sorted.front())
+        .add("max_ms", sorted.back())
+        .add("median_ms", sorted[sorted.size() / 2])
+        .add("std_ms", std::sqrt(var / times.size()))
+        .add("n", (int)times.size())
+        .add("loops", loops)
+        .add("warmup", warmup)
+        .add("imgsz", model.imgsz)
+        .add("threads", model.threads)
+        .add("optimized", model.optimized)
+        .add("fast_swish", model.fastSwish)
+        .add("batch", batch)
+        .add("batch_workers", batchWorkers)
+        .str();
+}
+
+std::string Server::cmd_unload() {
+    const bool had = (bool)model.net;
+    model = Model();
+    return Reply().add("ok", true).add("event", "unloaded").add("was_loaded", had).str();
+}
+
+std::string Server::handle(const Request& req, int fd, bool& quit) {
+    const std::string cmd = get_str(req, "cmd");
+    if (cmd == "load") return cmd_load(req);
+    if (cmd == "bench") return cmd_bench(req, fd);
+    if (cmd == "unload") return cmd_unload();
+    if (cmd == "ping") {
+        return Reply().add("ok", true).add("event", "pong").add("loaded", (bool)model.net).str();
+    }
+    if (cmd == "shutdown") {
+        quit = true;
+        return Reply().add("ok", true).add("event", "bye").str();
+    }
+    return error_reply("unknown cmd: " + cmd);
+}
+
+bool Server::serve(int fd) {
+    std::string buf;
+    char chunk[4096];
+    bool quit = false;
+    while (!quit) {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buf.append(chunk, (size_t)n);
+        if (buf.size() > 65536 && buf.find('\n') == std::string::npos) {
+            send_line(fd, error_reply("request line too long"));
+            break;
+        }
+
+        size_t nl;
+        while (!quit && (nl = buf.find('\n')) != std::string::npos) {
+            const std::string line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+            Request req;
+            const std::string reply = parse_request(line, req) ? handle(req, fd, quit) : error_reply("bad request");
+            // Empty reply: the client went away mid-stream
+            if (reply.empty() || !send_line(fd, reply)) return !quit;
+        }
+    }
+    return !quit;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int port = 7700;
+    std::string bindAddr = "127.0.0.1";
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a == "--port" && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (a == "--bind" && i + 1 < argc) {
+            bindAddr = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--port 7700] [--bind 127.0.0.1]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const int ls = socket(AF_INET, SOCK_STREAM, 0);
+    if (ls < 0) {
+        perror("socket");
+        return 1;
+    }
+    int one = 1;
+    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, bindAddr.c_str(), &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad --bind address: %s\n", bindAddr.c_str());
+        return 1;
+    }
+    if (bind(ls, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(ls, 1) != 0) {
+        perror("bind/listen");
+        return 1;
+    }
+    // xtrim waits for this line (and for ping) before sending work
+    printf("xtrim_bench_server listening on %s:%d\n", bindAddr.c_str(), port);
+    fflush(stdout);
+
+    // One client at a time; the loaded model survives reconnects
+    Server server;
+    bool running = true;
+    while (running) {
+        const int fd = accept(ls, nullptr, nullptr);
+        if (fd < 0) continue;
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        running = server.serve(fd);
+        close(fd);
+    }
+    close(ls);
+    return 0;
+}
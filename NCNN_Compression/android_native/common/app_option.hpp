@@ -0,0 +1,16 @@
+#pragma once
+#include "option.h"
+
+// ncnn::Option exactly as YoloV8::loadForSize() in the Android app sets it, so
+// host/adb tools time the same kernels the app runs. optimized=false is the
+// app's baseline profile (no fp16, packing, winograd or sgemm).
+inline void apply_app_option(ncnn::Option& opt, int threads, bool optimized) {
+    opt.num_threads = threads;
+    opt.use_vulkan_compute = false;
+    opt.use_fp16_packed = optimized;
+    opt.use_fp16_storage = optimized;
+    opt.use_packing_layout = optimized;
+    opt.use_winograd_convolution = optimized;
+    opt.use_sgemm_convolution = optimized;
+    opt.lightmode = optimized;
+}
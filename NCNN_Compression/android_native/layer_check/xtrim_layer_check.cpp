@@ -0,0 +1,232 @@
+// Self-check for the Android app's custom ncnn layers (xtrim_app_layers).
+//
+// Runs each layer on random data with 1 thread and with --threads, requires
+// identical output and prints both timings, so a build where the layers'
+// #pragma omp loops are compiled out shows up as a speed-up of ~1x.
+// FastSwish is checked against exact SiLU instead (max abs error < 1e-5).
+// Exits nonzero if any check fails.
+//
+// Runs on the host and on the phone via adb (static binary in /data/local/tmp):
+//   xtrim_layer_check --threads 4 --loops 20
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "modelbin.h"
+#include "paramdict.h"
+
+#include "app_option.hpp"
+#include "fast_swish.hpp"
+#include "lowrank_conv.hpp"
+#include "sparse_conv1x1.hpp"
+
+namespace {
+
+struct Config {
+    int threads = 4;
+    int loops = 20;
+};
+
+// Deterministic uniform [lo, hi), identical on host and device
+class Lcg {
+public:
+    explicit Lcg(unsigned int seed) : state(seed) {}
+    float next(float lo, float hi) {
+        state = state * 1664525u + 1013904223u;
+        return lo + (hi - lo) * (float)(state >> 8) / 16777216.f;
+    }
+
+private:
+    unsigned int state;
+};
+
+ncnn::Mat random_blob(int w, int h, int c, Lcg& rng) {
+    ncnn::Mat m(w, h, c);
+    for (int q = 0; q < c; q++) {
+        float* p = m.channel(q);
+        for (int i = 0; i < w * h; i++) p[i] = rng.next(-1.f, 1.f);
+    }
+    return m;
+}
+
+float max_abs_diff(const ncnn::Mat& a, const ncnn::Mat& b) {
+    if (a.w != b.w || a.h != b.h || a.c != b.c) return INFINITY;
+    float d = 0.f;
+    for (int q = 0; q < a.c; q++) {
+        const float* pa = a.channel(q);
+        const float* pb = b.channel(q);
+        for (int i = 0; i < a.w * a.h; i++) d = std::max(d, std::fabs(pa[i] - pb[i]));
+    }
+    return d;
+}
+
+// Median forward time in ms; out holds the last result
+double time_forward(const ncnn::Layer& layer, const ncnn::Mat& in, ncnn::Mat& out, const ncnn::Option& opt,
+                    int loops) {
+    std::vector<double> times;
+    for (int i = 0; i <= loops; i++) {
+        const double t0 = ncnn::get_current_time();
+        if (layer.forward(in, out, opt) != 0) return -1.0;
+        // First run is warm-up
+        if (i > 0) times.push_back(ncnn::get_current_time() - t0);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// 1 thread vs. cfg.threads on the same layer; multi-threaded output must be bit-exact
+bool check_threads(const char* name, const ncnn::Layer& layer, const ncnn::Mat& in, const Config& cfg) {
+    ncnn::Option opt1, optN;
+    apply_app_option(opt1, 1, false);
+    apply_app_option(optN, cfg.threads, false);
+
+    ncnn::Mat out1, outN;
+    const double ms1 = time_forward(layer, in, out1, opt1, cfg.loops);
+    const double msN = time_forward(layer, in, outN, optN, cfg.loops);
+    if (ms1 < 0 || msN < 0) {
+        printf("%-22s FAIL forward error\n", name);
+        return false;
+    }
+    const float diff = max_abs_diff(out1, outN);
+    const bool ok = diff == 0.f;
+    printf("%-22s %s  1t %.3f ms  %dt %.3f ms  speed-up %.2fx  max diff %g\n", name, ok ? "ok  " : "FAIL", ms1,
+           cfg.threads, msN, msN > 0 ? ms1 / msN : 0.0, diff);
+    return ok;
+}
+
+bool check_sparse_conv1x1(const Config& cfg) {
+    const int cin = 128, cout = 128, size = 80;
+    Lcg rng(1);
+
+    // ~25% dense CSR with uneven rows, like a magnitude-pruned pointwise conv
+    std::vector<int> rowPtr(1, 0), colIdx;
+    std::vector<float> values;
+    for (int p = 0; p < cout; p++) {
+        const float density = rng.next(0.05f, 0.45f);
+        for (int q = 0; q < cin; q++) {
+            if (rng.next(0.f, 1.f) >= density) continue;
+            colIdx.push_back(q);
+            values.push_back(rng.next(-0.5f, 0.5f));
+        }
+        rowPtr.push_back((int)colIdx.size());
+    }
+    const int nnz = (int)colIdx.size();
+
+    ncnn::ParamDict pd;
+    pd.set(0, cout);
+    pd.set(1, cin);
+    pd.set(2, nnz);
+    pd.set(5, 1);
+    pd.set(9, 1);
+
+    ncnn::Mat weights[4];
+    weights[0] = ncnn::Mat(cout + 1, (void*)rowPtr.data(), 4u).clone();
+    weights[1] = ncnn::Mat(nnz, (void*)colIdx.data(), 4u).clone();
+    weights[2] = ncnn::Mat(nnz, (void*)values.data(), 4u).clone();
+    weights[3] = ncnn::Mat(cout);
+    for (int p = 0; p < cout; p++) weights[3][p] = rng.next(-0.1f, 0.1f);
+
+    SparseConvolution1x1 layer;
+    if (layer.load_param(pd) != 0 || layer.load_model(ncnn::ModelBinFromMatArray(weights)) != 0) {
+        printf("%-22s FAIL load\n", "SparseConvolution1x1");
+        return false;
+    }
+    return check_threads("SparseConvolution1x1", layer, random_blob(size, size, cin, rng), cfg);
+}
+
+bool check_lowrank_conv(const Config& cfg) {
+    const int cin = 64, cout = 64, rank = 16, size = 80;
+    Lcg rng(2);
+
+    ncnn::ParamDict pd;
+    pd.set(0, cout);
+    pd.set(1, 3);
+    pd.set(4, 1);
+    pd.set(5, 1);
+    pd.set(9, 1);
+    pd.set(20, rank);
+    pd.set(21, cin);
+
+    ncnn::Mat weights[3];
+    weights[0] = ncnn::Mat(rank * cin * 9);
+    weights[1] = ncnn::Mat(cout * rank);
+    weights[2] = ncnn::Mat(cout);
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < weights[i].w; k++) weights[i][k] = rng.next(-0.1f, 0.1f);
+    }
+
+    LowRankConvolution layer;
+    if (layer.load_param(pd) != 0 || layer.load_model(ncnn::ModelBinFromMatArray(weights)) != 0) {
+        printf("%-22s FAIL load\n", "LowRankConvolution");
+        return false;
+    }
+    return check_threads("LowRankConvolution", layer, random_blob(size, size, cin, rng), cfg);
+}
+
+// fp32 path over [-40, 40]; the fp16 storage path is bounded by fp16 rounding
+bool check_fast_swish(const Config& cfg) {
+    const int n = 1 << 20;
+    ncnn::Mat x(n);
+    for (int i = 0; i < n; i++) x[i] = -40.f + 80.f * i / (n - 1);
+    ncnn::Mat y = x.clone();
+
+    ncnn::Option opt;
+    apply_app_option(opt, cfg.threads, false);
+    FastSwish layer;
+    if (layer.forward_inplace(y, opt) != 0) {
+        printf("%-22s FAIL forward error\n", "FastSwish");
+        return false;
+    }
+
+    double maxErr = 0.0;
+    float at = 0.f;
+    for (int i = 0; i < n; i++) {
+        const double e = std::fabs(y[i] - x[i] / (1.0 + std::exp(-(double)x[i])));
+        if (e > maxErr) {
+            maxErr = e;
+            at = x[i];
+        }
+    }
+    const bool ok = maxErr < 1e-5;
+    printf("%-22s %s  max abs error vs. SiLU %.3g at x=%g\n", "FastSwish", ok ? "ok  " : "FAIL", maxErr, at);
+    return ok;
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--threads N] [--loops N]\n", argv0);
+}
+
+bool parse_args(int argc, char** argv, Config& cfg) {
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (i + 1 >= argc) return false;
+        const std::string v = argv[++i];
+        if (a == "--threads") cfg.threads = std::max(1, atoi(v.c_str()));
+        else if (a == "--loops") cfg.loops = std::max(1, atoi(v.c_str()));
+        else return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return 1;
+    }
+    ncnn::set_omp_dynamic(0);
+
+    bool ok = true;
+    ok &= check_sparse_conv1x1(cfg);
+    ok &= check_lowrank_conv(cfg);
+    ok &= check_fast_swish(cfg);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,3 @@
+#pragma once
+// Forwards to the linked ncnn package, see ncnn_shim in CMakeLists.txt
+#include <layer_type.h>
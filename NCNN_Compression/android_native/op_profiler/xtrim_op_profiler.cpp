@@ -0,0 +1,314 @@
+// Per-operator latency profiler for xtrim LatencyLUT files.
+//
+// Builds single-op ncnn nets in memory (no .param/.bin on disk) for a sweep
+// of shapes, times them with the Option profile the Android app uses and
+// writes the JSON schema xtrim/latency_lut.py loads:
+//   {"device": ..., "unit": "ms", "entries": [{"op", "cin", "cout", "k",
+//    "stride", "h", "w", "groups", "latency_ms", ...}, ...]}
+// h/w are the op's output size, as recorded by build_lut_from_model().
+//
+// Runs on the host for testing and on the phone via adb (static binary in
+// /data/local/tmp, see xtrim/op_profiler.py):
+//   xtrim_op_profiler --out lut.json --device pixel7 --threads 4
+//       --ops conv1x1,conv3x3,conv3x3_s2,dw3x3,dw3x3_s2,conv3x3_d2,lowrank3x3
+//       --channels 16,32,64,128,256 --sizes 20,40,80,160 --ranks 8,16
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "net.h"
+
+#include "app_option.hpp"
+
+namespace {
+
+// Weight tags (4-byte reads) come back as 0 = raw fp32, payloads as a small
+// nonzero constant so no kernel can shortcut on zero weights.
+class DataReaderConst : public ncnn::DataReader {
+public:
+    virtual int scan(const char* /*format*/, void* /*p*/) const { return 0; }
+    virtual size_t read(void* buf, size_t size) const {
+        if (size == 4) {
+            memset(buf, 0, size);
+            return size;
+        }
+        float* f = (float*)buf;
+        for (size_t i = 0; i < size / sizeof(float); i++) f[i] = 0.01f;
+        memset((unsigned char*)buf + size / sizeof(float) * sizeof(float), 0, size % sizeof(float));
+        return size;
+    }
+};
+
+struct OpSpec {
+    std::string name;  // sweep token, e.g. conv3x3_s2
+    std::string op;    // LUT op name
+    int k = 1;
+    int stride = 1;
+    int dilation = 1;
+    bool depthwise = false;
+    bool lowrank = false;
+};
+
+struct Config {
+    std::string out = "op_lut.json";
+    std::string device = "unknown";
+    std::string profile = "optimized";
+    int threads = 4;
+    int powersave = 0;
+    int warmup = 5;
+    int loops = 20;
+    std::vector<std::string> ops = {"conv1x1", "conv3x3", "conv3x3_s2", "dw3x3", "dw3x3_s2"};
+    std::vector<int> channels = {16, 32, 64, 128, 256};
+    std::vector<int> sizes = {20, 40, 80, 160};
+    std::vector<int> ranks = {8, 16, 32};
+};
+
+std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+std::vector<int> split_ints(const std::string& s) {
+    std::vector<int> out;
+    for (const std::string& t : split(s)) out.push_back(atoi(t.c_str()));
+    return out;
+}
+
+// conv{k}x{k}[_s{s}][_d{d}], dw{k}x{k}[_s{s}], lowrank{k}x{k}[_s{s}]
+bool parse_op(const std::string& token, OpSpec& spec) {
+    spec = OpSpec();
+    spec.name = token;
+    const char* p = token.c_str();
+    if (strncmp(p, "conv", 4) == 0) {
+        p += 4;
+    } else if (strncmp(p, "dw", 2) == 0) {
+        spec.depthwise = true;
+        p += 2;
+    } else if (strncmp(p, "lowrank", 7) == 0) {
+        spec.lowrank = true;
+        p += 7;
+    } else {
+        return false;
+    }
+
+    int k = 0, k2 = 0, n = 0;
+    if (sscanf(p, "%dx%d%n", &k, &k2, &n) != 2 || k != k2 || k <= 0) return false;
+    spec.k = k;
+    p += n;
+    while (*p == '_') {
+        int v = 0;
+        if (sscanf(p, "_s%d%n", &v, &n) == 1 && v > 0) {
+            spec.stride = v;
+        } else if (sscanf(p, "_d%d%n", &v, &n) == 1 && v > 0) {
+            spec.dilation = v;
+        } else {
+            return false;
+        }
+        p += n;
+    }
+    if (*p) return false;
+
+    // Same op names as latency_lut._get_op_type(); dilation/low-rank get their own
+    char buf[64];
+    if (spec.depthwise) {
+        snprintf(buf, sizeof(buf), "conv2d_dw");
+    } else if (spec.lowrank) {
+        snprintf(buf, sizeof(buf), "lowrank%dx%d", k, k);
+    } else if (spec.dilation > 1) {
+        snprintf(buf, sizeof(buf), "conv%dx%d_d%d", k, k, spec.dilation);
+    } else {
+        snprintf(buf, sizeof(buf), "conv%dx%d", k, k);
+    }
+    spec.op = buf;
+    return true;
+}
+
+void apply_profile(ncnn::Option& opt, const Config& cfg) {
+    apply_app_option(opt, cfg.threads, cfg.profile != "baseline");
+}
+
+// Param text of the single-op net; the input is sized so that the op's
+// output is outH x outW
+std::string build_param(const OpSpec& s, int cin, int cout, int rank, int outH, int outW, int& inH, int& inW) {
+    const int kext = s.dilation * (s.k - 1) + 1;
+    const int pad = kext / 2;
+    inH = (outH - 1) * s.stride + kext - 2 * pad;
+    inW = (outW - 1) * s.stride + kext - 2 * pad;
+
+    char buf[512];
+    std::string p = "7767517\n";
+    if (s.lowrank) {
+        p += "3 3\n";
+        snprintf(buf, sizeof(buf), "Input in0 0 1 in0 0=%d 1=%d 2=%d\n", inW, inH, cin);
+        p += buf;
+        snprintf(buf, sizeof(buf), "Convolution lr_u 1 1 in0 mid 0=%d 1=%d 2=%d 3=%d 4=%d 5=0 6=%d\n",
+                 rank, s.k, s.dilation, s.stride, pad, rank * cin * s.k * s.k);
+        p += buf;
+        snprintf(buf, sizeof(buf), "Convolution lr_v 1 1 mid out0 0=%d 1=1 5=1 6=%d\n", cout, cout * rank);
+        p += buf;
+        return p;
+    }
+
+    p += "2 2\n";
+    snprintf(buf, sizeof(buf), "Input in0 0 1 in0 0=%d 1=%d 2=%d\n", inW, inH, cin);
+    p += buf;
+    if (s.depthwise) {
+        snprintf(buf, sizeof(buf), "ConvolutionDepthWise op 1 1 in0 out0 0=%d 1=%d 2=%d 3=%d 4=%d 5=1 6=%d 7=%d\n",
+                 cout, s.k, s.dilation, s.stride, pad, cout * s.k * s.k, cout);
+    } else {
+        snprintf(buf, sizeof(buf), "Convolution op 1 1 in0 out0 0=%d 1=%d 2=%d 3=%d 4=%d 5=1 6=%d\n",
+                 cout, s.k, s.dilation, s.stride, pad, cout * cin * s.k * s.k);
+    }
+    p += buf;
+    return p;
+}
+
+// Median latency in ms, or < 0 if the net cannot be built / run
+double bench_one(const std::string& param, int inH, int inW, int cin, const Config& cfg, double& minMs) {
+    ncnn::Net net;
+    apply_profile(net.opt, cfg);
+    if (net.load_param_mem(param.c_str()) != 0) return -1.0;
+    DataReaderConst dr;
+    if (net.load_model(dr) != 0) return -1.0;
+
+    ncnn::Mat in(inW, inH, cin);
+    in.fill(0.5f);
+    const int outBlob = (int)net.blobs().size() - 1;
+
+    std::vector<double> times;
+    for (int i = 0; i < cfg.warmup + cfg.loops; i++) {
+        const double t0 = ncnn::get_current_time();
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input(0, in);
+        ncnn::Mat out;
+        if (ex.extract(outBlob, out) != 0) return -1.0;
+        const double t1 = ncnn::get_current_time();
+        if (i >= cfg.warmup) times.push_back(t1 - t0);
+    }
+    std::sort(times.begin(), times.end());
+    minMs = times.front();
+    return times[times.size() / 2];
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [--out lut.json] [--device name] [--profile optimized|baseline]\n"
+            "          [--threads N] [--powersave 0|1|2] [--warmup N] [--loops N]\n"
+            "          [--ops conv1x1,conv3x3_s2,dw3x3,conv3x3_d2,lowrank3x3,...]\n"
+            "          [--channels 16,32,...] [--sizes 20,40,...] [--ranks 8,16,...]\n",
+            argv0);
+}
+
+bool parse_args(int argc, char** argv, Config& cfg) {
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        if (i + 1 >= argc) return false;
+        const std::string v = argv[++i];
+        if (a == "--out") cfg.out = v;
+        else if (a == "--device") cfg.device = v;
+        else if (a == "--profile") cfg.profile = v;
+        else if (a == "--threads") cfg.threads = std::max(1, atoi(v.c_str()));
+        else if (a == "--powersave") cfg.powersave = atoi(v.c_str());
+        else if (a == "--warmup") cfg.warmup = std::max(0, atoi(v.c_str()));
+        else if (a == "--loops") cfg.loops = std::max(1, atoi(v.c_str()));
+        else if (a == "--ops") cfg.ops = split(v);
+        else if (a == "--channels") cfg.channels = split_ints(v);
+        else if (a == "--sizes") cfg.sizes = split_ints(v);
+        else if (a == "--ranks") cfg.ranks = split_ints(v);
+        else return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<OpSpec> specs;
+    for (const std::string& t : cfg.ops) {
+        OpSpec s;
+        if (!parse_op(t, s)) {
+            fprintf(stderr, "unknown op token: %s\n", t.c_str());
+            return 1;
+        }
+        specs.push_back(s);
+    }
+
+    ncnn::set_cpu_powersave(cfg.powersave);
+    ncnn::set_omp_dynamic(0);
+    ncnn::set_omp_num_threads(cfg.threads);
+
+    FILE* fp = fopen(cfg.out.c_str(), "wb");
+    if (!fp) {
+        fprintf(stderr, "cannot open %s\n", cfg.out.c_str());
+        return 1;
+    }
+    fprintf(fp, "{\n  \"device\": \"%s\",\n  \"unit\": \"ms\",\n  \"source\": \"xtrim_op_profiler\",\n"
+                "  \"profile\": \"%s\",\n  \"threads\": %d,\n  \"entries\": [",
+            cfg.device.c_str(), cfg.profile.c_str(), cfg.threads);
+
+    int written = 0;
+    for (const OpSpec& s : specs) {
+        for (int cin : cfg.channels) {
+            for (int cout : cfg.channels) {
+                // Depthwise keeps channels; dense sweeps stay within a 2x channel ratio
+                if (s.depthwise && cout != cin) continue;
+                if (!s.depthwise && (cout > 2 * cin || cin > 2 * cout)) continue;
+
+                const std::vector<int> ranks = s.lowrank ? cfg.ranks : std::vector<int>{0};
+                for (int rank : ranks) {
+                    if (s.lowrank && rank >= std::min(cin * s.k * s.k, cout)) continue;
+                    for (int size : cfg.sizes) {
+                        int inH = 0, inW = 0;
+                        const std::string param = build_param(s, cin, cout, rank, size, size, inH, inW);
+                        if (inH <= 0 || inW <= 0) continue;
+
+                        double minMs = 0.0;
+                        const double ms = bench_one(param, inH, inW, cin, cfg, minMs);
+                        if (ms < 0) {
+                            fprintf(stderr, "skip %s cin=%d cout=%d size=%d: net failed\n",
+                                    s.name.c_str(), cin, cout, size);
+                            continue;
+                        }
+
+                        fprintf(fp, "%s\n    {\"op\": \"%s\", \"cin\": %d, \"cout\": %d, \"k\": %d, \"stride\": %d, "
+                                    "\"h\": %d, \"w\": %d, \"groups\": %d, \"dilation\": %d, ",
+                                written ? "," : "", s.op.c_str(), cin, cout, s.k, s.stride,
+                                size, size, s.depthwise ? cin : 1, s.dilation);
+                        if (s.lowrank) fprintf(fp, "\"rank\": %d, ", rank);
+                        fprintf(fp, "\"latency_ms\": %.4f, \"min_ms\": %.4f}", ms, minMs);
+                        written++;
+
+                        printf("%-14s cin=%4d cout=%4d%s size=%4d  %8.3f ms\n", s.name.c_str(), cin, cout,
+                               s.lowrank ? (" r=" + std::to_string(rank)).c_str() : "", size, ms);
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+    printf("wrote %d entries to %s\n", written, cfg.out.c_str());
+    return written > 0 ? 0 : 2;
+}
@@ -2,7 +2,12 @@ from __future__ import annotations
 
 import pytest
 
-from xtrim.android_dataset import _safe_remote_dir, prepare_android_dataset_subset
+from xtrim.android_dataset import (
+    _label_path_for,
+    _safe_remote_dir,
+    dataset_subset_hash,
+    prepare_android_dataset_subset,
+)
 
 pytestmark = pytest.mark.unit
 
@@ -47,6 +52,52 @@ def test_prepare_android_dataset_subset_copies_images_and_writes_remote_list(tmp
     ]
 
 
+def test_label_path_for_uses_last_images_dir(tmp_path):
+    assert _label_path_for(tmp_path / "images" / "val" / "a.jpg") == tmp_path / "labels" / "val" / "a.txt"
+    assert _label_path_for(tmp_path / "images" / "x" / "images" / "b.png") == tmp_path / "images" / "x" / "labels" / "b.txt"
+    assert _label_path_for(tmp_path / "flat" / "c.jpg") == tmp_path / "flat" / "c.txt"
+
+
+def test_prepare_android_dataset_subset_copies_yolo_labels(tmp_path, monkeypatch):
+    img_dir = tmp_path / "images" / "val"
+    lbl_dir = tmp_path / "labels" / "val"
+    img_dir.mkdir(parents=True)
+    lbl_dir.mkdir(parents=True)
+    (img_dir / "a.jpg").write_bytes(b"a")
+    (img_dir / "b.jpg").write_bytes(b"b")
+    (lbl_dir / "a.txt").write_text("0 0.5 0.5 0.2 0.2\n", encoding="utf-8")
+
+    def write_list(*, out_txt, **_kwargs):
+        out_txt.write_text(f"{img_dir / 'a.jpg'}\n{img_dir / 'b.jpg'}\n", encoding="utf-8")
+
+    monkeypatch.setattr("xtrim.android_dataset.make_calib_imagelist", write_list)
+    subset = prepare_android_dataset_subset(
+        data_yaml="d", split="val", max_images=2, seed=1, out_dir=tmp_path / "out", remote_dir="/r"
+    )
+
+    assert subset.count == 2
+    assert subset.labels == 1
+    assert (subset.local_dir / "000000.txt").read_text(encoding="utf-8") == "0 0.5 0.5 0.2 0.2\n"
+    assert not (subset.local_dir / "000001.txt").exists()
+    # the remote list stays images-only
+    assert subset.local_list.read_text(encoding="utf-8").splitlines() == ["/r/xtrim_bench_images/000000.jpg", "/r/xtrim_bench_images/000001.jpg"]
+
+
+def test_dataset_subset_hash_tracks_names_and_content(tmp_path):
+    (tmp_path / "000000.jpg").write_bytes(b"a")
+    (tmp_path / "000001.jpg").write_bytes(b"b")
+    h1 = dataset_subset_hash(tmp_path)
+    assert len(h1) == 16
+    assert dataset_subset_hash(tmp_path) == h1
+
+    (tmp_path / "000001.jpg").write_bytes(b"c")
+    h2 = dataset_subset_hash(tmp_path)
+    assert h2 != h1
+
+    (tmp_path / "000001.txt").write_text("0 0.5 0.5 0.1 0.1\n", encoding="utf-8")
+    assert dataset_subset_hash(tmp_path) != h2
+
+
 def test_prepare_android_dataset_subset_recreates_images_dir_and_errors(tmp_path, monkeypatch):
     out = tmp_path / "out"
     stale = out / "images"
@@ -39,6 +39,100 @@ def test_android_app_bench_run_once_success_and_helpers(tmp_path, monkeypatch):
     assert any(args[:2] == ("logcat", "-c") for args in calls)
 
 
+def test_android_app_bench_run_once_passes_batch_extras(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, clear_logcat=False, poll_interval_sec=0.0, batch=8, batch_workers=3)
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    calls = []
+
+    monkeypatch.setattr("xtrim.android_app_bench.uuid.uuid4", lambda: types.SimpleNamespace(hex="abc1234567dead"))
+    monkeypatch.setattr(bench, "is_device_ready", lambda _d: True)
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args[:1] == ("logcat",) and "-d" in args:
+            return '{"avg_ms": 1.5, "run_id": "abc1234567", "batch": 8}'
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    out = bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+
+    am = next(args for args in calls if args[:3] == ("shell", "am", "start"))
+    assert out["batch"] == 8
+    assert am[am.index("batch") - 1 : am.index("batch") + 2] == ("--ei", "batch", "8")
+    assert am[am.index("batch_workers") + 1] == "3"
+
+
+def test_android_app_bench_run_once_passes_eval_map_extras(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(
+        enabled=True, clear_logcat=False, poll_interval_sec=0.0, eval_map=True, eval_conf=0.01, fast_swish=True
+    )
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    calls = []
+
+    monkeypatch.setattr("xtrim.android_app_bench.uuid.uuid4", lambda: types.SimpleNamespace(hex="abc1234567dead"))
+    monkeypatch.setattr(bench, "is_device_ready", lambda _d: True)
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args[:1] == ("logcat",) and "-d" in args:
+            return '{"avg_ms": 1.5, "run_id": "abc1234567", "map50": 0.5, "map50_95": 0.3}'
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    out = bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+
+    am = next(args for args in calls if args[:3] == ("shell", "am", "start"))
+    assert out["map50_95"] == 0.3
+    assert am[am.index("eval_map") - 1 : am.index("eval_map") + 2] == ("--ez", "eval_map", "true")
+    assert am[am.index("eval_conf") + 1] == "0.01"
+    assert am[am.index("num_classes") + 1] == "80"
+    assert am[am.index("fast_swish") - 1 : am.index("fast_swish") + 2] == ("--ez", "fast_swish", "true")
+
+
+def test_android_app_bench_run_once_passes_tensor_cache_extras(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(
+        enabled=True, clear_logcat=False, poll_interval_sec=0.0, push_dataset_images=True, tensor_cache=True
+    )
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    images = tmp_path / "images"
+    images.mkdir()
+    (images / "000000.jpg").write_bytes(b"jpg")
+    image_list = tmp_path / "list.txt"
+    image_list.write_text("/r/000000.jpg\n", encoding="utf-8")
+    calls = []
+
+    monkeypatch.setattr("xtrim.android_app_bench.uuid.uuid4", lambda: types.SimpleNamespace(hex="abc1234567dead"))
+    monkeypatch.setattr(bench, "is_device_ready", lambda _d: True)
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args[:1] == ("logcat",) and "-d" in args:
+            return '{"avg_ms": 1.5, "run_id": "abc1234567", "tensor_cache": "hit"}'
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    out = bench.run_once(
+        device=dev,
+        local_param=tmp_path / "m.param",
+        local_bin=tmp_path / "m.bin",
+        local_images_dir=images,
+        local_image_list=image_list,
+        remote_images_dir="/r",
+        remote_image_list="/r/image_list.txt",
+        dataset_image_count=1,
+    )
+
+    am = next(args for args in calls if args[:3] == ("shell", "am", "start"))
+    assert out["tensor_cache"] == "hit"
+    assert ("shell", "mkdir", "-p", "/data/local/tmp/xtrim_tensor_cache") in calls
+    assert am[am.index("tensor_cache") + 1] == "true"
+    assert am[am.index("tensor_cache_dir") + 1] == "/data/local/tmp/xtrim_tensor_cache"
+    assert len(am[am.index("dataset_key") + 1]) == 16
+
+
 def test_android_app_bench_disabled_and_device_not_ready(tmp_path, monkeypatch):
     dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
     disabled = AndroidAppBench(ToolsConfig(), AndroidAppBenchConfig(enabled=False))
@@ -0,0 +1,229 @@
+from __future__ import annotations
+
+import json
+import socketserver
+import threading
+
+import pytest
+
+from xtrim.android_app_bench import AndroidAppBench
+from xtrim.bench_server import REMOTE_BIN, BenchServerClient, BenchServerError
+from xtrim.types import AndroidAppBenchConfig, DeviceConfig, ToolsConfig
+
+pytestmark = pytest.mark.unit
+
+
+class _FakeServer(socketserver.ThreadingTCPServer):
+    """Speaks the xtrim_bench_server line protocol on a free local port."""
+
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, port: int = 0):
+        self.requests = []
+        self.loaded = None
+        super().__init__(("127.0.0.1", port), _FakeHandler)
+        threading.Thread(target=self.serve_forever, daemon=True).start()
+
+    @property
+    def port(self) -> int:
+        return self.server_address[1]
+
+    def stop(self) -> None:
+        self.shutdown()
+        self.server_close()
+
+
+class _FakeHandler(socketserver.StreamRequestHandler):
+    def _send(self, obj) -> None:
+        self.wfile.write((json.dumps(obj) + "\n").encode("utf-8"))
+
+    def handle(self) -> None:
+        srv = self.server
+        for raw in self.rfile:
+            req = json.loads(raw)
+            srv.requests.append(req)
+            cmd = req["cmd"]
+            if cmd == "ping":
+                self._send({"ok": True, "event": "pong", "loaded": srv.loaded is not None})
+            elif cmd == "load":
+                srv.loaded = req
+                self._send({"ok": True, "event": "loaded", "load_ms": 12.5})
+            elif cmd == "bench":
+                if srv.loaded is None:
+                    self._send({"ok": False, "error": "no model loaded"})
+                    continue
+                if req.get("progress"):
+                    for i in range(req["loops"]):
+                        self._send({"event": "progress", "i": i + 1, "ms": 3.0})
+                self._send({"ok": True, "event": "result", "avg_ms": 3.0, "n": req["loops"], "run_id": req["run_id"]})
+            elif cmd == "unload":
+                srv.loaded = None
+                self._send({"ok": True, "event": "unloaded"})
+            else:
+                self._send({"ok": False, "error": f"unknown cmd: {cmd}"})
+
+
+@pytest.fixture
+def fake_server():
+    srv = _FakeServer()
+    yield srv
+    srv.stop()
+
+
+def test_client_load_bench_unload_streams_progress(fake_server):
+    progress = []
+    with BenchServerClient(port=fake_server.port, timeout=5.0) as client:
+        assert client.ping()["loaded"] is False
+        client.load("/p/model.param", "/p/model.bin", imgsz=320, threads=2, fast_swish=True)
+        out = client.bench(loops=3, warmup=1, run_id="r1", on_progress=progress.append)
+        client.unload()
+
+        with pytest.raises(BenchServerError, match="no model loaded"):
+            client.bench(loops=1, warmup=0)
+
+    assert out["avg_ms"] == 3.0 and out["run_id"] == "r1"
+    assert [p["i"] for p in progress] == [1, 2, 3]
+    load = fake_server.requests[1]
+    assert load["imgsz"] == 320 and load["threads"] == 2 and load["fast_swish"] is True
+
+
+def test_run_once_uses_resident_server_instead_of_app_launch(tmp_path, fake_server, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, bench_server=True, loops=4, warmup=2, poll_interval_sec=0.0)
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0, powersave=2)
+    calls = []
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args == ("get-state",):
+            return "device\n"
+        if args[:1] == ("forward",):
+            return f"{fake_server.port}\n"
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    monkeypatch.setattr(bench.server, "adb", fake_adb)
+
+    first = bench.run_once(device=dev, local_param=tmp_path / "a.param", local_bin=tmp_path / "a.bin")
+    second = bench.run_once(device=dev, local_param=tmp_path / "b.param", local_bin=tmp_path / "b.bin")
+
+    assert first["avg_ms"] == 3.0 and first["bench_server"] is True and first["load_ms"] == 12.5
+    assert second["n"] == 4
+    assert not any(args[:2] == ("shell", "am") for args in calls)
+    # Already running: no binary push, one forward for both candidates
+    assert not any(REMOTE_BIN in " ".join(args) for args in calls)
+    assert sum(args[:1] == ("forward",) for args in calls) == 1
+    cmds = [r["cmd"] for r in fake_server.requests]
+    assert cmds.count("load") == 2 and cmds.count("unload") == 2
+    assert fake_server.requests[cmds.index("load")]["powersave"] == 2
+
+
+def test_server_run_forwards_batch_settings(tmp_path, fake_server, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, bench_server=True, batch=8, batch_workers=3, poll_interval_sec=0.0)
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        if args == ("get-state",):
+            return "device\n"
+        if args[:1] == ("forward",):
+            return f"{fake_server.port}\n"
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    monkeypatch.setattr(bench.server, "adb", fake_adb)
+    bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+
+    req = next(r for r in fake_server.requests if r["cmd"] == "bench")
+    assert req["batch"] == 8 and req["batch_workers"] == 3
+
+
+def test_server_is_pushed_and_started_when_not_running(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, bench_server=True, poll_interval_sec=0.0, bench_server_port=7711)
+    bench = AndroidAppBench(ToolsConfig(bench_server_local="bin/xtrim_bench_server"), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    started = {}
+    calls = []
+
+    # Reserve a port, then release it so the first ping is refused
+    probe = _FakeServer()
+    port = probe.port
+    probe.stop()
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args == ("get-state",):
+            return "device\n"
+        if args[:1] == ("forward",):
+            return f"{port}\n"
+        if args[:1] == ("shell",) and args[1].startswith("nohup"):
+            started["srv"] = _FakeServer(port)
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    monkeypatch.setattr(bench.server, "adb", fake_adb)
+    try:
+        out = bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+    finally:
+        if "srv" in started:
+            started["srv"].stop()
+
+    assert out["avg_ms"] == 3.0
+    assert ("push", "bin/xtrim_bench_server", REMOTE_BIN) in calls
+    assert ("forward", "tcp:0", "tcp:7711") in calls
+    launch = next(args for args in calls if args[:1] == ("shell",) and args[1].startswith("nohup"))
+    assert f"{REMOTE_BIN} --port 7711" in launch[1]
+
+
+def test_seg_task_goes_through_the_app_with_seg_extras(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, bench_server=True, task="seg", seg_masks="coarse", poll_interval_sec=0.0)
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    calls = []
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args == ("get-state",):
+            return "device\n"
+        if args[:2] == ("logcat", "-d"):
+            return f'I/XTRIM: {cfg.result_tag} {{"ok": true, "task": "seg", "avg_ms": 9.0}}\n'
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    monkeypatch.setattr(bench.server, "client", lambda _dev: pytest.fail("seg must not use the bench server"))
+
+    assert not bench.uses_bench_server
+    out = bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+
+    assert out["task"] == "seg"
+    am = next(args for args in calls if args[:2] == ("shell", "am") and "start" in args)
+    assert am[am.index("task") + 1] == "seg"
+    assert am[am.index("seg_masks") + 1] == "coarse"
+
+
+def test_tiled_run_goes_through_the_app_with_tile_extras(tmp_path, monkeypatch):
+    cfg = AndroidAppBenchConfig(enabled=True, bench_server=True, tile=640, tile_workers=3, poll_interval_sec=0.0)
+    bench = AndroidAppBench(ToolsConfig(), cfg)
+    dev = DeviceConfig(name="phone", serial="s", cooling_down=0)
+    calls = []
+
+    def fake_adb(_serial: str, *args: str) -> str:
+        calls.append(args)
+        if args == ("get-state",):
+            return "device\n"
+        if args[:2] == ("logcat", "-d"):
+            return f'I/XTRIM: {cfg.result_tag} {{"ok": true, "tile": 640, "avg_ms": 40.0}}\n'
+        return ""
+
+    monkeypatch.setattr(bench, "adb", fake_adb)
+    monkeypatch.setattr(bench.server, "client", lambda _dev: pytest.fail("tiled runs must not use the bench server"))
+
+    assert not bench.uses_bench_server
+    out = bench.run_once(device=dev, local_param=tmp_path / "m.param", local_bin=tmp_path / "m.bin")
+
+    assert out["tile"] == 640
+    am = next(args for args in calls if args[:2] == ("shell", "am") and "start" in args)
+    assert am[am.index("tile") + 1] == "640"
+    assert am[am.index("tile_workers") + 1] == "3"
+    assert am[am.index("tile_full") + 1] == "true"
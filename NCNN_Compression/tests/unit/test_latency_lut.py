@@ -56,3 +56,75 @@ def test_estimate_model_latency_reports_hits(tmp_path):
 def test_latency_penalty_only_applies_to_excess():
     assert latency_penalty(8.0, budget_ms=10.0, lambda_lat=0.5) == 0.0
     assert latency_penalty(12.0, budget_ms=10.0, lambda_lat=0.5) == 1.0
+
+
+def _write_entries(tmp_path, entries):
+    p = tmp_path / "grid.json"
+    p.write_text(json.dumps({"device": "phone", "entries": entries}), encoding="utf-8")
+    return p
+
+
+def test_lookup_interpolates_in_log_space_between_grid_points(tmp_path):
+    def lat(cin, cout, s):
+        # per-MAC cost falls as a power of cin: log-linear, so interpolation is exact
+        return cin * cout * s * s * 1e-5 * (cin / 16) ** -0.5
+
+    entries = [
+        {"op": "conv1x1", "cin": ci, "cout": co, "k": 1, "stride": 1, "h": s, "w": s, "groups": 1,
+         "latency_ms": lat(ci, co, s)}
+        for ci in (16, 32) for co in (16, 32) for s in (20, 40)
+    ]
+    lut = LatencyLUT(_write_entries(tmp_path, entries), verbose=False)
+
+    assert lut.lookup("conv1x1", 24, 20, 1, 1, 30, 30) == pytest.approx(lat(24, 20, 30))
+    # Beyond the sweep the edge efficiency is held and the MACs scale
+    assert lut.lookup("conv1x1", 64, 32, 1, 1, 40, 40) == pytest.approx(lat(32, 32, 40) * 2)
+
+
+def test_lookup_handles_sparse_sweeps_depthwise_and_lowrank(tmp_path):
+    entries = [
+        # cin/cout within 2x only, as the op profiler sweeps them
+        {"op": "conv3x3", "cin": 16, "cout": 16, "k": 3, "stride": 1, "h": 20, "w": 20, "groups": 1, "latency_ms": 1.0},
+        {"op": "conv3x3", "cin": 64, "cout": 64, "k": 3, "stride": 1, "h": 20, "w": 20, "groups": 1, "latency_ms": 16.0},
+        {"op": "conv2d_dw", "cin": 32, "cout": 32, "k": 3, "stride": 1, "h": 20, "w": 20, "groups": 32, "latency_ms": 0.1},
+        {"op": "conv1x1", "cin": 8, "cout": 64, "k": 1, "stride": 1, "h": 20, "w": 20, "groups": 1, "latency_ms": 0.5},
+        {"op": "lowrank3x3", "cin": 64, "cout": 64, "k": 3, "stride": 1, "h": 20, "w": 20, "groups": 1,
+         "rank": 16, "latency_ms": 3.0},
+    ]
+    lut = LatencyLUT(_write_entries(tmp_path, entries), verbose=False)
+
+    assert lut.lookup("conv3x3", 16, 64, 3, 1, 20, 20) == pytest.approx(4.0)
+    assert lut.lookup("conv2d_dw", 64, 64, 3, 1, 20, 20, groups=64) == pytest.approx(0.2)
+    assert lut.lookup("conv3x3_d2", 64, 64, 3, 1, 20, 20) == pytest.approx(16.0)
+    assert lut.lookup("lowrank3x3", 64, 64, 3, 1, 20, 20, rank=16) == 3.0
+    # No lowrank1x1 sweep: priced as the two convs it runs as
+    assert lut.lookup("lowrank1x1", 64, 64, 1, 1, 20, 20, rank=8) == pytest.approx(1.0)
+    assert lut.lookup("lowrank5x5", 64, 64, 5, 1, 20, 20, rank=8) is None
+    assert lut.lookup_with_fallback("lowrank5x5", 64, 64, 5, 1, 10, 10, macs_per_ms=2.0, rank=8) == pytest.approx(
+        2 * 8 * (64 * 25 + 64) * 100 / 2.0
+    )
+
+
+def test_dilated_fallback_only_matches_dilated_conv_names(tmp_path, monkeypatch):
+    lut = LatencyLUT(_lut_file(tmp_path), verbose=False)
+    calls = []
+    real = lut._lookup
+    monkeypatch.setattr(lut, "_lookup", lambda *sig: calls.append(sig[0]) or real(*sig))
+
+    assert lut.lookup("conv3x3_d2", 3, 8, 3, 1, 16, 16, 1) == 1.0
+    assert calls == ["conv3x3_d2", "conv3x3"]
+    # Unprofiled depthwise is a miss, not a lookup of "conv2"
+    calls.clear()
+    assert lut.lookup("conv2d_dw", 8, 8, 3, 1, 16, 16, 8) is None
+    assert calls == ["conv2d_dw"]
+
+
+def test_lookup_memoizes_by_layer_signature(tmp_path, monkeypatch):
+    lut = LatencyLUT(_lut_file(tmp_path), verbose=False)
+    calls = []
+    real = lut._lookup
+    monkeypatch.setattr(lut, "_lookup", lambda *sig: calls.append(sig) or real(*sig))
+
+    first = lut.lookup("conv3x3", 3, 16, 3, 1, 16, 16, 1)
+    assert lut.lookup("conv3x3", 3, 16, 3, 1, 16, 16, 1) == first
+    assert len(calls) == 1
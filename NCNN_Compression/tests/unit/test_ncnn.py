@@ -4,8 +4,14 @@ from pathlib import Path
 
 import pytest
 
-from xtrim.ncnn import AdbBench, NcnnConverter, _normalize_shape_arg, _validate_ncnn_param
-from xtrim.types import DeviceConfig, NcnnModelPaths, ToolsConfig
+from xtrim.ncnn import (
+    AdbBench,
+    NcnnConverter,
+    _normalize_shape_arg,
+    _validate_ncnn_param,
+    append_yolo_detection_output,
+)
+from xtrim.types import DeviceConfig, ExportConfig, NcnnModelPaths, ToolsConfig
 
 
 pytestmark = pytest.mark.unit
@@ -75,3 +81,50 @@ def test_adb_bench_parses_average_latency(monkeypatch):
 
     assert avg == 2.5
     assert "avg = 2.5" in raw
+
+
+def _head_param() -> str:
+    return (
+        "7767517\n"
+        "3 3\n"
+        "Input                    in0                      0 1 in0\n"
+        "Convolution              conv                     1 1 in0 feat 0=84\n"
+        "Reshape                  reshape                  1 1 feat out0 0=-1 1=84\n"
+    )
+
+
+def test_append_yolo_detection_output_renames_head_and_bumps_counts(tmp_path):
+    out = append_yolo_detection_output(_head_param(), num_class=80, conf_thresh=0.3, max_det=100)
+    lines = out.splitlines()
+
+    assert lines[1] == "4 4"
+    assert lines[4].split()[4:6] == ["feat", "out0_raw"]
+    det = lines[-1].split()
+    assert det[:6] == ["YoloV8DetectionOutput", "detout", "1", "1", "out0_raw", "out0"]
+    assert det[6:] == ["0=80", "1=0.3", "2=0.45", "3=100", "4=0"]
+
+    p = tmp_path / "detout.param"
+    p.write_text(out, encoding="utf-8")
+    _validate_ncnn_param(p)
+
+
+def test_append_yolo_detection_output_is_idempotent_and_checks_blob():
+    once = append_yolo_detection_output(_head_param())
+    assert append_yolo_detection_output(once) == once
+
+    with pytest.raises(RuntimeError, match="no layer producing"):
+        append_yolo_detection_output(_head_param(), output_blob="output0")
+
+
+def test_append_detection_output_copies_bin(tmp_path):
+    param = tmp_path / "m.param"
+    bin_ = tmp_path / "m.bin"
+    param.write_text(_head_param(), encoding="utf-8")
+    bin_.write_bytes(b"weights")
+
+    out = NcnnConverter(ToolsConfig()).append_detection_output(
+        NcnnModelPaths(param, bin_), tmp_path / "detout", ExportConfig(det_mask_dim=32)
+    )
+
+    assert out.bin.read_bytes() == b"weights"
+    assert out.param.read_text(encoding="utf-8").splitlines()[-1].endswith("4=32")
@@ -0,0 +1,168 @@
+from __future__ import annotations
+
+import numpy as np
+import pytest
+
+from xtrim.ncnn_passes import fuse_lowrank_convs, format_param, parse_param, sparsify_1x1_convs, weight_spans
+
+
+pytestmark = pytest.mark.unit
+
+
+def _conv_bin(w: np.ndarray, bias: np.ndarray | None = None, fp16: bool = False) -> bytes:
+    if fp16:
+        blob = (0x01306B47).to_bytes(4, "little") + w.astype("<f2").tobytes()
+        blob += b"\0" * ((-len(blob)) % 4)
+    else:
+        blob = b"\0\0\0\0" + w.astype("<f4").tobytes()
+    if bias is not None:
+        blob += bias.astype("<f4").tobytes()
+    return blob
+
+
+def _model(w: np.ndarray, bias: np.ndarray, extra: str = "", fp16: bool = False):
+    out_c, in_c = w.shape
+    param = (
+        "7767517\n"
+        "4 4\n"
+        "Input                    in0                      0 1 in0\n"
+        f"Convolution              conv0                    1 1 in0 c0 0={in_c} 1=3 4=1 5=1 6={in_c * 3 * 3 * 3}\n"
+        f"Convolution              conv1                    1 1 c0 c1 0={out_c} 1=1 5=1 6={w.size}{extra}\n"
+        "Swish                    act                      1 1 c1 out0\n"
+    )
+    dense3x3 = np.ones(in_c * 27, dtype=np.float32)
+    bin_bytes = _conv_bin(dense3x3, np.zeros(in_c)) + _conv_bin(w, bias, fp16=fp16)
+    return param, bin_bytes
+
+
+def _sparse_weights(out_c: int = 32, in_c: int = 16, keep: float = 0.2) -> np.ndarray:
+    rng = np.random.default_rng(0)
+    w = rng.standard_normal((out_c, in_c)).astype(np.float32)
+    w[rng.random(w.shape) > keep] = 0.0
+    return w
+
+
+def test_parse_and_format_param_roundtrip_keeps_array_params():
+    text = (
+        "7767517\n2 2\n"
+        "Input                    in0                      0 1 in0\n"
+        "Convolution              conv                     1 1 in0 out0 0=8 1=1 6=64 9=2 -23310=1,1.000000e-01\n"
+    )
+    layers, n_blobs = parse_param(text)
+
+    assert n_blobs == 2
+    assert layers[1].params[-23310] == "1,1.000000e-01"
+    assert parse_param(format_param(layers, n_blobs))[0] == layers
+
+
+def test_weight_spans_walks_tagged_and_raw_blobs():
+    w = _sparse_weights()
+    param, bin_bytes = _model(w, np.arange(32, dtype=np.float32))
+    layers, _ = parse_param(param)
+
+    spans = weight_spans(layers, bin_bytes)
+
+    assert spans[0] == (0, 0)
+    assert spans[1] == (0, 4 + 16 * 27 * 4 + 16 * 4)
+    assert spans[2][1] == 4 + w.size * 4 + 32 * 4
+    assert spans[3][1] == 0
+
+
+def test_sparsify_1x1_converts_sparse_conv_to_csr():
+    w = _sparse_weights()
+    bias = np.arange(32, dtype=np.float32)
+    param, bin_bytes = _model(w, bias, extra=" 9=1")
+
+    new_param, new_bin, report = sparsify_1x1_convs(param, bin_bytes, max_density=0.35)
+
+    assert report["converted"] == 1
+    layers, _ = parse_param(new_param)
+    sp = layers[2]
+    assert sp.type == "SparseConvolution1x1"
+    nnz = int((w != 0).sum())
+    assert sp.params == {0: "32", 1: "16", 2: str(nnz), 5: "1", 9: "1"}
+    assert [l.type for l in layers[:2]] == ["Input", "Convolution"]
+
+    off = weight_spans(layers, new_bin)[2][0]
+    row_ptr = np.frombuffer(new_bin, "<i4", 33, off)
+    cols = np.frombuffer(new_bin, "<i4", nnz, off + 33 * 4)
+    vals = np.frombuffer(new_bin, "<f4", nnz, off + 33 * 4 + nnz * 4)
+    tail = np.frombuffer(new_bin, "<f4", 32, off + 33 * 4 + nnz * 8)
+
+    dense = np.zeros_like(w)
+    for r in range(32):
+        for k in range(row_ptr[r], row_ptr[r + 1]):
+            dense[r, cols[k]] = vals[k]
+    np.testing.assert_array_equal(dense, w)
+    np.testing.assert_array_equal(tail, bias)
+
+
+def test_sparsify_1x1_reads_fp16_weights():
+    w = _sparse_weights().astype(np.float16).astype(np.float32)
+    param, bin_bytes = _model(w, np.zeros(32, dtype=np.float32), fp16=True)
+
+    _, _, report = sparsify_1x1_convs(param, bin_bytes)
+
+    assert report["converted"] == 1
+
+
+def test_sparsify_1x1_keeps_dense_and_unknown_models():
+    dense = np.ones((32, 16), dtype=np.float32)
+    param, bin_bytes = _model(dense, np.zeros(32, dtype=np.float32))
+    out = sparsify_1x1_convs(param, bin_bytes)
+    assert out[:2] == (param, bin_bytes)
+    assert out[2]["eligible"] == 1 and out[2]["converted"] == 0
+
+    param2, bin2 = _model(_sparse_weights(), np.zeros(32, dtype=np.float32))
+    param2 = param2.replace("Swish                    act", "LayerNorm                act")
+    out2 = sparsify_1x1_convs(param2, bin2)
+    assert out2[:2] == (param2, bin2)
+    assert "LayerNorm" in out2[2]["skipped"]
+
+
+def _lowrank_model(rank: int = 4, in_c: int = 16, out_c: int = 32, bias_u: bool = False):
+    rng = np.random.default_rng(1)
+    u = rng.standard_normal((rank, in_c, 3, 3)).astype(np.float32)
+    v = rng.standard_normal((out_c, rank)).astype(np.float32)
+    bu = rng.standard_normal(rank).astype(np.float32)
+    bv = rng.standard_normal(out_c).astype(np.float32)
+    param = (
+        "7767517\n"
+        "4 4\n"
+        "Input                    in0                      0 1 in0\n"
+        f"Convolution              lr_u                     1 1 in0 mid 0={rank} 1=3 3=2 4=1 5={int(bias_u)} 6={u.size}\n"
+        f"Convolution              lr_v                     1 1 mid c1 0={out_c} 1=1 5=1 6={v.size}\n"
+        "Swish                    act                      1 1 c1 out0\n"
+    )
+    bin_bytes = _conv_bin(u.ravel(), bu if bias_u else None) + _conv_bin(v.ravel(), bv)
+    return param, bin_bytes, u, v, bu, bv
+
+
+def test_fuse_lowrank_replaces_pair_and_folds_bias():
+    param, bin_bytes, u, v, bu, bv = _lowrank_model(bias_u=True)
+
+    new_param, new_bin, report = fuse_lowrank_convs(param, bin_bytes)
+
+    assert report["fused"] == 1
+    layers, n_blobs = parse_param(new_param)
+    assert n_blobs == 3
+    assert [l.type for l in layers] == ["Input", "LowRankConvolution", "Swish"]
+    fused = layers[1]
+    assert (fused.bottoms, fused.tops) == (["in0"], ["c1"])
+    assert fused.params == {0: "32", 1: "3", 3: "2", 4: "1", 5: "1", 20: "4", 21: "16"}
+
+    got = np.frombuffer(new_bin, "<f4")
+    np.testing.assert_array_equal(got[:u.size], u.ravel())
+    np.testing.assert_array_equal(got[u.size:u.size + v.size], v.ravel())
+    np.testing.assert_allclose(got[u.size + v.size:], bv + v @ bu, rtol=1e-6)
+    assert weight_spans(layers, new_bin)[1] == (0, len(new_bin))
+
+
+def test_fuse_lowrank_skips_shared_intermediate_and_full_rank():
+    param, bin_bytes, *_ = _lowrank_model()
+    shared = param.replace("4 4\n", "5 5\n") + "Sigmoid                  tap                      1 1 mid tap0\n"
+    out = fuse_lowrank_convs(shared, bin_bytes)
+    assert out[:2] == (shared, bin_bytes) and out[2]["fused"] == 0
+
+    param, bin_bytes, *_ = _lowrank_model(rank=32, out_c=32)
+    assert fuse_lowrank_convs(param, bin_bytes)[2]["fused"] == 0
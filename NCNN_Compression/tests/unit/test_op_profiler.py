@@ -0,0 +1,93 @@
+from __future__ import annotations
+
+import json
+from pathlib import Path
+
+import pytest
+
+from xtrim.latency_lut import LatencyLUT
+from xtrim.op_profiler import REMOTE_OUT, OpProfiler, OpSweep, profiler_args
+from xtrim.types import DeviceConfig, ToolsConfig
+
+
+pytestmark = pytest.mark.unit
+
+
+_LUT = {
+    "device": "phone",
+    "unit": "ms",
+    "source": "xtrim_op_profiler",
+    "entries": [
+        {"op": "conv3x3", "cin": 16, "cout": 32, "k": 3, "stride": 2, "h": 20, "w": 20, "groups": 1,
+         "dilation": 1, "latency_ms": 0.42, "min_ms": 0.40},
+        {"op": "lowrank3x3", "cin": 32, "cout": 32, "k": 3, "stride": 1, "h": 20, "w": 20, "groups": 1,
+         "dilation": 1, "rank": 8, "latency_ms": 0.2, "min_ms": 0.19},
+    ],
+}
+
+
+def test_profiler_args_serializes_sweep():
+    sweep = OpSweep(ops=["conv1x1", "dw3x3_s2"], channels=[16, 32], sizes=[20], ranks=[8], loops=7)
+
+    args = profiler_args(sweep, out="o.json", device_name="pixel", threads=2, powersave=2)
+
+    assert args[args.index("--ops") + 1] == "conv1x1,dw3x3_s2"
+    assert args[args.index("--channels") + 1] == "16,32"
+    assert args[args.index("--loops") + 1] == "7"
+    assert args[args.index("--threads") + 1] == "2"
+    assert args[args.index("--powersave") + 1] == "2"
+
+
+def test_run_local_writes_lut_loadable_by_latency_lut(tmp_path, monkeypatch):
+    exe = tmp_path / "xtrim_op_profiler"
+    exe.write_text("", encoding="utf-8")
+    calls = []
+
+    def fake_sh(cmd):
+        calls.append(cmd)
+        Path(cmd[cmd.index("--out") + 1]).write_text(json.dumps(_LUT), encoding="utf-8")
+        return ""
+
+    monkeypatch.setattr("xtrim.op_profiler.sh", fake_sh)
+    out = tmp_path / "lut" / "host.json"
+    data = OpProfiler(ToolsConfig()).run_local(out, binary=str(exe))
+
+    assert calls[0][0] == str(exe)
+    assert data["entries"][0]["latency_ms"] == 0.42
+    lut = LatencyLUT(out, verbose=False)
+    assert lut.lookup("conv3x3", 16, 32, 3, 2, 20, 20, 1) == 0.42
+
+
+def test_run_on_device_pushes_runs_and_pulls(tmp_path, monkeypatch):
+    exe = tmp_path / "xtrim_op_profiler"
+    exe.write_text("", encoding="utf-8")
+    prof = OpProfiler(ToolsConfig(op_profiler_local=str(exe)))
+    calls = []
+
+    def fake_adb(_serial, *args):
+        calls.append(args)
+        if args[0] == "pull":
+            Path(args[2]).write_text(json.dumps(_LUT), encoding="utf-8")
+        return ""
+
+    monkeypatch.setattr(prof, "adb", fake_adb)
+    data = prof.run_on_device(DeviceConfig(name="phone", serial="s", threads=2), tmp_path / "phone.json")
+
+    assert calls[0][0] == "push"
+    run = next(c for c in calls if c[0] == "shell" and "--out" in c[1])
+    assert f"--out {REMOTE_OUT}" in run[1] and "--device phone" in run[1] and "--threads 2" in run[1]
+    assert data["device"] == "phone"
+
+
+def test_run_local_rejects_missing_binary_and_empty_lut(tmp_path, monkeypatch):
+    with pytest.raises(RuntimeError, match="not found"):
+        OpProfiler(ToolsConfig()).run_local(tmp_path / "x.json", binary=str(tmp_path / "missing"))
+
+    exe = tmp_path / "bin"
+    exe.write_text("", encoding="utf-8")
+    monkeypatch.setattr(
+        "xtrim.op_profiler.sh",
+        lambda cmd: Path(cmd[cmd.index("--out") + 1]).write_text('{"entries": []}', encoding="utf-8"),
+    )
+    with pytest.raises(RuntimeError, match="no LUT entries"):
+        OpProfiler(ToolsConfig()).run_local(tmp_path / "x.json", binary=str(exe))
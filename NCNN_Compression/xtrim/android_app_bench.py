@@ -8,6 +8,8 @@ import uuid
 from pathlib import Path
 from typing import Optional, List, Tuple
 
+from .android_dataset import dataset_subset_hash
+from .bench_server import AndroidBenchServer
 from .types import DeviceConfig, ToolsConfig, AndroidAppBenchConfig
 
 
@@ -29,10 +31,16 @@ class AndroidAppBench:
     def __init__(self, tools: ToolsConfig, cfg: AndroidAppBenchConfig):
         self.tools = tools
         self.cfg = cfg
+        self.server = AndroidBenchServer(tools, cfg)
 
     def adb(self, serial: str, *args: str) -> str:
         return sh([self.tools.adb, "-s", serial, *args])
 
+    @property
+    def uses_bench_server(self) -> bool:
+        cfg = self.cfg
+        return bool(cfg.bench_server) and not cfg.eval_map and cfg.task == "detect" and int(cfg.tile) <= 0
+
     def is_device_ready(self, device: DeviceConfig) -> bool:
         try:
             return self.adb(device.serial, "get-state").strip() == "device"
@@ -79,6 +87,21 @@ class AndroidAppBench:
             pass
         return remote_images_dir, remote_image_list
 
+    def prepare_tensor_cache(self, device: DeviceConfig, local_images_dir: Path) -> List[str]:
+        """Create the shared cache dir on the device and return the am extras for it."""
+        rcache = f"{self.cfg.remote_dir.rstrip('/')}/{self.cfg.tensor_cache_subdir.strip('/')}"
+        self.adb(device.serial, "shell", "mkdir", "-p", rcache)
+        try:
+            # The app writes here, /data/local/tmp is shell-owned.
+            self.adb(device.serial, "shell", f"chmod 777 {rcache}")
+        except Exception as e:
+            print(e)
+        return [
+            "--ez", "tensor_cache", "true",
+            "--es", "tensor_cache_dir", rcache,
+            "--es", "dataset_key", dataset_subset_hash(local_images_dir),
+        ]
+
     def force_stop(self, device: DeviceConfig) -> None:
         try:
             self.adb(device.serial, "shell", "am", "force-stop", self.cfg.package)
@@ -105,6 +128,37 @@ class AndroidAppBench:
                 found.append(obj)
         return found[-1] if found else None
 
+    def run_on_server(self, *, device: DeviceConfig, local_param: Path, local_bin: Path, run_id: str) -> dict:
+        """Bench on the resident xtrim_bench_server: no app restart, no asset reload."""
+        cfg = self.cfg
+        client = self.server.client(device)
+        if device.cooling_down > 0:
+            time.sleep(float(device.cooling_down))
+
+        rparam, rbin = self.push_model(device, local_param, local_bin)
+        loaded = client.load(
+            rparam,
+            rbin,
+            imgsz=cfg.imgsz,
+            threads=cfg.threads,
+            optimized=cfg.optimized,
+            fast_swish=cfg.fast_swish,
+            powersave=device.powersave,
+        )
+        try:
+            data = client.bench(
+                loops=cfg.loops,
+                warmup=cfg.warmup,
+                run_id=run_id,
+                batch=cfg.batch,
+                batch_workers=cfg.batch_workers,
+            )
+        finally:
+            client.unload()
+        data["bench_server"] = True
+        data["load_ms"] = loaded.get("load_ms")
+        return data
+
     def run_once(
         self,
         *,
@@ -126,6 +180,9 @@ class AndroidAppBench:
 
         run_id = uuid.uuid4().hex[:10]
 
+        if self.uses_bench_server:
+            return self.run_on_server(device=device, local_param=local_param, local_bin=local_bin, run_id=run_id)
+
         self.force_stop(device)
         if device.cooling_down > 0:
             time.sleep(float(device.cooling_down))
@@ -149,6 +206,8 @@ class AndroidAppBench:
                 "--es", "image_list", rlist,
                 "--ei", "image_count", str(int(dataset_image_count)),
             ]
+            if cfg.tensor_cache:
+                pushed_image_args += self.prepare_tensor_cache(device, local_images_dir)
 
         if cfg.clear_logcat:
             self.clear_logcat(device)
@@ -165,10 +224,22 @@ class AndroidAppBench:
             "--ei", "warmup", str(int(cfg.warmup)),
             "--ei", "threads", str(int(cfg.threads)),
             "--ei", "max_det", str(int(cfg.max_det)),
+            "--ei", "batch", str(int(cfg.batch)),
+            "--ei", "batch_workers", str(int(cfg.batch_workers)),
+            "--ez", "eval_map", "true" if cfg.eval_map else "false",
+            "--ef", "eval_conf", str(float(cfg.eval_conf)),
+            "--ei", "num_classes", str(int(cfg.num_classes)),
             *pushed_image_args,
             "--ef", "conf", str(float(cfg.conf)),
             "--ef", "iou", str(float(cfg.iou)),
             "--ez", "optimized", "true" if cfg.optimized else "false",
+            "--ez", "fast_swish", "true" if cfg.fast_swish else "false",
+            "--es", "task", str(cfg.task),
+            "--es", "seg_masks", str(cfg.seg_masks),
+            "--ei", "tile", str(int(cfg.tile)),
+            "--ef", "tile_overlap", str(float(cfg.tile_overlap)),
+            "--ei", "tile_workers", str(int(cfg.tile_workers)),
+            "--ez", "tile_full", "true" if cfg.tile_full else "false",
         ]
         _ = self.adb(device.serial, *am_cmd)
 
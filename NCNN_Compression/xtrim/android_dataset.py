@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+import hashlib
 import shutil
 from dataclasses import dataclass
 from pathlib import Path
@@ -13,7 +14,9 @@ from .utils import ensure_dir
 class AndroidDatasetSubset:
     """Local dataset subset prepared for Android latency benchmarking.
 
-    local_dir contains copied image files with stable short names.
+    local_dir contains copied image files with stable short names, plus YOLO
+    label files with the same stem when the dataset has them (used by the
+    on-device mAP evaluator).
     local_list contains remote Android paths, i.e. paths after adb push.
     """
 
@@ -22,6 +25,31 @@ class AndroidDatasetSubset:
     remote_dir: str
     remote_list: str
     count: int
+    labels: int = 0
+
+
+def _label_path_for(img: Path) -> Path:
+    """YOLO convention: .../images/<name>.jpg -> .../labels/<name>.txt."""
+    parts = list(img.parts)
+    for i in range(len(parts) - 1, -1, -1):
+        if parts[i] == "images":
+            parts[i] = "labels"
+            return Path(*parts).with_suffix(".txt")
+    return img.with_suffix(".txt")
+
+
+def dataset_subset_hash(local_dir: Path) -> str:
+    """Content hash of a prepared subset (file names + bytes, labels included).
+
+    Used as the key of the on-device tensor cache, so a cache built for one
+    subset is never served for another.
+    """
+    h = hashlib.sha1()
+    for p in sorted(Path(local_dir).iterdir()):
+        if p.is_file():
+            h.update(p.name.encode("utf-8"))
+            h.update(p.read_bytes())
+    return h.hexdigest()[:16]
 
 
 def _safe_remote_dir(remote_dir: str, subdir: str) -> str:
@@ -73,6 +101,7 @@ def prepare_android_dataset_subset(
 
     rdir = _safe_remote_dir(remote_dir, remote_subdir)
     remote_paths: List[str] = []
+    n_labels = 0
 
     for i, src in enumerate(src_paths):
         if not src.exists():
@@ -82,6 +111,11 @@ def prepare_android_dataset_subset(
         shutil.copy2(src, dst)
         remote_paths.append(f"{rdir}/{dst.name}")
 
+        label = _label_path_for(src)
+        if label.is_file():
+            shutil.copy2(label, local_dir / f"{i:06d}.txt")
+            n_labels += 1
+
     local_list = out_dir / "image_list_remote.txt"
     local_list.write_text("\n".join(remote_paths) + "\n", encoding="utf-8")
 
@@ -91,4 +125,5 @@ def prepare_android_dataset_subset(
         remote_dir=rdir,
         remote_list=f"{rdir}/image_list.txt",
         count=len(remote_paths),
+        labels=n_labels,
     )
@@ -0,0 +1,195 @@
+from __future__ import annotations
+
+"""Client for android_native/bench_server (xtrim_bench_server).
+
+The server keeps one process alive on the phone and loads/benches/unloads
+models on request, so a candidate costs a model load instead of a cold app
+start. It speaks newline-delimited JSON over TCP; on a device it is reached
+through `adb forward`, on Linux it can be run and queried directly."""
+
+import json
+import socket
+import time
+from typing import Any, Callable, Dict, Optional
+
+from .types import AndroidAppBenchConfig, DeviceConfig, ToolsConfig
+from .utils import sh
+
+REMOTE_BIN = "/data/local/tmp/xtrim_bench_server"
+REMOTE_LOG = "/data/local/tmp/xtrim_bench_server.log"
+
+
+class BenchServerError(RuntimeError):
+    pass
+
+
+class BenchServerClient:
+    def __init__(self, host: str = "127.0.0.1", port: int = 7700, timeout: float = 180.0):
+        self.host = host
+        self.port = int(port)
+        self.timeout = float(timeout)
+        self._sock: Optional[socket.socket] = None
+        self._buf = b""
+
+    def connect(self) -> "BenchServerClient":
+        if self._sock is None:
+            self._sock = socket.create_connection((self.host, self.port), timeout=self.timeout)
+            self._buf = b""
+        return self
+
+    def close(self) -> None:
+        if self._sock is not None:
+            try:
+                self._sock.close()
+            finally:
+                self._sock = None
+
+    def __enter__(self) -> "BenchServerClient":
+        return self.connect()
+
+    def __exit__(self, *_exc) -> None:
+        self.close()
+
+    def _read_line(self) -> str:
+        assert self._sock is not None
+        while b"\n" not in self._buf:
+            chunk = self._sock.recv(65536)
+            if not chunk:
+                raise BenchServerError(f"bench server {self.host}:{self.port} closed the connection")
+            self._buf += chunk
+        line, self._buf = self._buf.split(b"\n", 1)
+        return line.decode("utf-8")
+
+    def request(
+        self,
+        cmd: str,
+        *,
+        on_progress: Optional[Callable[[Dict[str, Any]], None]] = None,
+        **fields: Any,
+    ) -> Dict[str, Any]:
+        self.connect()
+        assert self._sock is not None
+        try:
+            self._sock.sendall((json.dumps({"cmd": cmd, **fields}) + "\n").encode("utf-8"))
+            while True:
+                msg = json.loads(self._read_line())
+                if msg.get("event") == "progress":
+                    if on_progress is not None:
+                        on_progress(msg)
+                    continue
+                break
+        except (OSError, ValueError) as e:
+            self.close()
+            raise BenchServerError(f"bench server {self.host}:{self.port}: {cmd} failed: {e}") from e
+        if not msg.get("ok", False):
+            raise BenchServerError(f"bench server {cmd} failed: {msg.get('error', msg)}")
+        return msg
+
+    def ping(self) -> Dict[str, Any]:
+        return self.request("ping")
+
+    def load(
+        self,
+        param: str,
+        bin: str,
+        *,
+        imgsz: int,
+        threads: int,
+        optimized: bool = True,
+        fast_swish: bool = False,
+        powersave: int = 0,
+    ) -> Dict[str, Any]:
+        return self.request(
+            "load",
+            param=param,
+            bin=bin,
+            imgsz=int(imgsz),
+            threads=int(threads),
+            optimized=bool(optimized),
+            fast_swish=bool(fast_swish),
+            powersave=int(powersave),
+        )
+
+    def bench(
+        self,
+        *,
+        loops: int,
+        warmup: int,
+        run_id: str = "",
+        batch: int = 1,
+        batch_workers: int = 2,
+        on_progress: Optional[Callable[[Dict[str, Any]], None]] = None,
+    ) -> Dict[str, Any]:
+        """batch > 1 letterboxes `batch` frames per step on `batch_workers` threads,
+        overlapped with the forwards; times stay per image."""
+        return self.request(
+            "bench",
+            loops=int(loops),
+            warmup=int(warmup),
+            run_id=run_id,
+            batch=int(batch),
+            batch_workers=int(batch_workers),
+            progress=on_progress is not None,
+            on_progress=on_progress,
+        )
+
+    def unload(self) -> Dict[str, Any]:
+        return self.request("unload")
+
+    def shutdown(self) -> None:
+        try:
+            self.request("shutdown")
+        finally:
+            self.close()
+
+
+class AndroidBenchServer:
+    """Starts xtrim_bench_server on each device once and keeps a client per serial."""
+
+    def __init__(self, tools: ToolsConfig, cfg: AndroidAppBenchConfig):
+        self.tools = tools
+        self.cfg = cfg
+        self._clients: Dict[str, BenchServerClient] = {}
+
+    def adb(self, serial: str, *args: str) -> str:
+        return sh([self.tools.adb, "-s", serial, *args])
+
+    def _try_ping(self, client: BenchServerClient) -> bool:
+        try:
+            client.ping()
+            return True
+        except (OSError, BenchServerError):
+            client.close()
+            return False
+
+    def client(self, device: DeviceConfig) -> BenchServerClient:
+        cached = self._clients.get(device.serial)
+        if cached is not None and self._try_ping(cached):
+            return cached
+
+        port = int(self.cfg.bench_server_port)
+        # tcp:0 lets adb pick a free host port, so several devices can be forwarded at once
+        local_port = int(self.adb(device.serial, "forward", "tcp:0", f"tcp:{port}").strip())
+        client = BenchServerClient("127.0.0.1", local_port, timeout=float(self.cfg.timeout_sec))
+        if not self._try_ping(client):
+            self.adb(device.serial, "push", self.tools.bench_server_local, REMOTE_BIN)
+            self.adb(device.serial, "shell", f"chmod 755 {REMOTE_BIN}")
+            self.adb(device.serial, "shell", f"nohup {REMOTE_BIN} --port {port} > {REMOTE_LOG} 2>&1 &")
+            t0 = time.time()
+            while not self._try_ping(client):
+                if time.time() - t0 > float(self.cfg.bench_server_start_timeout_sec):
+                    raise BenchServerError(
+                        f"[{device.name}] xtrim_bench_server did not come up on port {port} (see {REMOTE_LOG})"
+                    )
+                time.sleep(float(self.cfg.poll_interval_sec))
+
+        self._clients[device.serial] = client
+        return client
+
+    def stop(self, device: DeviceConfig) -> None:
+        client = self._clients.pop(device.serial, None)
+        if client is not None:
+            try:
+                client.shutdown()
+            except BenchServerError as e:
+                print(e)
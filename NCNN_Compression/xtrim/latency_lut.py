@@ -2,14 +2,94 @@ from __future__ import annotations
 
 """Legacy LUT latency estimator. It is kept for old experiments and tests."""
 
+import bisect
+import itertools
 import json
 import math
+import re
 from pathlib import Path
 from typing import Any, Dict, List, Optional, Tuple
 
 import torch
 import torch.nn as nn
 
+from .trim.lowrank import LowRankConv2d
+
+# Dilated convs as _get_op_type names them ("conv3x3_d2"), not e.g. "conv2d_dw"
+_DILATED_OP = re.compile(r"(conv\d+x\d+)_d\d+")
+
+
+def _log2(x: float) -> float:
+    return math.log2(max(float(x), 1.0))
+
+
+def _macs(op: str, cin: int, cout: int, k: int, h: int, w: int, groups: int, rank: int) -> float:
+    hw = max(h, 1) * max(w, 1)
+    if op.startswith("lowrank") and rank > 0:
+        return float(rank * (max(cin, 1) * k * k + max(cout, 1)) * hw)
+    return float(max(cin // max(groups, 1), 1) * max(cout, 1) * k * k * hw)
+
+
+class _Grid:
+    """Entries of one (op, k, stride, groups) group on log2 axes.
+
+    Axes are (cin, cout, h*w), (channels, h*w) for depthwise and
+    (cin, cout, rank, h*w) for low-rank pairs. Each point stores the log of
+    latency per MAC, so interpolating it multilinearly is the same as
+    interpolating log latency on a full grid, and corners missing from a sparse
+    sweep can be dropped with the weights renormalized.
+    """
+
+    def __init__(self) -> None:
+        self.points: Dict[Tuple[float, ...], float] = {}
+        self.axes: List[List[float]] = []
+
+    def add(self, coords: Tuple[float, ...], log_eff: float) -> None:
+        self.points[coords] = log_eff
+
+    def finalize(self) -> None:
+        dims = len(next(iter(self.points)))
+        self.axes = [sorted({c[d] for c in self.points}) for d in range(dims)]
+
+    @staticmethod
+    def _bracket(axis: List[float], x: float) -> Tuple[float, float, float]:
+        # Outside the measured range the edge value is held (efficiency is
+        # extrapolated flat, i.e. nearest-neighbour MAC scaling)
+        if x <= axis[0]:
+            return axis[0], axis[0], 0.0
+        if x >= axis[-1]:
+            return axis[-1], axis[-1], 0.0
+        i = bisect.bisect_left(axis, x)
+        if axis[i] == x:
+            return x, x, 0.0
+        lo, hi = axis[i - 1], axis[i]
+        return lo, hi, (x - lo) / (hi - lo)
+
+    def interpolate(self, coords: Tuple[float, ...]) -> Optional[float]:
+        brackets = [self._bracket(a, x) for a, x in zip(self.axes, coords)]
+        acc = 0.0
+        wsum = 0.0
+        for corner in itertools.product((0, 1), repeat=len(brackets)):
+            key = []
+            wt = 1.0
+            for (lo, hi, t), bit in zip(brackets, corner):
+                key.append(hi if bit else lo)
+                wt *= t if bit else 1.0 - t
+            if wt <= 0.0:
+                continue
+            v = self.points.get(tuple(key))
+            if v is None:
+                continue
+            acc += wt * v
+            wsum += wt
+        if wsum > 1e-9:
+            return acc / wsum
+        return self.nearest(coords)
+
+    def nearest(self, coords: Tuple[float, ...]) -> float:
+        best = min(self.points, key=lambda c: sum((a - b) ** 2 for a, b in zip(c, coords)))
+        return self.points[best]
+
 
 class LatencyLUT:
     def __init__(self, lut_path: str | Path, verbose: bool = True):
@@ -29,6 +109,20 @@ class LatencyLUT:
             key = self._entry_key(e)
             self._index[key] = float(e["latency_ms"])
 
+        self._grids: Dict[Tuple, _Grid] = {}
+        for key, v in self._index.items():
+            op, cin, cout, k, stride, h, w, groups, rank = key
+            if v <= 0.0:
+                continue
+            gkey, coords = self._grid_key(op, cin, cout, k, stride, h, w, groups, rank)
+            log_eff = math.log(v) - math.log(_macs(op, cin, cout, k, h, w, groups, rank))
+            self._grids.setdefault(gkey, _Grid()).add(coords, log_eff)
+        for g in self._grids.values():
+            g.finalize()
+
+        # Search loops query the same few layer shapes over and over
+        self._memo: Dict[Tuple, Optional[float]] = {}
+
         if verbose:
             print(
                 f"[LUT] Loaded {len(self._index)} entries "
@@ -46,11 +140,20 @@ class LatencyLUT:
             int(e.get("h", 0)),
             int(e.get("w", 0)),
             int(e.get("groups", 1)),
+            int(e.get("rank", 0)),
         )
 
     @staticmethod
-    def _bucket(x: int, buckets: List[int]) -> int:
-        return min(buckets, key=lambda b: abs(b - x))
+    def _grid_key(
+        op: str, cin: int, cout: int, k: int, stride: int, h: int, w: int, groups: int, rank: int
+    ) -> Tuple[Tuple, Tuple[float, ...]]:
+        hw = _log2(max(h, 1) * max(w, 1))
+        if groups > 1 and groups == cin == cout:
+            # Depthwise: groups tracks the channel count, so it is not a group key
+            return (op, k, stride, -1), (_log2(cout), hw)
+        if op.startswith("lowrank"):
+            return (op, k, stride, groups), (_log2(cin), _log2(cout), _log2(rank), hw)
+        return (op, k, stride, groups), (_log2(cin), _log2(cout), hw)
 
     def lookup(
         self,
@@ -62,33 +165,39 @@ class LatencyLUT:
         h: int,
         w: int,
         groups: int = 1,
+        rank: int = 0,
     ) -> Optional[float]:
-        exact_key = (op, cin, cout, k, stride, h, w, groups)
-        if exact_key in self._index:
-            return self._index[exact_key]
-
-        candidates = [
-            (key, v) for key, v in self._index.items()
-            if key[0] == op and key[3] == k and key[4] == stride and key[7] == groups
-        ]
-        if not candidates:
-            return None
-
-        def dist(key: Tuple) -> float:
-            dc_in = (math.log2(max(key[1], 1)) - math.log2(max(cin, 1))) ** 2
-            dc_out = (math.log2(max(key[2], 1)) - math.log2(max(cout, 1))) ** 2
-            dh = (math.log2(max(key[5], 1)) - math.log2(max(h, 1))) ** 2
-            dw = (math.log2(max(key[6], 1)) - math.log2(max(w, 1))) ** 2
-            return dc_in + dc_out + dh + dw
-
-        best_key, best_val = min(candidates, key=lambda kv: dist(kv[0]))
-
-        key_macs = best_key[1] * best_key[2] * best_key[5] * best_key[6]
-        query_macs = cin * cout * h * w
-        if key_macs > 0:
-            scale = query_macs / key_macs
-            return best_val * scale
-        return best_val
+        sig = (op, cin, cout, k, stride, h, w, groups, rank)
+        if sig in self._memo:
+            return self._memo[sig]
+        val = self._lookup(*sig)
+        self._memo[sig] = val
+        return val
+
+    def _lookup(
+        self, op: str, cin: int, cout: int, k: int, stride: int, h: int, w: int, groups: int, rank: int
+    ) -> Optional[float]:
+        exact = self._index.get((op, cin, cout, k, stride, h, w, groups, rank))
+        if exact is not None:
+            return exact
+
+        gkey, coords = self._grid_key(op, cin, cout, k, stride, h, w, groups, rank)
+        grid = self._grids.get(gkey)
+        if grid is not None:
+            log_eff = grid.interpolate(coords)
+            return math.exp(log_eff) * _macs(op, cin, cout, k, h, w, groups, rank)
+
+        dilated = _DILATED_OP.fullmatch(op)
+        if dilated:
+            # No dilated sweep in this LUT: the dense kernel is the closest shape
+            return self.lookup(dilated.group(1), cin, cout, k, stride, h, w, groups, rank)
+        if op.startswith("lowrank") and rank > 0:
+            # Unprofiled pair: time it as the two convs it runs as on stock ncnn
+            first = self.lookup(f"conv{k}x{k}", cin, rank, k, stride, h, w, groups)
+            second = self.lookup("conv1x1", rank, cout, 1, 1, h, w, 1)
+            if first is not None and second is not None:
+                return first + second
+        return None
 
     def lookup_with_fallback(
         self,
@@ -101,23 +210,34 @@ class LatencyLUT:
         w: int,
         groups: int = 1,
         macs_per_ms: float = 100_000_000.0,
+        rank: int = 0,
     ) -> float:
-        val = self.lookup(op, cin, cout, k, stride, h, w, groups)
+        val = self.lookup(op, cin, cout, k, stride, h, w, groups, rank)
         if val is not None:
             return val
 
         macs = 2 * cin * cout * k * k * h * w / (stride * stride)
         if groups > 1:
             macs = 2 * (cin // groups) * cout * k * k * h * w / (stride * stride)
+        if op.startswith("lowrank") and rank > 0:
+            macs = 2 * rank * (cin * k * k + cout) * h * w / (stride * stride)
         return macs / macs_per_ms
 
 
-def _get_op_type(m: nn.Conv2d) -> str:
+_CONV_TYPES = (nn.Conv2d, LowRankConv2d)
+
+
+def _get_op_type(m: nn.Module) -> str:
     k = m.kernel_size[0] if isinstance(m.kernel_size, tuple) else m.kernel_size
+    d = m.dilation[0] if isinstance(m.dilation, tuple) else m.dilation
+    if isinstance(m, LowRankConv2d):
+        return f"lowrank{k}x{k}"
     if m.groups > 1:
         return "conv2d_dw"
     if k == 1:
         return "conv1x1"
+    if d > 1:
+        return f"conv{k}x{k}_d{d}"
     if k == 3:
         return "conv3x3"
     return f"conv{k}x{k}"
@@ -140,7 +260,7 @@ def estimate_model_latency(
         return hook
 
     for name, m in model.named_modules():
-        if isinstance(m, nn.Conv2d):
+        if isinstance(m, _CONV_TYPES):
             handles.append(m.register_forward_hook(make_hook(name)))
 
     model.eval()
@@ -160,7 +280,7 @@ def estimate_model_latency(
     per_layer = []
 
     for name, m in model.named_modules():
-        if not isinstance(m, nn.Conv2d):
+        if not isinstance(m, _CONV_TYPES):
             continue
 
         cin = m.in_channels
@@ -177,9 +297,10 @@ def estimate_model_latency(
         else:
             h, w = hw
 
-        exact = lut.lookup(op, cin, cout, k, stride, h, w, groups)
-        layer_ms = lut.lookup_with_fallback(
-            op, cin, cout, k, stride, h, w, groups, macs_per_ms=macs_per_ms
+        rank = getattr(m, "rank", 0)
+        exact = lut.lookup(op, cin, cout, k, stride, h, w, groups, rank)
+        layer_ms = exact if exact is not None else lut.lookup_with_fallback(
+            op, cin, cout, k, stride, h, w, groups, macs_per_ms=macs_per_ms, rank=rank
         )
 
         if exact is not None:
@@ -253,7 +374,7 @@ def build_lut_from_model(
         return hook
 
     for name, m in model.named_modules():
-        if isinstance(m, nn.Conv2d):
+        if isinstance(m, _CONV_TYPES):
             handles.append(m.register_forward_hook(make_hook(name)))
 
     model.eval()
@@ -265,7 +386,7 @@ def build_lut_from_model(
 
     entries = []
     for name, m in model.named_modules():
-        if not isinstance(m, nn.Conv2d):
+        if not isinstance(m, _CONV_TYPES):
             continue
 
         cin = m.in_channels
@@ -296,7 +417,7 @@ def build_lut_from_model(
             torch.cuda.synchronize()
         elapsed = (time.perf_counter() - t0) / repeats * 1000.0
 
-        entries.append({
+        entry = {
             "op": op,
             "cin": cin,
             "cout": cout,
@@ -306,7 +427,10 @@ def build_lut_from_model(
             "w": w,
             "groups": groups,
             "latency_ms": round(elapsed, 4),
-        })
+        }
+        if isinstance(m, LowRankConv2d):
+            entry["rank"] = m.rank
+        entries.append(entry)
 
         if verbose:
             print(f"[profile] {name}: {op} {cin}->{cout} {h}x{w} → {elapsed:.3f} ms")
@@ -2,9 +2,10 @@ from __future__ import annotations
 
 import re
 from pathlib import Path
-from typing import Optional, Tuple
+from typing import Dict, Optional, Tuple
 
-from .types import ToolsConfig, DeviceConfig, PTQConfig, NcnnModelPaths
+from .ncnn_passes import fuse_lowrank_convs, sparsify_1x1_convs
+from .types import ToolsConfig, DeviceConfig, ExportConfig, PTQConfig, NcnnModelPaths
 from .runtime_backend import effective_ncnn_gpu_device
 from .utils import sh, ensure_dir
 
@@ -51,6 +52,61 @@ def _validate_ncnn_param(param: Path) -> None:
         )
 
 
+DETECTION_OUTPUT_LAYER = "YoloV8DetectionOutput"
+
+
+def append_yolo_detection_output(
+    param_text: str,
+    *,
+    output_blob: str = "out0",
+    num_class: int = 80,
+    conf_thresh: float = 0.25,
+    nms_thresh: float = 0.45,
+    max_det: int = 300,
+    mask_dim: int = 0,
+) -> str:
+    """Append the in-graph decode+NMS layer after a dense YOLO head.
+
+    The head blob is renamed to ``<output_blob>_raw`` and the new layer takes
+    over ``output_blob``, so runtimes keep extracting the same name and get
+    final [x1,y1,x2,y2,score,cls(,mask coeffs)] rows. The layer is a custom
+    one (Android app, cpp/yolo_detection_output.cpp): stock benchncnn cannot
+    load such a param. A param that already has the layer is returned as is.
+    """
+    lines = param_text.splitlines()
+    if len(lines) < 2 or lines[0].strip() != "7767517":
+        raise RuntimeError("NCNN param bad magic or missing header")
+    if any(ln.split()[:1] == [DETECTION_OUTPUT_LAYER] for ln in lines[2:]):
+        return param_text
+
+    n_layers, n_blobs = (int(x) for x in lines[1].split()[:2])
+    raw = f"{output_blob}_raw"
+    produced = False
+    body = []
+    for ln in lines[2:]:
+        parts = ln.split()
+        if len(parts) < 4:
+            body.append(ln)
+            continue
+        n_in, n_out = int(parts[2]), int(parts[3])
+        io_end = 4 + n_in + n_out
+        blobs = parts[4:io_end]
+        if output_blob in blobs:
+            produced = produced or output_blob in blobs[n_in:]
+            blobs = [raw if b == output_blob else b for b in blobs]
+            ln = " ".join(parts[:4] + blobs + parts[io_end:])
+        body.append(ln)
+    if not produced:
+        raise RuntimeError(f"NCNN param has no layer producing blob {output_blob!r}")
+
+    body.append(
+        f"{DETECTION_OUTPUT_LAYER:<24} {'detout':<24} 1 1 {raw} {output_blob} "
+        f"0={int(num_class)} 1={float(conf_thresh):g} 2={float(nms_thresh):g} "
+        f"3={int(max_det)} 4={int(mask_dim)}"
+    )
+    return "\n".join([lines[0], f"{n_layers + 1} {n_blobs + 1}", *body]) + "\n"
+
+
 class NcnnConverter:
     def __init__(self, tools: ToolsConfig):
         self.tools = tools
@@ -128,6 +184,59 @@ class NcnnConverter:
             shutil.copy2(ncnn.bin, opt_bin)
             return NcnnModelPaths(param=opt_param, bin=opt_bin)
 
+    def append_detection_output(self, ncnn: NcnnModelPaths, out_dir: Path, export: ExportConfig) -> NcnnModelPaths:
+        import shutil
+        ensure_dir(out_dir)
+        det_param = out_dir / "detout.param"
+        det_bin = out_dir / "detout.bin"
+        det_param.write_text(
+            append_yolo_detection_output(
+                ncnn.param.read_text(encoding="utf-8"),
+                output_blob=export.det_output_blob,
+                num_class=export.det_num_class,
+                conf_thresh=export.det_conf_thresh,
+                nms_thresh=export.det_nms_thresh,
+                max_det=export.det_max_det,
+                mask_dim=export.det_mask_dim,
+            ),
+            encoding="utf-8",
+        )
+        # The layer has no weights: the .bin is unchanged
+        shutil.copy2(ncnn.bin, det_bin)
+        _validate_ncnn_param(det_param)
+        return NcnnModelPaths(param=det_param, bin=det_bin)
+
+    @staticmethod
+    def _write_pass_output(
+        ncnn: NcnnModelPaths, out_dir: Path, stem: str, result: Tuple[str, bytes, Dict], changed: bool
+    ) -> Tuple[NcnnModelPaths, Dict]:
+        param_text, bin_bytes, report = result
+        if not changed:
+            return ncnn, report
+
+        ensure_dir(out_dir)
+        out_param = out_dir / f"{stem}.param"
+        out_bin = out_dir / f"{stem}.bin"
+        out_param.write_text(param_text, encoding="utf-8")
+        out_bin.write_bytes(bin_bytes)
+        _validate_ncnn_param(out_param)
+        return NcnnModelPaths(param=out_param, bin=out_bin), report
+
+    def sparsify_1x1(
+        self, ncnn: NcnnModelPaths, out_dir: Path, export: ExportConfig
+    ) -> Tuple[NcnnModelPaths, Dict]:
+        result = sparsify_1x1_convs(
+            ncnn.param.read_text(encoding="utf-8"),
+            ncnn.bin.read_bytes(),
+            max_density=export.sparse_max_density,
+            min_channels=export.sparse_min_channels,
+        )
+        return self._write_pass_output(ncnn, out_dir, "sparse", result, result[2]["converted"] > 0)
+
+    def fuse_lowrank(self, ncnn: NcnnModelPaths, out_dir: Path) -> Tuple[NcnnModelPaths, Dict]:
+        result = fuse_lowrank_convs(ncnn.param.read_text(encoding="utf-8"), ncnn.bin.read_bytes())
+        return self._write_pass_output(ncnn, out_dir, "lowrank", result, result[2]["fused"] > 0)
+
     def ptq_int8(self, ncnn: NcnnModelPaths, out_dir: Path, ptq: PTQConfig) -> NcnnModelPaths:
         ensure_dir(out_dir)
         table = out_dir / "calib.table"
@@ -0,0 +1,395 @@
+from __future__ import annotations
+
+"""Graph passes over converted NCNN models (.param text + .bin weights).
+
+The .bin has no index: every layer reads its weights sequentially in .param
+order, so a pass that rewrites one layer's weights has to know how many bytes
+every preceding layer consumes. ``weight_spans`` covers the layer types a YOLO
+export produces after ncnnoptimize / ncnn2int8; any other type that may carry
+weights makes the pass leave the model untouched instead of guessing.
+"""
+
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+
+import numpy as np
+
+NCNN_MAGIC = "7767517"
+
+_TAG_FP16 = 0x01306B47
+_TAG_INT8 = 0x000D4B38
+_TAG_RAW_SCALED = 0x0002C056
+
+# Types that never read from the .bin
+_WEIGHTLESS = {
+    "Input", "Split", "Concat", "Slice", "Crop", "Pooling", "Interp", "BinaryOp",
+    "UnaryOp", "Eltwise", "Sigmoid", "Swish", "ReLU", "Clip", "HardSwish",
+    "HardSigmoid", "Mish", "TanH", "ELU", "GELU", "SELU", "Softmax", "Reshape",
+    "Permute", "Flatten", "Dropout", "Noop", "Reduction", "ExpandDims", "Squeeze",
+    "Cast", "ShuffleChannel", "PixelShuffle", "Reorg", "DeepCopy", "Exp", "Log",
+    "Power", "Abs", "Threshold", "ArgMax", "MatMul", "Tile", "YoloV8DetectionOutput",
+}
+
+
+@dataclass
+class ParamLayer:
+    type: str
+    name: str
+    bottoms: List[str]
+    tops: List[str]
+    # key -> raw value token; array params keep their negative key (-23300 - id)
+    params: Dict[int, str] = field(default_factory=dict)
+
+    def get_int(self, key: int, default: int = 0) -> int:
+        v = self.params.get(key)
+        return int(float(v)) if v is not None else default
+
+    def get_float(self, key: int, default: float = 0.0) -> float:
+        v = self.params.get(key)
+        return float(v) if v is not None else default
+
+    def line(self) -> str:
+        io = " ".join([*self.bottoms, *self.tops])
+        kv = " ".join(f"{k}={v}" for k, v in self.params.items())
+        return " ".join(
+            x for x in (f"{self.type:<24} {self.name:<24} {len(self.bottoms)} {len(self.tops)}", io, kv) if x
+        )
+
+
+def parse_param(text: str) -> Tuple[List[ParamLayer], int]:
+    lines = [ln for ln in text.splitlines() if ln.strip()]
+    if len(lines) < 2 or lines[0].strip() != NCNN_MAGIC:
+        raise RuntimeError("NCNN param bad magic or missing header")
+    n_layers, n_blobs = (int(x) for x in lines[1].split()[:2])
+
+    layers: List[ParamLayer] = []
+    for ln in lines[2:]:
+        parts = ln.split()
+        n_in, n_out = int(parts[2]), int(parts[3])
+        io_end = 4 + n_in + n_out
+        params: Dict[int, str] = {}
+        for tok in parts[io_end:]:
+            k, _, v = tok.partition("=")
+            params[int(k)] = v
+        layers.append(
+            ParamLayer(parts[0], parts[1], parts[4:4 + n_in], parts[4 + n_in:io_end], params)
+        )
+    if len(layers) != n_layers:
+        raise RuntimeError(f"NCNN param truncated: header says {n_layers} layers, found {len(layers)}")
+    return layers, n_blobs
+
+
+def format_param(layers: List[ParamLayer], n_blobs: int) -> str:
+    return "\n".join([NCNN_MAGIC, f"{len(layers)} {n_blobs}", *(l.line() for l in layers)]) + "\n"
+
+
+def _align4(n: int) -> int:
+    return (n + 3) & ~3
+
+
+def _tagged_size(buf: bytes, off: int, w: int) -> int:
+    """Bytes taken by ModelBin::load(w, 0): 4-byte tag + payload."""
+    if off + 4 > len(buf):
+        raise RuntimeError("NCNN bin truncated")
+    tag = int.from_bytes(buf[off:off + 4], "little")
+    if tag == _TAG_FP16:
+        return 4 + _align4(w * 2)
+    if tag == _TAG_INT8:
+        return 4 + _align4(w)
+    if tag == _TAG_RAW_SCALED:
+        return 4 + w * 4
+    if sum(buf[off:off + 4]) != 0:
+        # 256-entry quantization table + uint8 indices
+        return 4 + 256 * 4 + _align4(w)
+    return 4 + w * 4
+
+
+def read_tagged_fp(buf: bytes, off: int, w: int) -> Optional[np.ndarray]:
+    """Decodes a tagged fp32/fp16 weight blob; None for int8/table formats."""
+    tag = int.from_bytes(buf[off:off + 4], "little")
+    if tag == _TAG_FP16:
+        return np.frombuffer(buf, dtype="<f2", count=w, offset=off + 4).astype(np.float32)
+    if tag == 0:
+        return np.frombuffer(buf, dtype="<f4", count=w, offset=off + 4).copy()
+    return None
+
+
+def _layer_size(layer: ParamLayer, buf: bytes, off: int) -> int:
+    t = layer.type
+    if t in _WEIGHTLESS:
+        return 0
+
+    if t in ("Convolution", "ConvolutionDepthWise", "Deconvolution", "DeconvolutionDepthWise", "InnerProduct"):
+        if t != "InnerProduct" and layer.get_int(19) != 0:
+            return 0  # dynamic weight comes from a second bottom blob
+        num_output = layer.get_int(0)
+        n = _tagged_size(buf, off, layer.get_int(6))
+        if layer.get_int(5):
+            n += num_output * 4
+        int8 = layer.get_int(8) if t in ("Convolution", "ConvolutionDepthWise", "InnerProduct") else 0
+        if int8:
+            if t == "ConvolutionDepthWise":
+                n += (layer.get_int(7, 1) if int8 in (1, 101) else 1) * 4 + 4
+            else:
+                n += num_output * 4 + 4
+            if int8 > 100 and t != "InnerProduct":
+                n += 4
+        return n
+
+    if t == "LowRankConvolution":
+        rank, num_output = layer.get_int(20), layer.get_int(0)
+        kw = layer.get_int(1, 1)
+        n = rank * layer.get_int(21) * kw * layer.get_int(11, kw) + num_output * rank
+        return (n + (num_output if layer.get_int(5) else 0)) * 4
+    if t == "SparseConvolution1x1":
+        num_output = layer.get_int(0)
+        n = (num_output + 1) * 4 + layer.get_int(2) * 8
+        return n + (num_output * 4 if layer.get_int(5) else 0)
+    if t == "BatchNorm":
+        return layer.get_int(0) * 4 * 4
+    if t == "Scale":
+        size = layer.get_int(0)
+        if size == -233:
+            return 0
+        return size * 4 * (2 if layer.get_int(1) else 1)
+    if t == "PReLU":
+        return layer.get_int(0) * 4
+    if t == "Padding":
+        return layer.get_int(6) * 4
+    if t == "MemoryData":
+        dims = [layer.get_int(k) for k in (0, 1, 11, 2)]
+        n = 1
+        for d in dims:
+            n *= max(d, 1)
+        return n * 4
+
+    raise RuntimeError(f"NCNN layer type {t!r} ({layer.name}) has unknown weight layout")
+
+
+def weight_spans(layers: List[ParamLayer], bin_bytes: bytes) -> List[Tuple[int, int]]:
+    """(offset, size) of every layer's weights in the .bin, in layer order."""
+    spans: List[Tuple[int, int]] = []
+    off = 0
+    for layer in layers:
+        n = _layer_size(layer, bin_bytes, off)
+        spans.append((off, n))
+        off += n
+    if off != len(bin_bytes):
+        raise RuntimeError(f"NCNN bin size mismatch: layers consume {off} bytes, file has {len(bin_bytes)}")
+    return spans
+
+
+def _plain_conv(layer: ParamLayer) -> bool:
+    """fp Convolution with static weights and a Convolution-compatible activation."""
+    return (
+        layer.type == "Convolution"
+        and layer.get_int(8) == 0
+        and layer.get_int(19) == 0
+        and layer.get_int(9) in range(0, 7)
+    )
+
+
+def _is_pointwise(layer: ParamLayer) -> bool:
+    kw = layer.get_int(1, 0)
+    if kw != 1 or layer.get_int(11, kw) != 1:
+        return False
+    dw = layer.get_int(2, 1)
+    sw = layer.get_int(3, 1)
+    if dw != 1 or layer.get_int(12, dw) != 1 or sw != 1 or layer.get_int(13, sw) != 1:
+        return False
+    pad = layer.get_int(4, 0)
+    if pad not in (0, -233, -234):
+        return False
+    if any(layer.get_int(k, pad) not in (0, -233, -234) for k in (14, 15, 16)):
+        return False
+    return True
+
+
+def _sparse_1x1_eligible(layer: ParamLayer) -> bool:
+    return _plain_conv(layer) and _is_pointwise(layer)
+
+
+def sparsify_1x1_convs(
+    param_text: str,
+    bin_bytes: bytes,
+    *,
+    max_density: float = 0.35,
+    min_channels: int = 16,
+) -> Tuple[str, bytes, Dict]:
+    """Swap fp32/fp16 1x1 Convolutions with density <= max_density for
+    SparseConvolution1x1 (CSR weights, Android app cpp/sparse_conv1x1.hpp).
+
+    The default max_density is an unmeasured placeholder (see
+    ExportConfig.sparse_max_density), not a measured CSR/dense crossover.
+
+    Returns the new param text, bin bytes and a report. When nothing qualifies
+    or the .bin cannot be walked, the inputs come back unchanged and the report
+    says why.
+    """
+    layers, n_blobs = parse_param(param_text)
+    report: Dict = {"converted": 0, "eligible": 0, "nnz": 0, "dense_params": 0, "layers": []}
+    try:
+        spans = weight_spans(layers, bin_bytes)
+    except RuntimeError as e:
+        report["skipped"] = str(e)
+        return param_text, bin_bytes, report
+
+    chunks: List[bytes] = []
+    for i, (layer, (off, size)) in enumerate(zip(layers, spans)):
+        chunk = bin_bytes[off:off + size]
+        if not _sparse_1x1_eligible(layer):
+            chunks.append(chunk)
+            continue
+
+        num_output = layer.get_int(0)
+        wsize = layer.get_int(6)
+        num_input = wsize // max(num_output, 1)
+        weights = read_tagged_fp(bin_bytes, off, wsize)
+        if weights is None or num_output < min_channels or num_input < min_channels:
+            chunks.append(chunk)
+            continue
+
+        report["eligible"] += 1
+        w = weights.reshape(num_output, num_input)
+        nz = w != 0
+        nnz = int(nz.sum())
+        density = nnz / float(wsize)
+        if density > max_density:
+            chunks.append(chunk)
+            continue
+
+        row_ptr = np.zeros(num_output + 1, dtype="<i4")
+        row_ptr[1:] = np.cumsum(nz.sum(axis=1))
+        rows, cols = np.nonzero(nz)
+        csr = [row_ptr.tobytes(), cols.astype("<i4").tobytes(), w[rows, cols].astype("<f4").tobytes()]
+        if layer.get_int(5):
+            tag_size = _tagged_size(bin_bytes, off, wsize)
+            csr.append(bin_bytes[off + tag_size:off + tag_size + num_output * 4])
+        chunks.append(b"".join(csr))
+
+        params = {0: str(num_output), 1: str(num_input), 2: str(nnz), 5: str(layer.get_int(5))}
+        if layer.get_int(9):
+            params[9] = str(layer.get_int(9))
+        if -23310 in layer.params:
+            params[-23310] = layer.params[-23310]
+        layers[i] = ParamLayer("SparseConvolution1x1", layer.name, layer.bottoms, layer.tops, params)
+
+        report["converted"] += 1
+        report["nnz"] += nnz
+        report["dense_params"] += wsize
+        report["layers"].append({"name": layer.name, "shape": [num_output, num_input], "density": round(density, 4)})
+
+    if report["converted"] == 0:
+        return param_text, bin_bytes, report
+    return format_param(layers, n_blobs), b"".join(chunks), report
+
+
+_CONV_GEOMETRY_KEYS = (1, 11, 2, 12, 3, 13, 4, 15, 14, 16, 18)
+
+
+def _explicit_pads(layer: ParamLayer) -> bool:
+    pl = layer.get_int(4, 0)
+    pt = layer.get_int(14, pl)
+    return min(pl, layer.get_int(15, pl), pt, layer.get_int(16, pt)) >= 0
+
+
+def fuse_lowrank_convs(param_text: str, bin_bytes: bytes) -> Tuple[str, bytes, Dict]:
+    """Fuse LowRankConv2d pairs (KxK conv to rank channels feeding only a 1x1
+    conv) into one LowRankConvolution (Android app cpp/lowrank_conv.hpp).
+
+    A bias on the first factor is folded through the second. Returns the new
+    param text, bin bytes and a report; inputs come back unchanged when there
+    is nothing to fuse or the .bin cannot be walked.
+    """
+    layers, n_blobs = parse_param(param_text)
+    report: Dict = {"fused": 0, "layers": []}
+    try:
+        spans = weight_spans(layers, bin_bytes)
+    except RuntimeError as e:
+        report["skipped"] = str(e)
+        return param_text, bin_bytes, report
+
+    consumers: Dict[str, List[int]] = {}
+    for i, layer in enumerate(layers):
+        for b in layer.bottoms:
+            consumers.setdefault(b, []).append(i)
+
+    replaced: Dict[int, Tuple[ParamLayer, bytes]] = {}
+    dropped: set = set()
+    for i, a in enumerate(layers):
+        if i in dropped or i in replaced:
+            continue
+        if not (_plain_conv(a) and a.get_int(9) == 0 and len(a.tops) == 1 and _explicit_pads(a)):
+            continue
+        users = consumers.get(a.tops[0], [])
+        if len(users) != 1:
+            continue
+        j = users[0]
+        b = layers[j]
+        if j in replaced or not (_sparse_1x1_eligible(b) and len(b.bottoms) == 1):
+            continue
+
+        rank = a.get_int(0)
+        ksize = a.get_int(1, 0) * a.get_int(11, a.get_int(1, 0))
+        u_size = a.get_int(6)
+        num_input = u_size // max(rank * ksize, 1)
+        num_output = b.get_int(0)
+        if b.get_int(6) != num_output * rank or rank >= min(num_input * ksize, num_output):
+            continue
+
+        u = read_tagged_fp(bin_bytes, spans[i][0], u_size)
+        v = read_tagged_fp(bin_bytes, spans[j][0], b.get_int(6))
+        if u is None or v is None:
+            continue
+        v = v.reshape(num_output, rank)
+
+        bias = np.zeros(num_output, dtype=np.float32)
+        has_bias = False
+        if b.get_int(5):
+            off = spans[j][0] + _tagged_size(bin_bytes, spans[j][0], b.get_int(6))
+            bias += np.frombuffer(bin_bytes, "<f4", num_output, off)
+            has_bias = True
+        if a.get_int(5):
+            off = spans[i][0] + _tagged_size(bin_bytes, spans[i][0], u_size)
+            bias += v @ np.frombuffer(bin_bytes, "<f4", rank, off)
+            has_bias = True
+
+        params: Dict[int, str] = {0: str(num_output)}
+        for k in _CONV_GEOMETRY_KEYS:
+            if k in a.params:
+                params[k] = a.params[k]
+        params[5] = "1" if has_bias else "0"
+        if b.get_int(9):
+            params[9] = str(b.get_int(9))
+        if -23310 in b.params:
+            params[-23310] = b.params[-23310]
+        params[20] = str(rank)
+        params[21] = str(num_input)
+
+        blob = [u.astype("<f4").tobytes(), v.astype("<f4").tobytes()]
+        if has_bias:
+            blob.append(bias.astype("<f4").tobytes())
+        replaced[i] = (ParamLayer("LowRankConvolution", a.name, a.bottoms, b.tops, params), b"".join(blob))
+        dropped.add(j)
+
+        report["fused"] += 1
+        report["layers"].append(
+            {"name": a.name, "second": b.name, "rank": rank, "shape": [num_output, num_input, ksize]}
+        )
+
+    if not replaced:
+        return param_text, bin_bytes, report
+
+    out_layers: List[ParamLayer] = []
+    chunks: List[bytes] = []
+    for i, (layer, (off, size)) in enumerate(zip(layers, spans)):
+        if i in dropped:
+            continue
+        if i in replaced:
+            layer, chunk = replaced[i]
+        else:
+            chunk = bin_bytes[off:off + size]
+        out_layers.append(layer)
+        chunks.append(chunk)
+    # Each fusion removes the intermediate blob
+    return format_param(out_layers, n_blobs - len(dropped)), b"".join(chunks), report
@@ -0,0 +1,92 @@
+from __future__ import annotations
+
+"""Runs android_native/op_profiler (xtrim_op_profiler) and returns the LUT it
+writes. The JSON has the schema LatencyLUT loads, measured with the app's
+ncnn Option profile, either on this host or on a phone over adb."""
+
+import json
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+from .types import DeviceConfig, ToolsConfig
+from .utils import ensure_dir, sh
+
+REMOTE_BIN = "/data/local/tmp/xtrim_op_profiler"
+REMOTE_OUT = "/data/local/tmp/xtrim_op_lut.json"
+
+
+@dataclass(frozen=True)
+class OpSweep:
+    ops: List[str] = field(
+        default_factory=lambda: ["conv1x1", "conv3x3", "conv3x3_s2", "dw3x3", "dw3x3_s2", "conv3x3_d2", "lowrank3x3"]
+    )
+    channels: List[int] = field(default_factory=lambda: [16, 32, 64, 128, 256])
+    sizes: List[int] = field(default_factory=lambda: [20, 40, 80, 160])
+    ranks: List[int] = field(default_factory=lambda: [8, 16, 32])
+    profile: str = "optimized"
+    warmup: int = 5
+    loops: int = 20
+
+
+def profiler_args(sweep: OpSweep, *, out: str, device_name: str, threads: int, powersave: int = 0) -> List[str]:
+    return [
+        "--out", out,
+        "--device", device_name,
+        "--profile", sweep.profile,
+        "--threads", str(int(threads)),
+        "--powersave", str(int(powersave)),
+        "--warmup", str(int(sweep.warmup)),
+        "--loops", str(int(sweep.loops)),
+        "--ops", ",".join(sweep.ops),
+        "--channels", ",".join(str(int(c)) for c in sweep.channels),
+        "--sizes", ",".join(str(int(s)) for s in sweep.sizes),
+        "--ranks", ",".join(str(int(r)) for r in sweep.ranks),
+    ]
+
+
+def _load_lut(path: Path) -> Dict[str, Any]:
+    data = json.loads(path.read_text(encoding="utf-8"))
+    if not isinstance(data, dict) or not data.get("entries"):
+        raise RuntimeError(f"op profiler wrote no LUT entries: {path}")
+    return data
+
+
+class OpProfiler:
+    def __init__(self, tools: ToolsConfig):
+        self.tools = tools
+
+    def adb(self, serial: str, *args: str) -> str:
+        return sh([self.tools.adb, "-s", serial, *args])
+
+    def run_local(
+        self,
+        out_json: Path,
+        sweep: OpSweep = OpSweep(),
+        *,
+        binary: Optional[str] = None,
+        device_name: str = "local_cpu",
+        threads: int = 4,
+    ) -> Dict[str, Any]:
+        exe = Path(binary or self.tools.op_profiler_local)
+        if not exe.exists():
+            raise RuntimeError(f"op profiler binary not found: {exe}")
+        ensure_dir(out_json.parent)
+        sh([str(exe), *profiler_args(sweep, out=str(out_json), device_name=device_name, threads=threads)])
+        return _load_lut(out_json)
+
+    def run_on_device(self, device: DeviceConfig, out_json: Path, sweep: OpSweep = OpSweep()) -> Dict[str, Any]:
+        local = Path(self.tools.op_profiler_local)
+        if not local.exists():
+            raise RuntimeError(f"op profiler binary not found locally: {local}")
+        self.adb(device.serial, "push", str(local), REMOTE_BIN)
+        self.adb(device.serial, "shell", f"chmod +x {REMOTE_BIN}")
+
+        args = profiler_args(
+            sweep, out=REMOTE_OUT, device_name=device.name, threads=device.threads, powersave=device.powersave
+        )
+        self.adb(device.serial, "shell", " ".join([REMOTE_BIN, *args]))
+
+        ensure_dir(out_json.parent)
+        self.adb(device.serial, "pull", REMOTE_OUT, str(out_json))
+        return _load_lut(out_json)
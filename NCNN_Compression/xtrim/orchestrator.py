@@ -114,6 +114,9 @@ class XTrimOrchestrator:
 
         cache_path = self.out_root / self.latency_cfg.cache_file
         self.cache = BenchCache(cache_path)
+        # mAP50-95 measured by the Android app on the last benched NCNN model
+        # (android_app.eval_map), per device name.
+        self._device_acc: Dict[str, float] = {}
 
         self.policy = SearchPolicy.create(search_cfg, search_space)
 
@@ -331,6 +334,12 @@ class XTrimOrchestrator:
                 extra["ncnn_source"] = "onnx_fp32"
 
             ncnn_final = self.converter.optimize(ncnn_float, ncnn_dir / "opt")
+            # Same head as the candidates, so baseline latency includes decode+NMS too
+            if self.export_cfg.ncnn_detection_output and backend == "android_app":
+                det_export = self._detection_output_export()
+                ncnn_final = self.converter.append_detection_output(ncnn_final, ncnn_dir / "detout", det_export)
+                extra["ncnn_detection_output"] = True
+                extra["ncnn_detection_output_conf"] = float(det_export.det_conf_thresh)
             size_bytes = int(sizeof_file(ncnn_final.param) + sizeof_file(ncnn_final.bin))
             latency_ms = self._bench_latency(ncnn_final.param, ncnn_final.bin, run_dir)
             extra["deploy_backend"] = "ncnn"
@@ -374,6 +383,19 @@ class XTrimOrchestrator:
             remote_subdir=remote_subdir,
         )
 
+    def _detection_output_export(self) -> ExportConfig:
+        """Export settings for the in-graph YoloV8DetectionOutput layer.
+
+        With eval_map the app scores mAP on what the graph returns, so the graph
+        must not cut boxes above eval_conf. Latency of such a run then includes
+        NMS over the low-confidence boxes as well.
+        """
+        cfg = self.export_cfg
+        app = self.android_app_bench_cfg
+        if app.eval_map and float(app.eval_conf) < float(cfg.det_conf_thresh):
+            return dataclasses.replace(cfg, det_conf_thresh=float(app.eval_conf))
+        return cfg
+
     @staticmethod
     def _android_dataset_cache_suffix(
         *,
@@ -492,6 +514,7 @@ class XTrimOrchestrator:
 
     def _bench_devices_with_android_app(self, ncnn_param: Path, ncnn_bin: Path, run_dir: Path) -> Dict[str, float]:
         latency_ms: Dict[str, float] = {}
+        self._device_acc = {}
         if not self.devices:
             return latency_ms
 
@@ -522,15 +545,49 @@ class XTrimOrchestrator:
             seed=self.android_app_bench_cfg.dataset_seed,
         )
 
+        # The resident server times the net forward only: keep its numbers apart
+        on_server = self.android_app.uses_bench_server
+        task = self.android_app_bench_cfg.task
+        tile = int(self.android_app_bench_cfg.tile)
+        # Overlap sets the tile count, workers the threads, tile_full adds a whole-frame pass
+        tile_key = ""
+        if tile > 0:
+            tile_key = (
+                f"|tile={tile}|tile_overlap={float(self.android_app_bench_cfg.tile_overlap):g}"
+                f"|tile_workers={int(self.android_app_bench_cfg.tile_workers)}"
+                f"|tile_full={int(bool(self.android_app_bench_cfg.tile_full))}"
+            )
+        # Batched avg_ms is wall time / batch with letterboxing overlapped: not batch=1 latency
+        batch = int(self.android_app_bench_cfg.batch)
+        batch_workers = int(self.android_app_bench_cfg.batch_workers)
+        # Frames from the tensor cache are already letterboxed: avg_ms has no preprocessing.
+        # The app only uses it for plain batch=1 detect runs on the pushed subset.
+        tensor_cache = (
+            bool(self.android_app_bench_cfg.tensor_cache)
+            and bool(self.android_app_bench_cfg.push_dataset_images)
+            and not on_server
+            and task == "detect"
+            and batch <= 1
+            and tile <= 0
+        )
+
         for d in self.devices:
             model_hash = self._hash_ncnn_model(ncnn_param, ncnn_bin)
             key = self._cache_key(
                 d,
                 model_hash,
-                shape=f"android_app_imgsz={self.android_app_bench_cfg.imgsz}|{dataset_key}",
+                shape=f"android_app_imgsz={self.android_app_bench_cfg.imgsz}|{dataset_key}"
+                + ("|fast_swish" if self.android_app_bench_cfg.fast_swish else "")
+                + ("|bench_server" if on_server else "")
+                + (f"|task={task}" if task != "detect" else "")
+                + tile_key
+                + (f"|batch={batch}|bw={batch_workers}" if batch > 1 else "")
+                + ("|tensor_cache" if tensor_cache else ""),
             )
 
-            if self.latency_cfg.use_cache and (not self.latency_cfg.force_rebench):
+            # The cache only stores latency, so an accuracy run always goes to the device.
+            use_cache = self.latency_cfg.use_cache and not self.android_app_bench_cfg.eval_map
+            if use_cache and (not self.latency_cfg.force_rebench):
                 hit = self.cache.get(key)
                 if hit is not None:
                     latency_ms[d.name] = float(hit.avg_ms)
@@ -560,6 +617,8 @@ class XTrimOrchestrator:
             avg = float(data["avg_ms"])
             latency_ms[d.name] = avg
             self.cache.set(key, avg)
+            if "map50_95" in data:
+                self._device_acc[d.name] = float(data["map50_95"])
 
         return latency_ms
 
@@ -1104,10 +1163,46 @@ class XTrimOrchestrator:
                     ncnn_final = self.converter.ptq_int8(ncnn_opt, ncnn_dir / "int8", ptq_cfg_resolved)
                     extra["ncnn_source"] = "ncnn_int8"
 
+                if self.export_cfg.ncnn_fuse_lowrank:
+                    if backend == "android_app":
+                        ncnn_final, lowrank_report = self.converter.fuse_lowrank(ncnn_final, ncnn_dir / "lowrank")
+                        extra["ncnn_fuse_lowrank"] = lowrank_report
+                    else:
+                        extra["ncnn_fuse_lowrank_skipped"] = f"backend={backend} cannot load custom layers"
+
+                if self.export_cfg.ncnn_sparse_1x1:
+                    if backend == "android_app":
+                        ncnn_final, sparse_report = self.converter.sparsify_1x1(
+                            ncnn_final, ncnn_dir / "sparse", self.export_cfg
+                        )
+                        extra["ncnn_sparse_1x1"] = sparse_report
+                    else:
+                        extra["ncnn_sparse_1x1_skipped"] = f"backend={backend} cannot load custom layers"
+
+                if self.export_cfg.ncnn_detection_output:
+                    if backend == "android_app":
+                        det_export = self._detection_output_export()
+                        ncnn_final = self.converter.append_detection_output(
+                            ncnn_final, ncnn_dir / "detout", det_export
+                        )
+                        extra["ncnn_detection_output"] = True
+                        extra["ncnn_detection_output_conf"] = float(det_export.det_conf_thresh)
+                    else:
+                        extra["ncnn_detection_output_skipped"] = f"backend={backend} cannot load custom layers"
+
                 size_bytes = int(sizeof_file(ncnn_final.param) + sizeof_file(ncnn_final.bin))
                 latency_ms = self._bench_latency(ncnn_final.param, ncnn_final.bin, run_dir)
                 extra["deploy_backend"] = "ncnn"
 
+                # On-device mAP of the exact NCNN artifact (fp16/int8 kernels included)
+                # replaces the host ONNX estimate, so Pareto sees what the phone runs.
+                if backend == "android_app" and self._device_acc:
+                    extra["acc_device_map50_95"] = dict(self._device_acc)
+                    deploy_acc = float(sum(self._device_acc.values()) / len(self._device_acc))
+                    deploy_acc_source = "android_ncnn_map50_95"
+                    extra["acc_deploy"] = deploy_acc
+                    extra["acc_deploy_source"] = deploy_acc_source
+
         if self.android_demo_cfg.enabled and ncnn_final is not None:
             try:
                 for d in self.devices:
@@ -31,6 +31,29 @@ class ExportConfig:
     opset: int = 12
     dynamo: bool = False
     bench_shape: str = "[640,640,3]"
+    # Append the in-graph YoloV8DetectionOutput layer (decode + NMS) to the final
+    # NCNN param. Only the Android app registers that layer, so it is applied
+    # for latency.backend=android_app only. With android_app.eval_map the graph is
+    # written with conf_thresh=eval_conf instead, so device mAP sees all boxes.
+    ncnn_detection_output: bool = False
+    det_output_blob: str = "out0"
+    det_num_class: int = 80
+    det_conf_thresh: float = 0.25
+    det_nms_thresh: float = 0.45
+    det_max_det: int = 300
+    det_mask_dim: int = 0
+    # Rewrite fp32/fp16 1x1 convs whose weight density is <= sparse_max_density
+    # into SparseConvolution1x1 (CSR). Android app only, like the layer above.
+    # The break-even density against ncnn's packed dense 1x1 depends on the
+    # SoC. 0.35 is an unmeasured placeholder, not a profiled crossover: time
+    # the exported model with ncnn_sparse_1x1 on and off on the target device
+    # before relying on it.
+    ncnn_sparse_1x1: bool = False
+    sparse_max_density: float = 0.35
+    sparse_min_channels: int = 16
+    # Fuse LowRankConv2d factor pairs (KxK conv -> 1x1 conv) into one
+    # LowRankConvolution layer. Android app only.
+    ncnn_fuse_lowrank: bool = False
 
 
 @dataclass(frozen=True)
@@ -55,6 +78,8 @@ class ToolsConfig:
     ncnn2int8: str = "ncnn2int8"
     benchncnn_local: str = "benchncnn"
     yolo_detect_local: str = "android_native/build-android/bin/xtrim_yolo_detect"
+    op_profiler_local: str = "android_native/build-android/bin/xtrim_op_profiler"
+    bench_server_local: str = "android_native/build-android/bin/xtrim_bench_server"
 
 
 @dataclass(frozen=True)
@@ -314,6 +339,47 @@ class AndroidAppBenchConfig:
     iou: float = 0.45
     max_det: int = 100
     optimized: bool = True
+    # Load the model with Swish routed to the app's FastSwish layer (polynomial
+    # sigmoid, near-exact), instead of rewriting Swish to HardSwish/ReLU.
+    fast_swish: bool = False
+    # batch > 1 makes the NCNN bench call the native batch API: `batch` images
+    # per JNI call, letterboxed on `batch_workers` threads. avg_ms stays per image.
+    # The bench server runs the same batch mode on synthetic frames.
+    batch: int = 1
+    batch_workers: int = 2
+    # eval_map runs the NCNN engine once more over the pushed subset and scores it
+    # against the pushed YOLO labels (needs push_dataset_images). eval_conf is the
+    # low score threshold used for that pass, as in COCO validation.
+    eval_map: bool = False
+    eval_conf: float = 0.001
+    num_classes: int = 80
+    # tensor_cache keeps the pushed subset on the device as one memory-mapped file
+    # of letterboxed frames per imgsz (remote_dir/tensor_cache_subdir), keyed by
+    # the subset hash. Later launches skip JPEG decoding. Needs push_dataset_images.
+    tensor_cache: bool = False
+    tensor_cache_subdir: str = "xtrim_tensor_cache"
+    # bench_server keeps xtrim_bench_server (android_native/bench_server) running
+    # on the device and sends load/bench/unload over an adb-forwarded socket
+    # instead of launching the activity per candidate. It times the net forward
+    # only (no JPEG decode or app-side postprocessing), so its results are
+    # cached separately. eval_map runs still go through the app.
+    bench_server: bool = False
+    bench_server_port: int = 7700
+    bench_server_start_timeout_sec: float = 10.0
+    # task="seg" benches the YOLOv11-seg engine in CliBenchActivity and reports
+    # preprocess/inference/decode/masks stage times. seg_masks is "full",
+    # "coarse" (proto-resolution masks) or "none" (boxes only). Seg runs always
+    # go through the app, never the bench server.
+    task: str = "detect"
+    seg_masks: str = "full"
+    # tile > 0 benches SAHI-style tiled detection on the full-resolution images:
+    # overlapping tiles of `tile` source pixels (tile_overlap shared with the
+    # neighbour) run on tile_workers threads sharing one net, plus the whole
+    # image when tile_full. Always goes through the app.
+    tile: int = 0
+    tile_overlap: float = 0.2
+    tile_workers: int = 2
+    tile_full: bool = True
     result_tag: str = "XTRIM_RESULT"
     timeout_sec: int = 180
     poll_interval_sec: float = 0.6